@@ -166,6 +166,8 @@ public:
 		// model = load_obj("tests/cube.obj");
 		triangle = load_triangle();
 		floor = load_floor();
+		renderer->upload_mesh(*triangle);
+		renderer->upload_mesh(*floor);
 
         camera->set_perspective(60, 1.6F, 0.0F, 1000.0F);
 		camera->transform->position = rge::vec3(0, 1, 0);
@@ -174,6 +176,8 @@ public:
 		renderer->set_ambience(rge::color(0.2F, 0.2F, 0.2F));
 
 		material->texture = rge::texture::load("floor.png");
+		material->texture->filter = rge::texture_filter::TRILINEAR;
+		material->texture->generate_mipmaps();
 		renderer->upload_texture(*material->texture);
 
 		turn_action.add_binding(rge::input::KEY_LEFT, -1.0F);
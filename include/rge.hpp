@@ -37,6 +37,7 @@ SOFTWARE.
 
 #include <cstdint>
 #include <cstdarg>
+#include <cstdio>
 #include <cmath>
 #include <cstring>
 #include <string>
@@ -50,6 +51,11 @@ SOFTWARE.
 #include <unordered_map>
 #include <memory>
 #include <type_traits>
+#include <fstream>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 
 #define RGE_BIND_EVENT_HANDLER(fn, T) [this](const T& e) -> bool { return this->fn(e); }
@@ -86,6 +92,7 @@ class transform;
 class camera;
 class light;
 class mesh;
+class pak;
 class texture;
 class material;
 class sprite;
@@ -298,6 +305,9 @@ struct mat4 final {
 	vec3 extract_up_axis() const;
 	vec3 extract_forward_axis() const;
 
+	// Returns the inverse, or zero if the matrix is singular.
+	mat4 inverse() const;
+
 	vec4 operator * (const vec4& rhs) const;
 	mat4 operator * (const mat4& rhs) const;
 };
@@ -359,6 +369,9 @@ namespace math {
 
 	// Returns largest integer.
 	inline int max(int a, int b) { return a > b ? a : b; }
+
+	// Returns integer limited to the range [lo, hi].
+	inline int clamp(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
 }
 //********************************************//
 //* Math Module                              *//
@@ -603,6 +616,24 @@ private:
 #pragma endregion
 
 
+#pragma region /* rge::jobs */
+//********************************************//
+//* Jobs Module                              *//
+//********************************************//
+namespace jobs {
+	// Returns number of threads used by parallel_for (workers + calling thread).
+	int get_thread_count();
+
+	// Splits [0, count) into ranges of at least min_batch & runs them across worker threads.
+	// Blocks until every range is complete. Runs inline if called from within a job.
+	void parallel_for(int count, int min_batch, const std::function<void(int begin, int end)>& job);
+}
+//********************************************//
+//* Jobs Module                              *//
+//********************************************//
+#pragma endregion
+
+
 #pragma region /* rge::event */
 //********************************************//
 //* Event Base Class                         *//
@@ -960,11 +991,23 @@ public:
 	mesh();
 	~mesh();
 
+	// Returns true if the mesh is compiled on gpu.
+	bool is_on_gpu() const;
+
 public:
 	std::vector<rge::vec3> vertices;
 	std::vector<int> triangles;
 	std::vector<rge::vec3> normals;
 	std::vector<rge::vec2> uvs;
+
+	#ifdef RGE_IMPL
+public:
+	#else
+private:
+	#endif
+
+	uint32_t handle; // For GPU ref
+	// ==Internal Members==
 };
 //********************************************//
 //* Mesh Class                               *//
@@ -972,6 +1015,108 @@ public:
 #pragma endregion
 
 
+#pragma region /* rge::pak */
+//********************************************//
+//* Packed Asset Archive Class               *//
+//********************************************//
+class pak final {
+public:
+	typedef std::shared_ptr<pak> ptr;
+
+	static const uint32_t MAGIC = 0x4B415052; // "RPAK"
+	static const uint32_t VERSION = 1;
+	static const uint32_t PAGE_SIZE = 4096;
+	static const uint32_t FLAG_COMPRESSED = 1;
+
+	// Laid out at the very start of the file.
+	struct header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entry_count;
+		uint32_t reserved;
+		uint64_t toc_offset;   // Sorted by hash.
+		uint64_t names_offset; // Null terminated paths.
+	};
+
+	struct entry {
+		uint64_t hash;
+		uint64_t offset;      // Page aligned, from start of file.
+		uint64_t size;        // Uncompressed size.
+		uint64_t stored_size; // Size within the archive.
+		uint32_t name_offset;
+		uint32_t flags;
+	};
+
+public:
+	// Opens & memory maps an archive file.
+	static pak::ptr open(const std::string& path);
+
+	// Packs every file under a directory into a single archive. Entry paths are relative to directory, joined to prefix.
+	static rge::result build(const std::string& directory, const std::string& output, bool compress = false, const std::string& prefix = "");
+
+	// Mounts an archive so asset loaders look inside it before the file system.
+	// Mounting & finding are safe from any thread.
+	static rge::result mount(const std::string& path);
+
+	// Unmounts all previously mounted archives. Data found before stays valid
+	// while its archive is read.
+	static void unmount_all();
+
+	// Searches mounted archives for a path. Compressed entries are decompressed into scratch.
+	static bool find(const std::string& path, const uint8_t*& data, size_t& size, std::vector<uint8_t>& scratch);
+
+	// Returns the 64-bit FNV-1a hash of a normalized asset path.
+	static uint64_t hash(const std::string& path);
+
+	// Only use if needed. Prefer open() instead
+	pak();
+	~pak();
+
+	// Returns true if an entry exists for path.
+	bool contains(const std::string& path) const;
+
+	// Returns pointer to entry data within the mapped file, or within scratch if compressed.
+	const uint8_t* read(const std::string& path, size_t& size, std::vector<uint8_t>& scratch) const;
+
+	// Returns number of entries stored in archive.
+	int get_entry_count() const;
+
+	// ==Internal Members==
+private:
+	static uint64_t hash_normalized(const std::string& path);
+
+	// Returns the entry of a normalized path & its hash, checking the stored
+	// path of every entry sharing the hash.
+	const entry* find_entry(const std::string& path, uint64_t h) const;
+
+	// Returns the stored path of an entry, null if it is not a terminated
+	// string within the names table.
+	const char* get_entry_name(const entry& e) const;
+
+	const uint8_t* read_entry(const entry& e, const std::string& path, size_t& size, std::vector<uint8_t>& scratch) const;
+
+	const uint8_t* mapped;
+	size_t mapped_size;
+	const header* head;
+	const entry* toc;
+	const char* names;
+	size_t names_size;
+
+	#ifdef SYS_WINDOWS
+	void* file_handle;
+	void* map_handle;
+	#endif
+
+	static std::vector<pak::ptr> mounted;
+	static std::mutex mounted_mutex;
+	// ==Internal Members==
+};
+//********************************************//
+//* Packed Asset Archive Class               *//
+//********************************************//
+#pragma endregion
+
+
 #pragma region /* rge::texture */
 //********************************************//
 //* Texture Class                            *//
@@ -979,15 +1124,54 @@ public:
 enum class texture_filter {
 	NEAREST = 0,
 	BILINEAR = 1,
-	// TRILINEAR = 2
+	TRILINEAR = 2 // Bilinear, blended between mip levels.
+};
+enum class mip_filter {
+	BOX = 0,
+	KAISER = 1
+};
+enum class texture_format {
+	RGBA32F = 0 // Matches in-memory rge::color layout.
+};
+enum class texture_wrap {
+	REPEAT = 0,
+	CLAMP = 1
+};
+enum class texture_layout {
+	LINEAR = 0, // Row-major.
+	TILED = 1   // Row-major 4x4 texel blocks, so nearby texels share cache lines at any angle.
+};
+enum class pixel_format {
+	RGBA8 = 0, // Byte order of image files.
+	BGRA8 = 1  // Byte order of 32 bit windows bitmaps.
 };
 class texture final {
 public:
 	typedef std::shared_ptr<rge::texture> ptr;
 
+	static const uint32_t BAKED_MAGIC = 0x58455452; // "RTEX"
+	static const uint32_t BAKED_VERSION = 1;
+	static const int BAKED_MAX_SIZE = 16384; // Largest baked width or height.
+	static const int TILE_SIZE = 4;
+	static const int TILE_SHIFT = 2;
+	static const int SUBTEXEL_BITS = 8; // Fixed-point precision uvs snap to before sampling.
+
+	// Header of the engine-native baked texture container (.rtex), followed by raw texel data.
+	struct baked_header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t format;
+		uint32_t filter;
+		uint32_t mip_count;
+		uint32_t layout;
+	};
+
 public:
 	static ptr create(int width, int height);
 	static ptr load(const std::string& path, bool load_to_gpu = true);
+	static ptr load_from_memory(const uint8_t* buffer, size_t size, bool load_to_gpu = true);
 	static ptr copy(const ptr& original);
 
 	// Only use if needed. Prefer create() instead
@@ -1009,32 +1193,125 @@ public:
 	// Returns sampled color at uv texture coords.
 	color sample(float u, float v) const;
 
+	// Returns sampled color at uv texture coords, using mip level of detail if filter is TRILINEAR.
+	color sample(float u, float v, float lod) const;
+
+	// Samples 4 uv pairs at once, sharing one mip level of detail. Matches sample() per pair.
+	void sample4(const float* u, const float* v, color* out, float lod = 0.0F) const;
+
+	// Samples 8 uv pairs at once, sharing one mip level of detail. Matches sample() per pair.
+	void sample8(const float* u, const float* v, color* out, float lod = 0.0F) const;
+
+	// Generates the mip chain, down to 1x1, from the cpu data.
+	void generate_mipmaps(mip_filter mode = mip_filter::BOX);
+
+	// Frees every mip level except the base level.
+	void clear_mipmaps();
+
+	// Returns number of mip levels, including the base level.
+	int get_mip_count() const;
+
+	// Returns width of a mip level in pixels.
+	int get_mip_width(int level) const;
+
+	// Returns height of a mip level in pixels.
+	int get_mip_height(int level) const;
+
+	// Returns color buffer of a mip level stored on cpu.
+	color* get_mip_data(int level) const;
+
+	// Returns storage layout of the cpu data.
+	texture_layout get_layout() const;
+
+	// Converts the cpu data, and every mip level, to a new storage layout.
+	// Textures are LINEAR unless set otherwise. In software_gl, TILED only
+	// pays off for rotated NEAREST sprites of large textures; filtered &
+	// minified sampling is as fast or slower, see texbench.
+	void set_layout(texture_layout layout);
+
+	// Returns index into a mip level's color buffer for texel x, y.
+	int get_texel_index(int level, int x, int y) const;
+
+	// Returns the row part of a texel index. Row & column offsets sum to the index, in either layout.
+	int get_texel_row_offset(int level, int y) const;
+
+	// Returns the column part of a texel index.
+	int get_texel_column_offset(int level, int x) const;
+
 	// Allocates space on cpu for texture data.
 	void allocate();
 
-	// Returns color buffer stored on cpu.
+	// Changes the size of a row-major texture without mipmaps in place, if
+	// its cpu space already holds width * height texels. Texels are kept
+	// as they were in memory.
+	rge::result reshape(int width, int height);
+
+	// Returns color buffer stored on cpu, in the texture's layout. Row-major
+	// for LINEAR, use get_texel_index() to address any layout.
 	color* get_data() const;
 
 	// Returns gpu texture reference.
 	uint32_t get_handle() const;
 
-	// Convert and store float color buffer to raw byte color buffer.
-	void dump_to_raw_buffer(uint8_t* buffer) const;
+	// Convert and store float color buffer to raw byte color buffer. Colors
+	// are clamped to [0, 1]. Dithering trades banding for a 4x4 ordered pattern.
+	void dump_to_raw_buffer(uint8_t* buffer, pixel_format format = pixel_format::RGBA8, bool dither = false) const;
+
+	// Converts the color buffer into a raw byte buffer of another size,
+	// centered & scaled with its aspect ratio kept, between black bars.
+	// NEAREST scales by the largest whole factor that fits, so pixels stay
+	// square. Other filters fill the buffer, blending only at texel edges.
+	void dump_to_raw_buffer(uint8_t* buffer, int buffer_width, int buffer_height, texture_filter filter, pixel_format format = pixel_format::RGBA8, bool dither = false) const;
 	
 	// NOTE: TESTING FUNCTION
 	rge::result write_to_disk(const std::string& path) const;
 
+	// Writes texture data as-is to the baked container format (.rtex), for fast loading.
+	rge::result write_baked_to_disk(const std::string& path) const;
+
 public:
 	texture_filter filter;
+	texture_wrap wrap;
 
 	// ==Internal Members==
 private: 
 	int width;
 	int height;
+	int capacity; // Texels the level 0 cpu space holds.
 
 	typedef std::unordered_map<std::string, ptr> table;
 	static table registry;
 	void flush_registry();
+	static ptr create_from_raw_buffer(const uint8_t* buffer, int width, int height, int channels);
+	color sample_level(int level, float u, float v, bool bilinear) const;
+	void sample_level4(int level, const float* u, const float* v, bool bilinear, color* out) const;
+	color fetch_bilinear(const color* texels, int w, int h, int stride, int x0, int y0, float w00, float w10, float w01, float w11) const;
+	void dump_row_to_raw_buffer(int y, uint8_t* dest, pixel_format format, bool dither) const;
+	int wrap_texel(int i, int size) const;
+	float wrap_coord(float t) const;
+	std::vector<color*> mip_levels; // Levels 1..n, level 0 is data.
+	texture_layout layout;
+	int get_storage_width(int level) const;
+	int get_storage_size(int level) const;
+
+	// Tiles are row-major, as are texels within a tile.
+	static inline int tiled_index(int stride, int x, int y) {
+		int tile = (y >> TILE_SHIFT) * (stride >> TILE_SHIFT) + (x >> TILE_SHIFT);
+		return (tile << (TILE_SHIFT * 2)) | ((y & (TILE_SIZE - 1)) << TILE_SHIFT) | (x & (TILE_SIZE - 1));
+	}
+
+	inline int texel_offset(int stride, int x, int y) const {
+		return layout == texture_layout::TILED ? tiled_index(stride, x, y) : x + y * stride;
+	}
+	static ptr create_from_baked_buffer(const uint8_t* buffer, size_t size);
+	static ptr read_baked_from_disk(const std::string& path);
+
+	// Returns bytes of texels following a baked header, 0 if any of its
+	// fields is out of range.
+	static uint64_t get_baked_payload_size(const baked_header& head);
+	static ptr create_from_baked_header(const baked_header& head);
+
+	static bool is_baked_path(const std::string& path);
 
 	#ifdef RGE_IMPL
 public:
@@ -1052,10 +1329,288 @@ private:
 #pragma endregion
 
 
+#pragma region /* rge::palette */
+//********************************************//
+//* Palette Class                            *//
+//********************************************//
+class palette final {
+public:
+	typedef std::shared_ptr<palette> ptr;
+
+	static const int MAX_COLORS = 256;
+
+public:
+	static ptr create(const std::vector<color>& colors);
+	palette(const std::vector<color>& colors);
+
+public:
+	// Returns number of colors.
+	int get_size() const;
+
+	// Returns color at an index, black past the end.
+	color get_color(int index) const;
+
+	// Swaps a color, every indexed pixel using it changes at the next present.
+	void set_color(int index, const color& c);
+
+	// Shifts colors [first, last] up by count places, wrapping around, for
+	// palette cycling.
+	void rotate(int first, int last, int count = 1);
+
+	// Returns index of the closest color.
+	uint8_t find_nearest(const color& c) const;
+
+	// Writes all MAX_COLORS colors as 32 bit pixels, black past the end.
+	void pack(uint32_t* out, pixel_format format) const;
+
+private:
+	std::vector<color> colors;
+};
+//********************************************//
+//* Palette Class                            *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::indexed_texture */
+//********************************************//
+//* Indexed Texture Class                    *//
+//********************************************//
+// 8 bit palette indices per texel, for retro titles limited to a palette.
+// Doubles as a render target, draws only move bytes & colors are looked up
+// at present.
+class indexed_texture final {
+public:
+	typedef std::shared_ptr<indexed_texture> ptr;
+
+public:
+	static ptr create(int width, int height);
+
+	// Maps each texel of an image to the closest palette color. Texels less
+	// than half opaque map to the transparent index.
+	static ptr load(const std::string& path, const palette& palette, uint8_t transparent_index = 0);
+	static ptr create_from_texture(const texture& texture, const palette& palette, uint8_t transparent_index = 0);
+
+	indexed_texture(int width, int height);
+
+public:
+	// Returns width of texture in pixels.
+	int get_width() const;
+
+	// Returns height of texture in pixels.
+	int get_height() const;
+
+	// Returns index buffer, row-major.
+	uint8_t* get_data();
+	const uint8_t* get_data() const;
+
+	// Fills every texel with an index.
+	void clear(uint8_t index);
+
+	// Copies a rect of another indexed texture to x, y, clipped to this one.
+	// Texels equal to the transparent index are skipped, -1 copies all.
+	// Flips mirror the source rect.
+	void draw(const indexed_texture& source, int x, int y, int src_x, int src_y, int src_width, int src_height, int transparent_index = -1, bool flip_x = false, bool flip_y = false);
+
+	// Copies a whole indexed texture to x, y.
+	void draw(const indexed_texture& source, int x, int y, int transparent_index = -1);
+
+	// Looks every texel up in a palette, into a raw byte buffer of another
+	// size. Scaled like texture::dump_to_raw_buffer with NEAREST.
+	void dump_to_raw_buffer(uint8_t* buffer, int buffer_width, int buffer_height, const palette& palette, pixel_format format = pixel_format::RGBA8) const;
+
+private:
+	int width;
+	int height;
+	std::vector<uint8_t> data;
+	std::vector<uint8_t> flipped_row;
+};
+//********************************************//
+//* Indexed Texture Class                    *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::post_process */
+//********************************************//
+//* Post Process Classes                     *//
+//********************************************//
+// A full frame pass over the window frame, applied by the software
+// renderer at display, in the order added to the renderer.
+class post_process {
+public:
+	typedef std::shared_ptr<post_process> ptr;
+
+public:
+	virtual ~post_process() {}
+
+	// Called once before apply on every display, on the render thread. Any
+	// state derived from the pass's settings is rebuilt here.
+	virtual void prepare() {}
+
+	// Writes rows [begin, end) of destination from source, both the same
+	// size. Runs on worker threads for disjoint rows at once, so it must
+	// not change the pass.
+	virtual void apply(const texture& source, texture& destination, int begin, int end) const = 0;
+};
+
+// Ordered 4x4 Bayer dithering down to a number of levels per channel.
+class dither_pass final : public post_process {
+public:
+	static ptr create(int levels = 4);
+	dither_pass(int levels);
+
+	void apply(const texture& source, texture& destination, int begin, int end) const override;
+
+public:
+	int levels;
+};
+
+// Snaps every pixel to the closest palette color. Dither spreads the
+// Bayer pattern over that fraction of the color range first.
+class palette_pass final : public post_process {
+public:
+	static ptr create(palette::ptr palette, float dither = 0.0F);
+	palette_pass(palette::ptr palette, float dither);
+
+	void prepare() override;
+	void apply(const texture& source, texture& destination, int begin, int end) const override;
+
+public:
+	palette::ptr colors;
+	float dither;
+
+private:
+	// Colors the splat was built from, to catch changes of the palette.
+	std::vector<color> splat_colors;
+
+	// Palette channels splat 4 times, [color][r, g, b][lane], so 4 pixels
+	// search the palette at once.
+	alignas(16) float splat[palette::MAX_COLORS][3][4];
+};
+
+// Darkens the last row of every period rows by intensity.
+class scanline_pass final : public post_process {
+public:
+	static ptr create(float intensity = 0.5F, int period = 2);
+	scanline_pass(float intensity, int period);
+
+	void apply(const texture& source, texture& destination, int begin, int end) const override;
+
+public:
+	float intensity;
+	int period;
+};
+
+// Bends the frame like a curved CRT screen, corners go black, & adds the
+// glow of bright neighbours.
+class crt_pass final : public post_process {
+public:
+	static ptr create(float curvature = 0.1F, float bloom = 0.3F);
+	crt_pass(float curvature, float bloom);
+
+	void apply(const texture& source, texture& destination, int begin, int end) const override;
+
+public:
+	float curvature;
+	float bloom;
+	float bloom_threshold; // Brightness where glow starts.
+	int bloom_radius;      // Pixels to the neighbours sampled for glow.
+};
+//********************************************//
+//* Post Process Classes                     *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::frame_capture */
+//********************************************//
+//* Frame Capture Class                      *//
+//********************************************//
+enum class capture_format {
+	PNG_SEQUENCE = 0, // <path>_000000.png, <path>_000001.png, ...
+	Y4M = 1           // One uncompressed YUV 4:2:0 video file.
+};
+
+// Records frames without stalling the game. Frames are copied into a ring
+// of preallocated buffers & encoded on a background thread. When every
+// buffer is still waiting to be encoded, frames are dropped & counted.
+class frame_capture final {
+public:
+	typedef std::shared_ptr<frame_capture> ptr;
+
+	static const int DEFAULT_RING_SIZE = 8;
+
+public:
+	static ptr create(const std::string& path, capture_format format, int width, int height, int fps = 60, int ring_size = DEFAULT_RING_SIZE);
+	frame_capture(const std::string& path, capture_format format, int width, int height, int fps, int ring_size);
+
+	// Encodes the frames still queued, then closes the output.
+	~frame_capture();
+
+public:
+	// Queues a copy of a frame of the capture's size. Returns FAIL if the
+	// frame was dropped.
+	rge::result submit(const texture& frame);
+
+	// Blocks until every queued frame is encoded.
+	void flush();
+
+	// Returns number of frames encoded so far.
+	int get_frames_written() const;
+
+	// Returns number of frames dropped, as the encoder fell behind.
+	int get_frames_dropped() const;
+
+private:
+	void encode_loop();
+	void encode(std::vector<uint8_t>& pixels, int frame);
+
+	std::string path;
+	capture_format format;
+	int width;
+	int height;
+	std::ofstream video;
+	std::vector<uint8_t> planes; // Y4M frame, converted on the encoder thread.
+
+	std::vector<std::vector<uint8_t>> ring;
+	std::vector<int> free_slots;
+	std::queue<std::pair<int, int>> queued; // Slot & frame number.
+	int encoding;
+	int frames_submitted;
+	std::atomic<int> frames_written;
+	std::atomic<int> frames_dropped;
+
+	std::thread encoder;
+	std::mutex mutex;
+	std::condition_variable signal;
+	bool quit;
+};
+//********************************************//
+//* Frame Capture Class                      *//
+//********************************************//
+#pragma endregion
+
+
 #pragma region /* rge::material */
 //********************************************//
 //* Material Class                           *//
 //********************************************//
+// How software_gl fills a material's triangles. The gpu renderers always
+// draw PERSPECTIVE.
+enum class raster_mode {
+	PERSPECTIVE = 0, // Perspective correct attributes, lit per pixel.
+	AFFINE = 1,      // Scanline spans, uv & vertex lighting stepped linearly in screen space, like the PS1.
+	FLAT = 2         // Scanline spans of one color, lit once per triangle. Ignores the texture.
+};
+
+// How software_gl lights a material's PERSPECTIVE triangles.
+enum class shading_model {
+	BLINN_PHONG = 0, // Lit per pixel.
+	VERTEX_LIT = 1,  // Lit per vertex, the light interpolated across the triangle.
+	UNLIT = 2        // Diffuse & texture only.
+};
+
 class material final {
 public:
 	typedef std::shared_ptr<material> ptr;
@@ -1070,6 +1625,11 @@ public:
 	color diffuse;
 	color specular;
 	float shininess;
+	raster_mode raster;
+	shading_model shading;
+	// Pixels with a lower alpha are discarded, depth included. 0 disables
+	// the test. Only PERSPECTIVE triangles in software_gl are tested.
+	float alpha_cutoff;
 };
 //********************************************//
 //* Material Class                           *//
@@ -1096,6 +1656,7 @@ public:
 	bool centered;
 	bool billboard;
 	int pixels_per_unit;
+	int layer; // Lower layers draw first, then far to near within a layer.
 
 	texture::ptr texture;
 	material::ptr material;
@@ -1121,20 +1682,67 @@ public:
 	~render_target();
 
 public:
+	// Buffers only grow, shrinking & growing back within the largest size
+	// so far keeps them in place.
 	rge::result resize(int width, int height);
 
 	int get_width() const;
 	int get_height() const;
 
+	// Returns the number of pixels the buffers hold without reallocating.
+	int get_capacity() const;
+
 	texture* get_frame_buffer() const;
 	texture* get_depth_buffer() const;
 
+public:
+	// Closest & farthest depth within a square of the depth buffer.
+	struct depth_tile {
+		float min;
+		float max;
+	};
+
+	static const int DEPTH_TILE_SIZE = 8;
+
+	// Returns the coarse depth bounds, DEPTH_TILE_SIZE pixels square each.
+	// Kept by the software renderer to reject hidden geometry early.
+	depth_tile* get_depth_tiles();
+
+	// Returns the number of depth tiles per row.
+	int get_depth_tiles_x() const;
+
+	// Returns the number of depth tile rows.
+	int get_depth_tiles_y() const;
+
+public:
+	// Fills the frame buffer with a color & the depth buffer with the far
+	// plane. A lazy clear only flags the depth tiles, each one is filled
+	// when first drawn to, so untouched tiles cost nothing until resolved.
+	void clear(const color& background, bool lazy = false);
+
+	// Fills the tiles of a lazy clear overlapping [x_min, x_max) x [y_min, y_max).
+	void resolve_clear(int x_min, int y_min, int x_max, int y_max);
+
+	// Fills every tile still flagged by a lazy clear. Needed before the
+	// buffers are read as a whole, like at display or as a texture.
+	void resolve_clear();
+
+private:
+	void fill_rows(int x_min, int y_min, int x_max, int y_max, const color& background);
+
 private:
 	int width;
 	int height;
 	renderer* renderer_instance;
 	texture::ptr frame_buffer;
 	texture::ptr depth_buffer;
+	int capacity;
+	std::vector<depth_tile> depth_tiles;
+	int depth_tiles_x;
+	int depth_tiles_y;
+	std::vector<uint8_t> clear_tiles;
+	color clear_color;
+	bool clear_pending;
 };
 //********************************************//
 //* Render Target                            *//
@@ -1142,6 +1750,53 @@ private:
 #pragma endregion
 
 
+#pragma region /* rge::render_target_pool */
+//********************************************//
+//* Render Target Pool                       *//
+//********************************************//
+class render_target_pool final {
+public:
+	// Frames a free target is kept before its buffers are released.
+	static const int MAX_IDLE_FRAMES = 120;
+
+public:
+	render_target_pool(renderer* renderer);
+
+public:
+	// Returns a target of the given size, recycled from the pool when one
+	// is free. A target is free again once released, or once the pool
+	// holds the last reference to it. Transient targets are only valid for
+	// the current frame, the pool takes them back at next_frame().
+	render_target::ptr acquire(int width, int height, bool transient = false);
+
+	// Gives a target back early, so later passes of this frame can reuse it.
+	void release(const render_target::ptr& target);
+
+	// Takes back the transient targets & releases targets idle for too long.
+	void next_frame();
+
+	// Releases the buffers of every free target.
+	void trim();
+
+private:
+	struct entry {
+		render_target::ptr target;
+		bool acquired;
+		bool transient;
+		int idle_frames;
+	};
+
+	bool is_free(const entry& e) const;
+
+	renderer* renderer_instance;
+	std::vector<entry> entries;
+};
+//********************************************//
+//* Render Target Pool                       *//
+//********************************************//
+#pragma endregion
+
+
 #pragma region /* rge::platform */
 //********************************************//
 //* Base Platform Class                      *//
@@ -1183,12 +1838,35 @@ protected:
 //********************************************//
 //* Base Renderer Class                      *//
 //********************************************//
+enum class blit_mode {
+	COPY = 0,
+	ALPHA_BLEND = 1,
+	COLOR_KEY = 2 // Skips texels equal to the key color.
+};
 class renderer {
 public:
 	void set_camera(camera::ptr camera);
 	void set_ambience(const color& ambient_color);
-	rge::result set_target(render_target::ptr target);
+	// Lights meshes drawn from now on, until removed. Lights are kept by
+	// pointer, so moving or changing one needs no resubmission.
+	void add_light(light::ptr light);
+	void remove_light(light::ptr light);
+	void clear_lights();
+	const std::vector<light::ptr>& get_lights() const;
+	// Passes run over the window frame at display, in the order added.
+	// Only the software renderer applies them for now.
+	void add_post_process(post_process::ptr pass);
+	void remove_post_process(post_process::ptr pass);
+	void clear_post_processes();
+	const std::vector<post_process::ptr>& get_post_processes() const;
+	void set_blit_mode(blit_mode mode, const color& key = color(1, 0, 1));
+	// Batched sprites are grouped by texture within a layer. Fewer state
+	// changes, but overlapping blended sprites may draw out of order.
+	void set_sprite_sort_by_texture(bool enabled);
+	virtual rge::result set_target(render_target::ptr target);
 	render_target::ptr get_target() const;
+	// Targets recycled across frames, for offscreen & post-processing passes.
+	render_target_pool& get_target_pool();
 
 public:
 	virtual rge::result init(platform* platform) = 0;
@@ -1205,6 +1883,12 @@ public:
 	// Frees the allocated texture data on gpu.
 	virtual void free_texture(texture& texture) = 0;
 
+	// Compiles the mesh data for gpu. Upload again after changing the mesh.
+	virtual void upload_mesh(mesh& mesh) {}
+
+	// Frees the compiled mesh data on gpu.
+	virtual void free_mesh(mesh& mesh) {}
+
 	// Get width of currently set frame buffer.
 	virtual int get_width() const = 0;
 
@@ -1217,6 +1901,13 @@ public:
 	// Update current frame buffer to window.
 	virtual void display() = 0;
 
+	// Blocks until the frame handed over by display() reached the window.
+	virtual void wait_for_present() {}
+
+	// Draws everything queued so far to the current target, so it can be
+	// read back on cpu without a display().
+	virtual void flush() {}
+
 	// Draw 3D geometry, using model space data.
 	virtual rge::result draw(
 		const mat4& local_to_world,
@@ -1227,13 +1918,29 @@ public:
 		const material& material
 	) = 0;
 
-	// Draw a 2D sprite onto camera space.
-	virtual void draw(const sprite& sprite) = 0;
-
-	// Draw a 2D texture onto (dest)[0, 1] view space, from (src)[0, 1] uv space.
-	virtual void draw(
-		const texture& texture,
-		vec2 dest_min,
+	// Draw 3D geometry, using model space data. Uses the compiled mesh if on gpu.
+	virtual rge::result draw(
+		const mat4& local_to_world,
+		const mesh& mesh,
+		const material& material
+	) {
+		return draw(
+			local_to_world,
+			mesh.vertices,
+			mesh.triangles,
+			mesh.normals,
+			mesh.uvs,
+			material
+		);
+	}
+
+	// Draw a 2D sprite onto camera space.
+	virtual void draw(const sprite& sprite) = 0;
+
+	// Draw a 2D texture onto (dest)[0, 1] view space, from (src)[0, 1] uv space.
+	virtual void draw(
+		const texture& texture,
+		vec2 dest_min,
 		vec2 dest_max,
 		vec2 src_min,
 		vec2 src_max
@@ -1252,22 +1959,6 @@ public:
 		int src_max_y
 	) = 0;
 public: // Inline macro short args functions.
-	// Draw 3D geometry, using model space data.
-	rge::result draw(
-		const mat4& local_to_world,
-		const mesh& mesh,
-		const material& material
-	) {
-		return draw(
-			local_to_world,
-			mesh.vertices,
-			mesh.triangles,
-			mesh.normals,
-			mesh.uvs,
-			material
-		);
-	}
-
 	// Draw a 2D texture onto (dest)[0, 1] view space.
 	void draw(const texture& texture, const vec2& dest_min, const vec2& dest_max) {
 		draw(texture, dest_min, dest_max, vec2(0, 0), vec2(1, 1));
@@ -1306,6 +1997,13 @@ protected:
 	camera::ptr input_camera;
 	render_target::ptr output_render;
 	color ambient_color;
+	std::vector<light::ptr> lights;
+	uint32_t lights_generation; // Bumped whenever the light list changes.
+	std::vector<post_process::ptr> post_processes;
+	blit_mode current_blit_mode;
+	color color_key;
+	bool sprite_sort_by_texture;
+	render_target_pool target_pool;
 };
 //********************************************//
 //* Base Renderer Class                      *//
@@ -1400,6 +2098,11 @@ class windows;
 #endif /* SYS_WINDOWS */
 
 #ifdef SYS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 class linux;
 #endif /* SYS_LINUX */
 
@@ -1409,6 +2112,11 @@ class linux;
 #include <objc/runtime.h>
 #include <objc/message.h>
 #include <objc/NSObjCRuntime.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 class macosx;
 #endif /* SYS_MACOSX */
 //********************************************//
@@ -1437,7 +2145,7 @@ typedef HGLRC gl_render_context_t;
 #endif /* SYS_WINDOWS */
 
 #ifdef SYS_LINUX
-
+#include <GL/gl.h>
 #endif /* SYS_LINUX */
 
 #ifdef SYS_MACOSX
@@ -1460,8 +2168,31 @@ typedef HDC gl_device_context_t;
 typedef HGLRC gl_render_context_t;
 #define OPENGL_LOAD(t, n) (t*)wglGetProcAddress(#n)
 #define CALLSTYLE __stdcall
+
+// Past the 1.1 gl.h shipped with windows.
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#define GL_TEXTURE0 0x84C0
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STATIC_DRAW 0x88E4
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
 #endif /* SYS_WINDOWS */
 
+#ifdef SYS_LINUX
+#include <GL/gl.h>
+extern "C" void (*glXGetProcAddress(const GLubyte* name))(void);
+#define OPENGL_LOAD(t, n) (t*)glXGetProcAddress((const GLubyte*)#n)
+#define CALLSTYLE
+#endif /* SYS_LINUX */
+
 class opengl_3_3;
 #endif /* SYS_OPENGL_3_3 */
 //********************************************//
@@ -1489,6 +2220,25 @@ class opengl_3_3;
 #pragma endregion
 
 
+#pragma region /* SIMD Dependancies */
+//********************************************//
+//* SIMD Dependancies                        *//
+//********************************************//
+#ifndef RGE_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RGE_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RGE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif /* RGE_NO_SIMD */
+//********************************************//
+//* SIMD Dependancies                        *//
+//********************************************//
+#pragma endregion
+
+
 #define LOG_MISSING_DEP(OP, LIB) rge::log::error("Operation '"#OP"' failed! Dependancy not installed: "#LIB);
 
 
@@ -2121,6 +2871,37 @@ vec3 mat4::extract_forward_axis() const {
 	return vec3::normalize(vec3(m[0][2], m[1][2], m[2][2]));
 }
 
+mat4 mat4::inverse() const {
+	const float* a = &m[0][0];
+	float inv[16];
+
+	// Cofactors, expanded along the rows.
+	inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+	inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+	inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+	inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+	inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+	inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+	inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+	inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+	inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+	inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+	inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+	inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+	inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+	inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+	inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+	inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+	float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+	if(det == 0.0F) return mat4::zero();
+
+	mat4 result;
+	float* r = &result.m[0][0];
+	for(int i = 0; i < 16; i++) r[i] = inv[i] / det;
+	return result;
+}
+
 vec4 mat4::operator * (const vec4& rhs) const {
 	vec4 result = vec4();
 	result.x = this->m[0][0] * rhs.x + this->m[0][1] * rhs.y + this->m[0][2] * rhs.z + this->m[0][3] * rhs.w;
@@ -2260,6 +3041,124 @@ float math::inverse_lerp(float a, float b, float v) {
 #pragma endregion
 
 
+#pragma region /* rge::simd */
+//********************************************//
+//* SIMD Helpers                             *//
+//********************************************//
+// 4-wide float lanes, matching the rge::color (r, g, b, a) layout.
+namespace simd {
+	#if defined(RGE_SIMD_SSE2)
+	typedef __m128 f32x4;
+	inline f32x4 load(const float* p) { return _mm_loadu_ps(p); }
+	inline void store(float* p, f32x4 v) { _mm_storeu_ps(p, v); }
+	inline f32x4 set1(float v) { return _mm_set1_ps(v); }
+	inline f32x4 add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+	inline f32x4 sub(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+	inline f32x4 mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+	inline f32x4 min(f32x4 a, f32x4 b) { return _mm_min_ps(a, b); }
+	inline f32x4 max(f32x4 a, f32x4 b) { return _mm_max_ps(a, b); }
+	inline f32x4 div(f32x4 a, f32x4 b) { return _mm_div_ps(a, b); }
+	inline f32x4 sqrt(f32x4 v) { return _mm_sqrt_ps(v); }
+	inline f32x4 mask_less(f32x4 a, f32x4 b, f32x4 v) { return _mm_and_ps(_mm_cmplt_ps(a, b), v); }
+
+	typedef __m128i i32x4;
+	inline void store(int32_t* p, i32x4 v) { _mm_storeu_si128((__m128i*)p, v); }
+	inline i32x4 set1_int(int32_t v) { return _mm_set1_epi32(v); }
+	inline i32x4 add(i32x4 a, i32x4 b) { return _mm_add_epi32(a, b); }
+	inline i32x4 sub(i32x4 a, i32x4 b) { return _mm_sub_epi32(a, b); }
+	inline i32x4 bit_and(i32x4 a, i32x4 b) { return _mm_and_si128(a, b); }
+	inline i32x4 shift_right(i32x4 a, int bits) { return _mm_srai_epi32(a, bits); }
+	inline i32x4 round_to_int(f32x4 v) { return _mm_cvtps_epi32(v); }
+	inline f32x4 to_float(i32x4 v) { return _mm_cvtepi32_ps(v); }
+	inline f32x4 swap_rb(f32x4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 1, 2)); }
+	inline void store_bytes(uint8_t* p, i32x4 a, i32x4 b, i32x4 c, i32x4 d) { _mm_storeu_si128((__m128i*)p, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d))); }
+	inline void copy_bytes_keyed(uint8_t* dest, const uint8_t* src, uint8_t key) { __m128i s = _mm_loadu_si128((const __m128i*)src); __m128i m = _mm_cmpeq_epi8(s, _mm_set1_epi8((char)key)); _mm_storeu_si128((__m128i*)dest, _mm_or_si128(_mm_andnot_si128(m, s), _mm_and_si128(m, _mm_loadu_si128((const __m128i*)dest)))); }
+	#elif defined(RGE_SIMD_NEON)
+	typedef float32x4_t f32x4;
+	inline f32x4 load(const float* p) { return vld1q_f32(p); }
+	inline void store(float* p, f32x4 v) { vst1q_f32(p, v); }
+	inline f32x4 set1(float v) { return vdupq_n_f32(v); }
+	inline f32x4 add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+	inline f32x4 sub(f32x4 a, f32x4 b) { return vsubq_f32(a, b); }
+	inline f32x4 mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+	inline f32x4 min(f32x4 a, f32x4 b) { return vminq_f32(a, b); }
+	inline f32x4 max(f32x4 a, f32x4 b) { return vmaxq_f32(a, b); }
+	#if defined(__aarch64__)
+	inline f32x4 div(f32x4 a, f32x4 b) { return vdivq_f32(a, b); }
+	inline f32x4 sqrt(f32x4 v) { return vsqrtq_f32(v); }
+	#else
+	inline f32x4 div(f32x4 a, f32x4 b) { float32x4_t r = vrecpeq_f32(b); r = vmulq_f32(vrecpsq_f32(b, r), r); r = vmulq_f32(vrecpsq_f32(b, r), r); return vmulq_f32(a, r); }
+	inline f32x4 sqrt(f32x4 v) { float f[4]; vst1q_f32(f, v); for(int k = 0; k < 4; k++) f[k] = sqrtf(f[k]); return vld1q_f32(f); }
+	#endif
+	inline f32x4 mask_less(f32x4 a, f32x4 b, f32x4 v) { return vreinterpretq_f32_u32(vandq_u32(vcltq_f32(a, b), vreinterpretq_u32_f32(v))); }
+
+	typedef int32x4_t i32x4;
+	inline void store(int32_t* p, i32x4 v) { vst1q_s32(p, v); }
+	inline i32x4 set1_int(int32_t v) { return vdupq_n_s32(v); }
+	inline i32x4 add(i32x4 a, i32x4 b) { return vaddq_s32(a, b); }
+	inline i32x4 sub(i32x4 a, i32x4 b) { return vsubq_s32(a, b); }
+	inline i32x4 bit_and(i32x4 a, i32x4 b) { return vandq_s32(a, b); }
+	inline i32x4 shift_right(i32x4 a, int bits) { return vshlq_s32(a, vdupq_n_s32(-bits)); }
+	#if defined(__aarch64__)
+	inline i32x4 round_to_int(f32x4 v) { return vcvtnq_s32_f32(v); }
+	#else
+	inline i32x4 round_to_int(f32x4 v) { float f[4]; int32_t i[4]; vst1q_f32(f, v); for(int k = 0; k < 4; k++) i[k] = (int32_t)lrintf(f[k]); return vld1q_s32(i); }
+	#endif
+	inline f32x4 to_float(i32x4 v) { return vcvtq_f32_s32(v); }
+	inline f32x4 swap_rb(f32x4 v) { float32x4_t r = vsetq_lane_f32(vgetq_lane_f32(v, 2), v, 0); return vsetq_lane_f32(vgetq_lane_f32(v, 0), r, 2); }
+	inline void store_bytes(uint8_t* p, i32x4 a, i32x4 b, i32x4 c, i32x4 d) { vst1q_u8(p, vcombine_u8(vqmovun_s16(vcombine_s16(vqmovn_s32(a), vqmovn_s32(b))), vqmovun_s16(vcombine_s16(vqmovn_s32(c), vqmovn_s32(d))))); }
+	inline void copy_bytes_keyed(uint8_t* dest, const uint8_t* src, uint8_t key) { uint8x16_t s = vld1q_u8(src); vst1q_u8(dest, vbslq_u8(vceqq_u8(s, vdupq_n_u8(key)), vld1q_u8(dest), s)); }
+	#else
+	struct f32x4 { float v[4]; };
+	inline f32x4 load(const float* p) { f32x4 r; r.v[0] = p[0]; r.v[1] = p[1]; r.v[2] = p[2]; r.v[3] = p[3]; return r; }
+	inline void store(float* p, f32x4 a) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+	inline f32x4 set1(float v) { f32x4 r; r.v[0] = v; r.v[1] = v; r.v[2] = v; r.v[3] = v; return r; }
+	inline f32x4 add(f32x4 a, f32x4 b) { for(int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+	inline f32x4 sub(f32x4 a, f32x4 b) { for(int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+	inline f32x4 mul(f32x4 a, f32x4 b) { for(int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+	inline f32x4 min(f32x4 a, f32x4 b) { for(int i = 0; i < 4; i++) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return a; }
+	inline f32x4 max(f32x4 a, f32x4 b) { for(int i = 0; i < 4; i++) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+	inline f32x4 div(f32x4 a, f32x4 b) { for(int i = 0; i < 4; i++) a.v[i] /= b.v[i]; return a; }
+	inline f32x4 sqrt(f32x4 a) { for(int i = 0; i < 4; i++) a.v[i] = sqrtf(a.v[i]); return a; }
+	inline f32x4 mask_less(f32x4 a, f32x4 b, f32x4 v) { for(int i = 0; i < 4; i++) v.v[i] = a.v[i] < b.v[i] ? v.v[i] : 0.0F; return v; }
+
+	struct i32x4 { int32_t v[4]; };
+	inline void store(int32_t* p, i32x4 a) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+	inline i32x4 set1_int(int32_t v) { i32x4 r; r.v[0] = v; r.v[1] = v; r.v[2] = v; r.v[3] = v; return r; }
+	inline i32x4 add(i32x4 a, i32x4 b) { for(int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+	inline i32x4 sub(i32x4 a, i32x4 b) { for(int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+	inline i32x4 bit_and(i32x4 a, i32x4 b) { for(int i = 0; i < 4; i++) a.v[i] &= b.v[i]; return a; }
+	inline i32x4 shift_right(i32x4 a, int bits) { for(int i = 0; i < 4; i++) a.v[i] >>= bits; return a; }
+	inline i32x4 round_to_int(f32x4 a) { i32x4 r; for(int i = 0; i < 4; i++) r.v[i] = (int32_t)lrintf(a.v[i]); return r; }
+	inline f32x4 to_float(i32x4 a) { f32x4 r; for(int i = 0; i < 4; i++) r.v[i] = (float)a.v[i]; return r; }
+	inline f32x4 swap_rb(f32x4 a) { float t = a.v[0]; a.v[0] = a.v[2]; a.v[2] = t; return a; }
+	inline void store_bytes(uint8_t* p, i32x4 a, i32x4 b, i32x4 c, i32x4 d) { const i32x4* v[4] = { &a, &b, &c, &d }; for(int i = 0; i < 16; i++) { int32_t x = v[i / 4]->v[i % 4]; p[i] = (uint8_t)(x < 0 ? 0 : x > 255 ? 255 : x); } }
+	inline void copy_bytes_keyed(uint8_t* dest, const uint8_t* src, uint8_t key) { for(int i = 0; i < 16; i++) if(src[i] != key) dest[i] = src[i]; }
+	#endif
+
+	#if defined(RGE_SIMD_SSE2)
+	inline f32x4 splat_w(f32x4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+	inline bool all_equal(f32x4 a, f32x4 b) { return _mm_movemask_ps(_mm_cmpeq_ps(a, b)) == 0xF; }
+	#elif defined(RGE_SIMD_NEON)
+	inline f32x4 splat_w(f32x4 v) { return vdupq_n_f32(vgetq_lane_f32(v, 3)); }
+	inline bool all_equal(f32x4 a, f32x4 b) { uint32x4_t m = vceqq_f32(a, b); return (vgetq_lane_u32(m, 0) & vgetq_lane_u32(m, 1) & vgetq_lane_u32(m, 2) & vgetq_lane_u32(m, 3)) != 0; }
+	#else
+	inline f32x4 splat_w(f32x4 a) { return set1(a.v[3]); }
+	inline bool all_equal(f32x4 a, f32x4 b) { return a.v[0] == b.v[0] && a.v[1] == b.v[1] && a.v[2] == b.v[2] && a.v[3] == b.v[3]; }
+	#endif
+
+	inline f32x4 load(const color& c) { return load(&c.r); }
+	inline void store(color& c, f32x4 v) { store(&c.r, v); }
+	inline f32x4 lerp(f32x4 a, f32x4 b, f32x4 t) { return add(a, mul(sub(b, a), t)); }
+	inline f32x4 clamp01(f32x4 v) { return min(max(v, set1(0.0F)), set1(1.0F)); }
+	inline f32x4 floor(f32x4 v) { f32x4 r = to_float(round_to_int(v)); return sub(r, mask_less(v, r, set1(1.0F))); }
+}
+//********************************************//
+//* SIMD Helpers                             *//
+//********************************************//
+#pragma endregion
+
+
 #pragma region /* rge::log */
 //********************************************//
 //* Logging Module.                          *//
@@ -2784,6 +3683,156 @@ int64_t random::next_i64() {
 #pragma endregion
 
 
+#pragma region /* rge::jobs */
+//********************************************//
+//* Jobs Module                              *//
+//********************************************//
+namespace jobs {
+	const int MAX_WORKER_COUNT = 15;
+	const int CHUNKS_PER_THREAD = 4;
+
+	thread_local bool in_job = false;
+
+	struct job_state {
+		const std::function<void(int, int)>* job;
+		int count;
+		int batch;
+		int chunk_count;
+		std::atomic<int> next_chunk;
+		std::atomic<int> remaining;
+	};
+
+	class worker_pool {
+	public:
+		worker_pool() {
+			stopping = false;
+			generation = 0;
+
+			int count = (int)std::thread::hardware_concurrency() - 1;
+			if(count < 0) count = 0;
+			if(count > MAX_WORKER_COUNT) count = MAX_WORKER_COUNT;
+
+			for(int i = 0; i < count; i++)
+				threads.push_back(std::thread(&worker_pool::work, this));
+		}
+
+		~worker_pool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for(size_t i = 0; i < threads.size(); i++)
+				threads[i].join();
+		}
+
+		int get_thread_count() const {
+			return (int)threads.size() + 1;
+		}
+
+		void run(int count, int min_batch, const std::function<void(int, int)>& job) {
+			if(min_batch < 1) min_batch = 1;
+
+			// Only one dispatch at a time. Nested or concurrent calls run inline instead.
+			std::unique_lock<std::mutex> dispatch(dispatch_mutex, std::try_to_lock);
+			if(in_job || threads.empty() || !dispatch.owns_lock() || count <= min_batch) {
+				job(0, count);
+				return;
+			}
+
+			std::shared_ptr<job_state> state = std::make_shared<job_state>();
+			state->job = &job;
+			state->count = count;
+			state->chunk_count = math::min(count / min_batch, get_thread_count() * CHUNKS_PER_THREAD);
+			state->batch = (count + state->chunk_count - 1) / state->chunk_count;
+			state->chunk_count = (count + state->batch - 1) / state->batch;
+			state->next_chunk = 0;
+			state->remaining = state->chunk_count;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				current = state;
+				generation++;
+			}
+			wake.notify_all();
+
+			// Calling thread helps out, then waits for stragglers.
+			execute(*state);
+
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [&state]() -> bool { return state->remaining == 0; });
+			current.reset();
+		}
+
+	private:
+		void execute(job_state& state) {
+			in_job = true;
+
+			for(;;) {
+				int chunk = state.next_chunk.fetch_add(1);
+				if(chunk >= state.chunk_count) break;
+
+				int begin = chunk * state.batch;
+				int end = math::min(begin + state.batch, state.count);
+				(*state.job)(begin, end);
+
+				if(state.remaining.fetch_sub(1) == 1) {
+					std::lock_guard<std::mutex> lock(mutex);
+					done.notify_all();
+				}
+			}
+
+			in_job = false;
+		}
+
+		void work() {
+			uint64_t seen = 0;
+
+			for(;;) {
+				std::shared_ptr<job_state> state;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [this, &seen]() -> bool { return stopping || generation != seen; });
+					if(stopping) return;
+					seen = generation;
+					state = current;
+				}
+
+				if(state) execute(*state);
+			}
+		}
+
+	private:
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::mutex dispatch_mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		std::shared_ptr<job_state> current;
+		uint64_t generation;
+		bool stopping;
+	};
+
+	static worker_pool& get_pool() {
+		static worker_pool pool;
+		return pool;
+	}
+}
+
+int jobs::get_thread_count() {
+	return get_pool().get_thread_count();
+}
+
+void jobs::parallel_for(int count, int min_batch, const std::function<void(int begin, int end)>& job) {
+	if(count <= 0) return;
+	get_pool().run(count, min_batch, job);
+}
+//********************************************//
+//* Jobs Module                              *//
+//********************************************//
+#pragma endregion
+
+
 #pragma region /* rge::event_dispatcher */
 //********************************************//
 //* Event dispatcher                         *//
@@ -3092,6 +4141,7 @@ void engine::loop() {
 	if(render_counter > render_interval) {
 		on_render();
 		renderer_impl->display();
+		renderer_impl->get_target_pool().next_frame();
 		platform_impl->refresh_window();
 		render_counter = 0;
 	}
@@ -3400,11 +4450,18 @@ mesh::ptr mesh::create() {
 }
 
 mesh::mesh() {
-
+	handle = 0;
 }
 
 mesh::~mesh() {
+	if(is_on_gpu()) {
+		if(engine::get_instance() && engine::get_instance()->get_renderer())
+			engine::get_instance()->get_renderer()->free_mesh(*this);
+	}
+}
 
+bool mesh::is_on_gpu() const {
+	return handle > 0;
 }
 //********************************************//
 //* Mesh Class                               *//
@@ -3412,1621 +4469,6496 @@ mesh::~mesh() {
 #pragma endregion
 
 
-#pragma region /* rge::texture */
+#pragma region /* rge::pak */
 //********************************************//
-//* Texture Class                            *//
+//* Packed Asset Archive Class               *//
 //********************************************//
-texture::table texture::registry;
-
-texture::ptr texture::create(int width, int height) {
-	ptr texture;
-	texture.reset(new rge::texture(width, height));
-	return texture;
-}
+namespace lz4 {
+	const int MIN_MATCH = 4;
+	const int LAST_LITERALS = 5;
+	const int MF_LIMIT = 12;
+	const int HASH_BITS = 12;
+	const int MAX_OFFSET = 65535;
 
-texture::ptr texture::copy(const texture::ptr& original) {
-	texture::ptr texture = create(original->get_width(), original->get_height());
-	texture->filter = original->filter;
+	inline uint32_t read_u32(const uint8_t* p) {
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
 
-	if(original->is_on_cpu()) {
-		texture->allocate();
-		// TODO: Copy cpu data.
+	inline int compress_bound(int size) {
+		return size + (size / 255) + 16;
 	}
 
-	if(original->is_on_gpu()) {
-		engine::get_renderer()->alloc_texture(*texture);
-		// TODO: Copy gpu data.
+	inline uint8_t* write_length(uint8_t* op, int length) {
+		while(length >= 255) {
+			*op++ = 255;
+			length -= 255;
+		}
+		*op++ = (uint8_t)length;
+		return op;
 	}
 
-	return texture;
-}
+	// Greedy LZ4 block compressor. Returns compressed size, or 0 if output does not fit.
+	int compress(const uint8_t* src, int src_size, uint8_t* dst, int dst_capacity) {
+		int table[1 << HASH_BITS];
+		int ip = 0;
+		int anchor = 0;
+		uint8_t* op = dst;
+		uint8_t* op_end = dst + dst_capacity;
 
-texture::texture(int width, int height) {
-	this->width = width;
-	this->height = height;
+		for(int i = 0; i < (1 << HASH_BITS); i++) table[i] = -1;
 
-	filter = texture_filter::NEAREST;
-	data = nullptr;
-	handle = 0;
-}
+		if(src_size > MF_LIMIT) {
+			int limit = src_size - MF_LIMIT;
 
-texture::~texture() {
-	if(is_on_gpu()) {
-		if(engine::get_instance() && engine::get_instance()->get_renderer())
-			engine::get_instance()->get_renderer()->free_texture(*this);
-	}
-	if(is_on_cpu()) delete[] data;
-}
+			while(ip < limit) {
+				uint32_t sequence = read_u32(src + ip);
+				uint32_t h = (sequence * 2654435761U) >> (32 - HASH_BITS);
+				int ref = table[h];
+				table[h] = ip;
 
-int texture::get_width() const {
-	return width;
-}
+				if(ref < 0 || ip - ref > MAX_OFFSET || read_u32(src + ref) != sequence) {
+					ip++;
+					continue;
+				}
 
-int texture::get_height() const {
-	return height;
-}
+				// Extend the match as far as the end-of-block rules allow.
+				int match_length = MIN_MATCH;
+				while(ip + match_length < src_size - LAST_LITERALS && src[ref + match_length] == src[ip + match_length])
+					match_length++;
 
-bool texture::is_on_cpu() const {
-	return data != nullptr;
-}
+				int literal_length = ip - anchor;
+				if(op + 1 + (literal_length / 255) + 1 + literal_length + 2 + (match_length / 255) + 1 > op_end)
+					return 0;
 
-bool texture::is_on_gpu() const {
-	return handle > 0;
-}
+				uint8_t* token = op++;
+				*token = 0;
 
-color texture::sample(float u, float v) const {
-	if(data == nullptr) return color(0, 0, 0);
+				if(literal_length >= 15) {
+					*token = 15 << 4;
+					op = write_length(op, literal_length - 15);
+				} else {
+					*token = (uint8_t)(literal_length << 4);
+				}
 
-	if(filter == texture_filter::NEAREST) {
-		int ui = (int)(u * width) % width;
-		int vi = (int)(v * height) % height;
+				memcpy(op, src + anchor, literal_length);
+				op += literal_length;
 
-		if(ui < 0) ui += width;
-		if(vi < 0) vi += height;
+				uint16_t offset = (uint16_t)(ip - ref);
+				*op++ = (uint8_t)(offset & 0xFF);
+				*op++ = (uint8_t)(offset >> 8);
 
-		return data[ui + (vi * width)];
-	} else if(filter == texture_filter::BILINEAR) {
-		// TODO: Add repeating uv
-		float uw = u * width;
-		float vh = v * height;
-		int ui = int(u * width);
-		int vi = int(v * height);
+				int extra = match_length - MIN_MATCH;
+				if(extra >= 15) {
+					*token |= 15;
+					op = write_length(op, extra - 15);
+				} else {
+					*token |= (uint8_t)extra;
+				}
 
-		int fui = int(floor(uw));
-		int fvi = int(floor(vh));
-		int cui = int(ceil(uw));
-		int cvi = int(ceil(vh));
+				ip += match_length;
+				anchor = ip;
+			}
+		}
 
-		if(fui < 0) fui = 0;
-		if(fvi < 0) fvi = 0;
-		if(cui >= width) cui = width - 1;
-		if(cvi >= height) cvi = height - 1;
+		// Emit the trailing literals.
+		int literal_length = src_size - anchor;
+		if(op + 1 + (literal_length / 255) + 1 + literal_length > op_end)
+			return 0;
 
-		color bl = data[fui + (fvi * width)];
-		color br = data[cui + (fvi * width)];
-		color tl = data[fui + (cvi * width)];
-		color tr = data[cui + (cvi * width)];
+		if(literal_length >= 15) {
+			*op++ = 15 << 4;
+			op = write_length(op, literal_length - 15);
+		} else {
+			*op++ = (uint8_t)(literal_length << 4);
+		}
 
-		float ix = math::inverse_lerp(float(fui), float(cui), uw);
-		float iy = math::inverse_lerp(float(fvi), float(cvi), vh);
+		memcpy(op, src + anchor, literal_length);
+		op += literal_length;
 
-		return color::lerp(color::lerp(bl, br, ix), color::lerp(tl, tr, ix), iy);
+		return (int)(op - dst);
 	}
 
-	return color(0, 0, 0);
-}
+	// LZ4 block decompressor. Returns false on malformed input.
+	bool decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size) {
+		const uint8_t* ip = src;
+		const uint8_t* ip_end = src + src_size;
+		uint8_t* op = dst;
+		uint8_t* op_end = dst + dst_size;
 
-color* texture::get_data() const {
-	return data;
-}
+		while(ip < ip_end) {
+			uint8_t token = *ip++;
 
-uint32_t texture::get_handle() const {
-	return handle;
-}
+			size_t literal_length = token >> 4;
+			if(literal_length == 15) {
+				uint8_t b;
+				do {
+					if(ip >= ip_end) return false;
+					b = *ip++;
+					literal_length += b;
+				} while(b == 255);
+			}
 
-void texture::dump_to_raw_buffer(uint8_t* buffer) const {
-	if(!is_on_cpu()) return;
+			if(ip + literal_length > ip_end || op + literal_length > op_end) return false;
+			memcpy(op, ip, literal_length);
+			ip += literal_length;
+			op += literal_length;
+
+			// The last sequence only holds literals.
+			if(ip >= ip_end) break;
+
+			if(ip + 2 > ip_end) return false;
+			size_t offset = ip[0] | (ip[1] << 8);
+			ip += 2;
+			if(offset == 0 || offset > (size_t)(op - dst)) return false;
+
+			size_t match_length = token & 15;
+			if(match_length == 15) {
+				uint8_t b;
+				do {
+					if(ip >= ip_end) return false;
+					b = *ip++;
+					match_length += b;
+				} while(b == 255);
+			}
+			match_length += MIN_MATCH;
 
-	for(int i = 0; i < width * height; i++) {
-		color c = data[i];
-		buffer[i * 4] = (uint8_t)(c.r * 255);
-		buffer[i * 4 + 1] = (uint8_t)(c.g * 255);
-		buffer[i * 4 + 2] = (uint8_t)(c.b * 255);
-		buffer[i * 4 + 3] = (uint8_t)(c.a * 255);
+			if(op + match_length > op_end) return false;
+
+			// Byte copy, as matches may overlap the output.
+			const uint8_t* match = op - offset;
+			for(size_t i = 0; i < match_length; i++)
+				op[i] = match[i];
+			op += match_length;
+		}
+
+		return op == op_end;
 	}
 }
 
-rge::result texture::write_to_disk(const std::string& path) const {
-	if(!is_on_cpu()) return rge::FAIL;
+std::vector<pak::ptr> pak::mounted;
+std::mutex pak::mounted_mutex;
 
-	#ifdef RGE_USE_STB_IMAGE_WRITE
-	uint8_t* buffer = (uint8_t*)malloc(4 * width * height);
-	dump_to_raw_buffer(buffer);
-	
-	if(!stbi_write_bmp(path.c_str(), width, height, 4, buffer)) {
-		rge::log::error("File write fail.");
-		free(buffer);
-		return rge::FAIL;
-	} else {
-		free(buffer);
-		return rge::OK;
-	}
+static std::string normalize_asset_path(const std::string& path) {
+	std::string p = path;
+	std::replace(p.begin(), p.end(), '\\', '/');
+	while(p.compare(0, 2, "./") == 0) p.erase(0, 2);
+	return p;
+}
+
+static void list_directory_files(const std::string& root, const std::string& relative, std::vector<std::string>& files) {
+	std::string directory = relative.empty() ? root : root + "/" + relative;
+
+	#ifdef SYS_WINDOWS
+	WIN32_FIND_DATAA find_data;
+	HANDLE find = FindFirstFileA((directory + "/*").c_str(), &find_data);
+	if(find == INVALID_HANDLE_VALUE) return;
+
+	do {
+		std::string name = find_data.cFileName;
+		if(name == "." || name == "..") continue;
+
+		std::string child = relative.empty() ? name : relative + "/" + name;
+		if(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			list_directory_files(root, child, files);
+		else
+			files.push_back(child);
+	} while(FindNextFileA(find, &find_data));
+
+	FindClose(find);
 	#else
-	LOG_MISSING_DEP(write_texture_to_disk, stb_image_write.h)
-	return rge::FAIL;
+	DIR* dir = opendir(directory.c_str());
+	if(dir == nullptr) return;
+
+	struct dirent* ent;
+	while((ent = readdir(dir)) != nullptr) {
+		std::string name = ent->d_name;
+		if(name == "." || name == "..") continue;
+
+		std::string child = relative.empty() ? name : relative + "/" + name;
+		struct stat st;
+		if(stat((root + "/" + child).c_str(), &st) != 0) continue;
+
+		if(S_ISDIR(st.st_mode))
+			list_directory_files(root, child, files);
+		else if(S_ISREG(st.st_mode))
+			files.push_back(child);
+	}
+
+	closedir(dir);
 	#endif
 }
 
-void texture::allocate() {
-	if(data) return;
-	data = new color[width * height];
+uint64_t pak::hash(const std::string& path) {
+	return hash_normalized(normalize_asset_path(path));
 }
 
-void texture::flush_registry() {
-	for(auto it = registry.begin(); it != registry.end(); it++) {
-		if(it->second.use_count() <= 1) {
-			// TODO: Last ref texture is in table itself, therefore we free the memory.
-		}
+uint64_t pak::hash_normalized(const std::string& p) {
+	uint64_t h = 14695981039346656037ULL;
+	for(size_t i = 0; i < p.size(); i++) {
+		h ^= (uint8_t)p[i];
+		h *= 1099511628211ULL;
 	}
+	return h;
 }
 
-texture::ptr texture::load(const std::string& path, bool load_to_gpu) {
-	if(registry.count(path) > 0) {
-		texture::ptr t = registry.find(path)->second;
-		if(load_to_gpu && !t->is_on_gpu())
-			engine::get_renderer()->upload_texture(*t);
-		return t;
-	}
+pak::pak() {
+	mapped = nullptr;
+	mapped_size = 0;
+	head = nullptr;
+	toc = nullptr;
+	names = nullptr;
+	names_size = 0;
+
+	#ifdef SYS_WINDOWS
+	file_handle = nullptr;
+	map_handle = nullptr;
+	#endif
+}
 
-	#ifdef RGE_USE_STB_IMAGE
+pak::~pak() {
+	// Handles are closed even when open() failed before mapping a view.
+	#ifdef SYS_WINDOWS
+	if(mapped) UnmapViewOfFile(mapped);
+	if(map_handle) CloseHandle((HANDLE)map_handle);
+	if(file_handle) CloseHandle((HANDLE)file_handle);
+	#else
+	if(mapped) munmap((void*)mapped, mapped_size);
+	#endif
+}
 
-	int i, w, h, ch;
-	uint8_t* input_buffer = stbi_load(path.c_str(), &w, &h, &ch, 4);
+pak::ptr pak::open(const std::string& path) {
+	pak::ptr archive = std::make_shared<pak>();
 
-	if(!input_buffer) {
-		rge::log::error("Could not load texture: %s", path.c_str());
+	#ifdef SYS_WINDOWS
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+	if(file == INVALID_HANDLE_VALUE) {
+		rge::log::error("Could not open pak: %s", path.c_str());
 		return nullptr;
 	}
+	archive->file_handle = file;
 
-	if(ch != 3 && ch != 4) {
-		rge::log::error("Texture file read failed: only RGB & RGBA formats supported!");
-		stbi_image_free(input_buffer);
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(file, &file_size);
+	archive->mapped_size = (size_t)file_size.QuadPart;
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(mapping == NULL) {
+		rge::log::error("Could not map pak: %s", path.c_str());
 		return nullptr;
 	}
+	archive->map_handle = mapping;
 
-	texture::ptr texture = create(w, h);
-	texture->allocate();
-	
-	color* tex_data = texture->get_data();
-	color c;
-	for(i = 0; i < w * h; ++i) {
-		if(ch == 3) {
-			c = color(
-				input_buffer[i * 3] / 255.0F,
-				input_buffer[i * 3 + 1] / 255.0F,
-				input_buffer[i * 3 + 2] / 255.0F
-			);
-		} else if(ch == 4) {
-			c = color(
-				input_buffer[i * 4] / 255.0F,
-				input_buffer[i * 4 + 1] / 255.0F,
-				input_buffer[i * 4 + 2] / 255.0F,
-				input_buffer[i * 4 + 3] / 255.0F
-			);
+	archive->mapped = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		rge::log::error("Could not open pak: %s", path.c_str());
+		return nullptr;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0) {
+		close(fd);
+		return nullptr;
+	}
+	archive->mapped_size = (size_t)st.st_size;
+
+	void* view = mmap(nullptr, archive->mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // Mapping stays valid after the descriptor is closed.
+	archive->mapped = view == MAP_FAILED ? nullptr : (const uint8_t*)view;
+	#endif
+
+	if(archive->mapped == nullptr) {
+		rge::log::error("Could not map pak: %s", path.c_str());
+		return nullptr;
+	}
+
+	if(archive->mapped_size < sizeof(header)) {
+		rge::log::error("Pak file is truncated: %s", path.c_str());
+		return nullptr;
+	}
+
+	archive->head = (const header*)archive->mapped;
+	if(archive->head->magic != MAGIC || archive->head->version != VERSION) {
+		rge::log::error("Pak file has invalid header: %s", path.c_str());
+		return nullptr;
+	}
+
+	// Compared without sums, so huge offsets can't wrap past the check. The
+	// table of contents is read in place, so it must be aligned.
+	uint64_t size = archive->mapped_size;
+	if(archive->head->toc_offset > size || archive->head->toc_offset % alignof(entry) != 0 ||
+	   archive->head->entry_count > (size - archive->head->toc_offset) / sizeof(entry) ||
+	   archive->head->names_offset > size) {
+		rge::log::error("Pak file is truncated: %s", path.c_str());
+		return nullptr;
+	}
+
+	archive->toc = (const entry*)(archive->mapped + archive->head->toc_offset);
+	archive->names = (const char*)(archive->mapped + archive->head->names_offset);
+	archive->names_size = (size_t)(size - archive->head->names_offset);
+
+	return archive;
+}
+
+rge::result pak::build(const std::string& directory, const std::string& output, bool compress, const std::string& prefix) {
+	std::vector<std::string> files;
+	list_directory_files(directory, "", files);
+
+	struct pending {
+		std::string name;
+		std::vector<uint8_t> data;
+		entry info;
+	};
+
+	std::vector<pending> items(files.size());
+	std::string name_table;
+
+	for(size_t i = 0; i < files.size(); i++) {
+		pending& item = items[i];
+		item.name = normalize_asset_path(prefix.empty() ? files[i] : prefix + "/" + files[i]);
+
+		std::ifstream in(directory + "/" + files[i], std::ios::binary);
+		if(!in.is_open()) {
+			rge::log::error("Could not read file: %s", files[i].c_str());
+			return rge::FAIL;
+		}
+		item.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+		item.info.hash = hash(item.name);
+		item.info.size = item.data.size();
+		item.info.stored_size = item.data.size();
+		item.info.flags = 0;
+		item.info.name_offset = (uint32_t)name_table.size();
+		name_table += item.name;
+		name_table.push_back('\0');
+
+		// Only keep the compressed version if it actually saves space.
+		if(compress && item.data.size() > 0) {
+			std::vector<uint8_t> packed(lz4::compress_bound((int)item.data.size()));
+			int packed_size = lz4::compress(item.data.data(), (int)item.data.size(), packed.data(), (int)packed.size());
+			if(packed_size > 0 && (size_t)packed_size < item.data.size()) {
+				packed.resize(packed_size);
+				item.data.swap(packed);
+				item.info.stored_size = item.data.size();
+				item.info.flags |= FLAG_COMPRESSED;
+			}
 		}
+	}
 
-		tex_data[i] = c;
+	std::sort(items.begin(), items.end(), [](const pending& a, const pending& b) -> bool {
+		return a.info.hash < b.info.hash;
+	});
+
+	for(size_t i = 1; i < items.size(); i++) {
+		if(items[i].info.hash == items[i - 1].info.hash) {
+			rge::log::error("Pak path hash collision: %s & %s", items[i].name.c_str(), items[i - 1].name.c_str());
+			return rge::FAIL;
+		}
 	}
 
-	stbi_image_free(input_buffer);
+	header head;
+	head.magic = MAGIC;
+	head.version = VERSION;
+	head.entry_count = (uint32_t)items.size();
+	head.reserved = 0;
+	head.toc_offset = sizeof(header);
+	head.names_offset = head.toc_offset + items.size() * sizeof(entry);
 
-	registry.insert(std::pair<std::string, texture::ptr>(path, texture));
+	// Entry data starts on the first page after the table of contents.
+	uint64_t cursor = head.names_offset + name_table.size();
+	for(size_t i = 0; i < items.size(); i++) {
+		cursor = (cursor + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+		items[i].info.offset = cursor;
+		cursor += items[i].info.stored_size;
+	}
 
-	if(load_to_gpu)
-		engine::get_renderer()->upload_texture(*texture);
+	std::ofstream out(output, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()) {
+		rge::log::error("Could not write pak: %s", output.c_str());
+		return rge::FAIL;
+	}
 
-	return texture;
-	#else
-	LOG_MISSING_DEP(read_texture_from_disk, stb_image.h)
-	return nullptr;
-	#endif
+	out.write((const char*)&head, sizeof(header));
+	for(size_t i = 0; i < items.size(); i++)
+		out.write((const char*)&items[i].info, sizeof(entry));
+	out.write(name_table.data(), name_table.size());
+
+	const char padding[PAGE_SIZE] = { 0 };
+	uint64_t written = head.names_offset + name_table.size();
+	for(size_t i = 0; i < items.size(); i++) {
+		out.write(padding, (std::streamsize)(items[i].info.offset - written));
+		out.write((const char*)items[i].data.data(), items[i].data.size());
+		written = items[i].info.offset + items[i].info.stored_size;
+	}
+
+	if(!out.good()) {
+		rge::log::error("Could not write pak: %s", output.c_str());
+		return rge::FAIL;
+	}
+
+	rge::log::info("Packed %d files into %s", (int)items.size(), output.c_str());
+	return rge::OK;
 }
-//********************************************//
-//* Texture Class                            *//
-//********************************************//
-#pragma endregion
 
+rge::result pak::mount(const std::string& path) {
+	pak::ptr archive = open(path);
+	if(archive == nullptr) return rge::FAIL;
 
-#pragma region /* rge::material */
-//********************************************//
-//* Material Class                           *//
-//********************************************//
-material::ptr material::create() {
-	return std::make_shared<material>();
+	// Most recently mounted archive takes priority.
+	std::lock_guard<std::mutex> lock(mounted_mutex);
+	mounted.insert(mounted.begin(), archive);
+	return rge::OK;
 }
 
-material::material() {
-	diffuse = color(1,1,1);
-	specular = color(1,1,1);
-	shininess = 0;
+void pak::unmount_all() {
+	std::lock_guard<std::mutex> lock(mounted_mutex);
+	mounted.clear();
 }
 
-material::~material() {
-	
+bool pak::find(const std::string& path, const uint8_t*& data, size_t& size, std::vector<uint8_t>& scratch) {
+	std::string normalized = normalize_asset_path(path);
+	uint64_t h = hash_normalized(normalized);
+
+	// Holding the archive keeps it mapped, so it is read outside the lock.
+	pak::ptr archive;
+	const entry* e = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mounted_mutex);
+		for(size_t i = 0; i < mounted.size() && e == nullptr; i++) {
+			e = mounted[i]->find_entry(normalized, h);
+			if(e != nullptr) archive = mounted[i];
+		}
+	}
+	if(e == nullptr) return false;
+
+	data = archive->read_entry(*e, path, size, scratch);
+	return data != nullptr;
 }
-//********************************************//
-//* Material Class                           *//
-//********************************************//
-#pragma endregion
 
+const char* pak::get_entry_name(const entry& e) const {
+	if(e.name_offset >= names_size) return nullptr;
 
-#pragma region /* rge::sprite */
-//********************************************//
-//* Sprite Class                             *//
-//********************************************//
-sprite::ptr sprite::create() {
-	return std::make_shared<sprite>();
+	const char* name = names + e.name_offset;
+	if(memchr(name, '\0', names_size - e.name_offset) == nullptr) return nullptr;
+	return name;
 }
 
-sprite::ptr sprite::create(const rge::texture::ptr& texture) {
-	return std::make_shared<sprite>(texture);
+const pak::entry* pak::find_entry(const std::string& path, uint64_t h) const {
+	if(toc == nullptr) return nullptr;
+
+	int lo = 0;
+	int hi = (int)head->entry_count - 1;
+
+	while(lo <= hi) {
+		int mid = lo + (hi - lo) / 2;
+		if(toc[mid].hash < h) {
+			lo = mid + 1;
+		} else if(toc[mid].hash > h) {
+			hi = mid - 1;
+		} else {
+			// Verify the stored path of every entry with this hash, in case
+			// of a foreign hash.
+			while(mid > 0 && toc[mid - 1].hash == h) mid--;
+			for(; mid < (int)head->entry_count && toc[mid].hash == h; mid++) {
+				const char* name = get_entry_name(toc[mid]);
+				if(name != nullptr && path == name) return &toc[mid];
+			}
+			return nullptr;
+		}
+	}
+
+	return nullptr;
 }
 
-sprite::sprite() {
-	transform = rge::transform::create();
-	centered = false;
-	billboard = false;
-	pixels_per_unit = 32;
+bool pak::contains(const std::string& path) const {
+	std::string normalized = normalize_asset_path(path);
+	return find_entry(normalized, hash_normalized(normalized)) != nullptr;
 }
 
-sprite::sprite(const rge::texture::ptr& texture) : sprite() {
-	this->texture = texture;
+const uint8_t* pak::read(const std::string& path, size_t& size, std::vector<uint8_t>& scratch) const {
+	std::string normalized = normalize_asset_path(path);
+	const entry* e = find_entry(normalized, hash_normalized(normalized));
+	if(e == nullptr) return nullptr;
+
+	return read_entry(*e, path, size, scratch);
 }
 
-sprite::~sprite() {
+const uint8_t* pak::read_entry(const entry& e, const std::string& path, size_t& size, std::vector<uint8_t>& scratch) const {
+	// LZ4 expands at most 255 times, past that the stored size is a lie.
+	bool compressed = (e.flags & FLAG_COMPRESSED) != 0;
+	if(e.offset > mapped_size || e.stored_size > mapped_size - e.offset ||
+	   (!compressed && e.size != e.stored_size) ||
+	   (compressed && e.size > e.stored_size * 255)) {
+		rge::log::error("Pak entry is out of bounds: %s", path.c_str());
+		return nullptr;
+	}
+
+	size = (size_t)e.size;
+
+	if(!compressed)
+		return mapped + e.offset;
+
+	scratch.resize(size);
+	if(!lz4::decompress(mapped + e.offset, (size_t)e.stored_size, scratch.data(), size)) {
+		rge::log::error("Pak entry is corrupt: %s", path.c_str());
+		return nullptr;
+	}
+
+	return scratch.data();
+}
 
+int pak::get_entry_count() const {
+	return head ? (int)head->entry_count : 0;
 }
 //********************************************//
-//* Sprite Class                             *//
+//* Packed Asset Archive Class               *//
 //********************************************//
 #pragma endregion
 
 
-#pragma region /* rge::render_target */
+#pragma region /* rge::texture */
 //********************************************//
-//* Render Target class.                     *//
+//* Texture Class                            *//
 //********************************************//
-render_target::ptr render_target::create(renderer* renderer, int width, int height) {
-	if(renderer == nullptr) return nullptr;
-	if(width < 1) return nullptr;
-	if(height < 1) return nullptr;
+texture::table texture::registry;
 
-	return std::make_shared<render_target>(renderer, width, height);
+texture::ptr texture::create(int width, int height) {
+	ptr texture;
+	texture.reset(new rge::texture(width, height));
+	return texture;
 }
 
-rge::result render_target::resize(int width, int height) {
-	if(width < 1) return rge::FAIL;
-	if(height < 1) return rge::FAIL;
+texture::ptr texture::copy(const texture::ptr& original) {
+	texture::ptr texture = create(original->get_width(), original->get_height());
+	texture->filter = original->filter;
+
+	if(original->is_on_cpu()) {
+		texture->allocate();
+		// TODO: Copy cpu data.
+	}
+
+	if(original->is_on_gpu()) {
+		engine::get_renderer()->alloc_texture(*texture);
+		// TODO: Copy gpu data.
+	}
+
+	return texture;
+}
 
+texture::texture(int width, int height) {
 	this->width = width;
 	this->height = height;
 
-	if(frame_buffer) renderer_instance->free_texture(*frame_buffer);
-	if(depth_buffer) renderer_instance->free_texture(*depth_buffer);
-
-	frame_buffer = renderer_instance->create_texture(width, height);
-	depth_buffer = renderer_instance->create_texture(width, height);
+	filter = texture_filter::NEAREST;
+	wrap = texture_wrap::REPEAT;
+	layout = texture_layout::LINEAR;
+	data = nullptr;
+	handle = 0;
+	capacity = 0;
+}
 
-	return rge::OK;
+texture::~texture() {
+	if(is_on_gpu()) {
+		if(engine::get_instance() && engine::get_instance()->get_renderer())
+			engine::get_instance()->get_renderer()->free_texture(*this);
+	}
+	clear_mipmaps();
+	if(is_on_cpu()) delete[] data;
 }
 
-int render_target::get_width() const {
+int texture::get_width() const {
 	return width;
 }
 
-int render_target::get_height() const {
+int texture::get_height() const {
 	return height;
 }
 
-texture* render_target::get_frame_buffer() const {
-	return frame_buffer.get();
+bool texture::is_on_cpu() const {
+	return data != nullptr;
 }
 
-texture* render_target::get_depth_buffer() const {
-	return depth_buffer.get();
+bool texture::is_on_gpu() const {
+	return handle > 0;
 }
 
-render_target::~render_target() {
-	frame_buffer.reset();
-	depth_buffer.reset();
-}
+color texture::sample(float u, float v) const {
+	if(data == nullptr) return color(0, 0, 0);
 
-render_target::render_target(renderer* renderer, int width, int height) {
-	renderer_instance = renderer;
-	resize(width, height);
+	return sample_level(0, u, v, filter != texture_filter::NEAREST);
 }
-//********************************************//
-//* Render Target class.                     *//
-//********************************************//
-#pragma endregion
 
+color texture::sample(float u, float v, float lod) const {
+	if(data == nullptr) return color(0, 0, 0);
+	if(filter != texture_filter::TRILINEAR || mip_levels.empty()) return sample(u, v);
 
-#pragma region /* rge::renderer */
-//********************************************//
-//* Renderer class.                          *//
-//********************************************//
-renderer::renderer() {
-	input_camera = nullptr;
-	output_render = nullptr;
-	ambient_color = color(0,0,0);
-}
+	int last = (int)mip_levels.size();
+	if(lod <= 0.0F) return sample_level(0, u, v, true);
+	if(lod >= float(last)) return sample_level(last, u, v, true);
 
-void renderer::set_camera(camera::ptr camera) {
-	input_camera = camera;
+	int level = (int)lod;
+	return color::lerp(sample_level(level, u, v, true), sample_level(level + 1, u, v, true), lod - float(level));
 }
 
-void renderer::set_ambience(const color& ambient_color) {
-	this->ambient_color = ambient_color;
-}
+void texture::sample4(const float* u, const float* v, color* out, float lod) const {
+	if(data == nullptr) {
+		for(int i = 0; i < 4; i++) out[i] = color(0, 0, 0);
+		return;
+	}
 
-rge::result renderer::set_target(render_target::ptr target) {
-	output_render = target;
-	return rge::OK;
+	if(filter != texture_filter::TRILINEAR || mip_levels.empty()) {
+		sample_level4(0, u, v, filter != texture_filter::NEAREST, out);
+		return;
+	}
+
+	int last = (int)mip_levels.size();
+	if(lod <= 0.0F || lod >= float(last)) {
+		sample_level4(lod <= 0.0F ? 0 : last, u, v, true, out);
+		return;
+	}
+
+	int level = (int)lod;
+	color upper[4];
+	sample_level4(level, u, v, true, out);
+	sample_level4(level + 1, u, v, true, upper);
+	for(int i = 0; i < 4; i++) out[i] = color::lerp(out[i], upper[i], lod - float(level));
 }
 
-render_target::ptr renderer::get_target() const {
-	return output_render;
+void texture::sample8(const float* u, const float* v, color* out, float lod) const {
+	// Texels are 16 byte RGBA, so each fetch is already one vector load.
+	sample4(u, v, out, lod);
+	sample4(u + 4, v + 4, out + 4, lod);
 }
-//********************************************//
-//* Renderer class.                          *//
-//********************************************//
-#pragma endregion
 
+color texture::sample_level(int level, float u, float v, bool bilinear) const {
+	int w = get_mip_width(level);
+	int h = get_mip_height(level);
 
-#pragma region /* rge::windows */
-//********************************************//
-//* Windows platform class.                  *//
-//********************************************//
-#ifdef SYS_WINDOWS
-// Real win32 entry point for release mode (DesktopApp).
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow) {
-	// TODO: Get entry parameters.
+	// Same fixed-point snapping & float weights as sample_level4(), so
+	// single & batched samples match. Uvs are wrapped first, so large
+	// repeating ones can't overflow the fixed-point range.
+	int xi = (int)lrintf(wrap_coord(u) * float(w << SUBTEXEL_BITS));
+	int yi = (int)lrintf(wrap_coord(v) * float(h << SUBTEXEL_BITS));
 
-	return main(0, nullptr);
-}
+	const color* texels = get_mip_data(level);
+	int stride = get_storage_width(level);
 
-class windows : public platform {
-public:
-	const LPCWSTR CLASS_NAME = L"RETRO_GAME_ENGINE_CLASS";
-	WNDCLASS config;
-	HWND handle;
-	HDC device_context;
+	if(!bilinear) {
+		int x = wrap_texel(xi >> SUBTEXEL_BITS, w);
+		int y = wrap_texel(yi >> SUBTEXEL_BITS, h);
+		return texels[texel_offset(stride, x, y)];
+	}
 
-	int window_width;
-	int window_height;
+	// Texel centers sit at half coords.
+	xi -= 1 << (SUBTEXEL_BITS - 1);
+	yi -= 1 << (SUBTEXEL_BITS - 1);
 
-	bool has_init;
-	bool has_window;
-	bool has_focus;
+	const float step = 1.0F / (1 << SUBTEXEL_BITS);
+	float fx = float(xi & ((1 << SUBTEXEL_BITS) - 1)) * step;
+	float fy = float(yi & ((1 << SUBTEXEL_BITS) - 1)) * step;
 
-	struct {
-		BITMAPINFO bitmap_info;
-		HBITMAP bitmap;
-		void* buffer;
-	} frame;
+	return fetch_bilinear(
+		texels, w, h, stride,
+		xi >> SUBTEXEL_BITS,
+		yi >> SUBTEXEL_BITS,
+		(1.0F - fx) * (1.0F - fy),
+		fx * (1.0F - fy),
+		(1.0F - fx) * fy,
+		fx * fy
+	);
+}
 
+void texture::sample_level4(int level, const float* u, const float* v, bool bilinear, color* out) const {
+	int w = get_mip_width(level);
+	int h = get_mip_height(level);
 
-	static windows* get_instance() {
-		return (windows*)engine::get_platform();
-	}
+	simd::f32x4 uw = simd::load(u);
+	simd::f32x4 vw = simd::load(v);
 
-	windows() {
-		has_init = false;
-		has_window = false;
-		has_focus = false;
-	}
+	// Wrapped like wrap_coord(). simd::floor goes through ints, so uvs are
+	// first limited to 2^23, past which floats have no fraction anyway.
+	if(wrap == texture_wrap::CLAMP) {
+		uw = simd::clamp01(uw);
+		vw = simd::clamp01(vw);
+	} else {
+		simd::f32x4 limit = simd::set1(8388608.0F);
+		simd::f32x4 neg_limit = simd::set1(-8388608.0F);
+		uw = simd::min(simd::max(uw, neg_limit), limit);
+		vw = simd::min(simd::max(vw, neg_limit), limit);
+		uw = simd::sub(uw, simd::floor(uw));
+		vw = simd::sub(vw, simd::floor(vw));
+	}
+
+	simd::i32x4 xi = simd::round_to_int(simd::mul(uw, simd::set1(float(w << SUBTEXEL_BITS))));
+	simd::i32x4 yi = simd::round_to_int(simd::mul(vw, simd::set1(float(h << SUBTEXEL_BITS))));
+
+	const color* texels = get_mip_data(level);
+	int stride = get_storage_width(level);
+	int32_t x[4], y[4];
+
+	if(!bilinear) {
+		simd::store(x, simd::shift_right(xi, SUBTEXEL_BITS));
+		simd::store(y, simd::shift_right(yi, SUBTEXEL_BITS));
+
+		for(int i = 0; i < 4; i++)
+			out[i] = texels[texel_offset(stride, wrap_texel(x[i], w), wrap_texel(y[i], h))];
+		return;
+	}
+
+	// Texel centers sit at half coords.
+	simd::i32x4 half = simd::set1_int(1 << (SUBTEXEL_BITS - 1));
+	simd::i32x4 mask = simd::set1_int((1 << SUBTEXEL_BITS) - 1);
+	xi = simd::sub(xi, half);
+	yi = simd::sub(yi, half);
+
+	// Uvs are snapped to fixed point, the integer part picks the texels &
+	// the subtexel fraction becomes float bilinear weights, all four lanes
+	// at once. Texels are float colors, so they are weighted in float too.
+	simd::f32x4 step = simd::set1(1.0F / (1 << SUBTEXEL_BITS));
+	simd::f32x4 one = simd::set1(1.0F);
+	simd::f32x4 fx = simd::mul(simd::to_float(simd::bit_and(xi, mask)), step);
+	simd::f32x4 fy = simd::mul(simd::to_float(simd::bit_and(yi, mask)), step);
+	simd::f32x4 gx = simd::sub(one, fx);
+	simd::f32x4 gy = simd::sub(one, fy);
+
+	float w00[4], w10[4], w01[4], w11[4];
+	simd::store(w00, simd::mul(gx, gy));
+	simd::store(w10, simd::mul(fx, gy));
+	simd::store(w01, simd::mul(gx, fy));
+	simd::store(w11, simd::mul(fx, fy));
+	simd::store(x, simd::shift_right(xi, SUBTEXEL_BITS));
+	simd::store(y, simd::shift_right(yi, SUBTEXEL_BITS));
+
+	for(int i = 0; i < 4; i++)
+		out[i] = fetch_bilinear(texels, w, h, stride, x[i], y[i], w00[i], w10[i], w01[i], w11[i]);
+}
+
+color texture::fetch_bilinear(const color* texels, int w, int h, int stride, int x0, int y0, float w00, float w10, float w01, float w11) const {
+	int x1 = wrap_texel(x0 + 1, w);
+	int y1 = wrap_texel(y0 + 1, h);
+	x0 = wrap_texel(x0, w);
+	y0 = wrap_texel(y0, h);
+
+	simd::f32x4 sum = simd::mul(simd::load(texels[texel_offset(stride, x0, y0)]), simd::set1(w00));
+	sum = simd::add(sum, simd::mul(simd::load(texels[texel_offset(stride, x1, y0)]), simd::set1(w10)));
+	sum = simd::add(sum, simd::mul(simd::load(texels[texel_offset(stride, x0, y1)]), simd::set1(w01)));
+	sum = simd::add(sum, simd::mul(simd::load(texels[texel_offset(stride, x1, y1)]), simd::set1(w11)));
 
-public:
-	rge::result init(rge::engine* engine) override {
-		if(has_init) return rge::FAIL;
+	color c;
+	simd::store(c, sum);
+	return c;
+}
 
-		ZeroMemory(&config, sizeof(WNDCLASS));
-		config.hIcon = LoadIcon(NULL, IDI_APPLICATION);
-		config.hCursor = LoadCursor(NULL, IDC_ARROW);
-		config.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
-		config.hInstance = GetModuleHandle(nullptr);
-		config.lpfnWndProc = on_event;
-		config.cbClsExtra = 0;
-		config.cbWndExtra = 0;
-		config.lpszMenuName = nullptr;
-		config.hbrBackground = nullptr;
-		config.lpszClassName = CLASS_NAME;
+int texture::wrap_texel(int i, int size) const {
+	if(wrap == texture_wrap::CLAMP) return i < 0 ? 0 : (i >= size ? size - 1 : i);
 
-		if(!RegisterClass(&config)) {
-			rge::log::error("Failed to register platform class (winapi).");
-			return rge::FAIL;
-		}
+	// Power of two sizes wrap with a mask, which also handles negatives.
+	if((size & (size - 1)) == 0) return i & (size - 1);
+	i %= size;
+	return i < 0 ? i + size : i;
+}
 
-		#ifdef SYS_SOFTWARE_GL
-		device_context = CreateCompatibleDC(0);
-		#endif /* SYS_SOFTWARE_GL */
-		
-		has_init = true;
-		return rge::OK;
-	}
+float texture::wrap_coord(float t) const {
+	if(wrap == texture_wrap::CLAMP) return fminf(fmaxf(t, 0.0F), 1.0F);
 
-	rge::result create_window(const std::string& title, int width, int height, bool fullscreen) override {
-		if(!has_init) return rge::FAIL;
-		if(has_window) return rge::FAIL;
+	// Past 2^23 floats have no fraction, limiting keeps infinities finite.
+	t = fminf(fmaxf(t, -8388608.0F), 8388608.0F);
+	return t - floorf(t);
+}
 
-		DWORD style_ex = WS_EX_APPWINDOW | WS_EX_WINDOWEDGE;
-		DWORD style = WS_CAPTION | WS_SYSMENU | WS_VISIBLE | WS_THICKFRAME;
+int texture::get_mip_count() const {
+	return (int)mip_levels.size() + 1;
+}
 
-		RECT rWndRect = { 0, 0, width, height };
-		AdjustWindowRectEx(&rWndRect, style, FALSE, style_ex);
-		window_width = rWndRect.right - rWndRect.left;
-		window_height = rWndRect.bottom - rWndRect.top;
+int texture::get_mip_width(int level) const {
+	return math::max(1, width >> level);
+}
 
-		handle = CreateWindowEx(
-			style_ex,
-			CLASS_NAME,
-			convert_str_to_wstr(title).c_str(),
-			style,
-			CW_USEDEFAULT,
-			CW_USEDEFAULT,
-			window_width,
-			window_height,
-			nullptr,
-			nullptr,
-			config.hInstance,
-			0
-		);
+int texture::get_mip_height(int level) const {
+	return math::max(1, height >> level);
+}
 
-		if(handle == nullptr) {
-			rge::log::error("Failed to create window (winapi).");
-			return rge::FAIL;
-		}
+color* texture::get_mip_data(int level) const {
+	if(level <= 0) return data;
+	if(level > (int)mip_levels.size()) return nullptr;
+	return mip_levels[level - 1];
+}
 
-		// TODO: Add fullscreen
+texture_layout texture::get_layout() const {
+	return layout;
+}
 
-		has_window = true;
-		return rge::OK;
+void texture::set_layout(texture_layout layout) {
+	if(this->layout == layout) return;
+
+	if(data == nullptr) {
+		this->layout = layout;
+		return;
 	}
 
-	static std::wstring convert_str_to_wstr(const std::string& str) {
-		#ifdef __MINGW32__
-		wchar_t* buffer = new wchar_t[str.length() + 1];
-		mbstowcs(buffer, str.c_str(), str.length());
-		buffer[str.length()] = L'\0';
-		#else
-		int count = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, NULL, 0);
-		wchar_t* buffer = new wchar_t[count];
-		MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, buffer, count);
-		#endif
+	// Gather every level out of the old layout, then scatter into the new one.
+	for(int level = 0; level < get_mip_count(); level++) {
+		int w = get_mip_width(level);
+		int h = get_mip_height(level);
+		color* src = get_mip_data(level);
 
-		std::wstring w(buffer);
-		delete[] buffer;
+		texture_layout old_layout = this->layout;
+		std::vector<int> src_index(w * h);
+		for(int y = 0; y < h; y++)
+			for(int x = 0; x < w; x++)
+				src_index[x + y * w] = get_texel_index(level, x, y);
 
-		return w;
+		this->layout = layout;
+		color* dst = new color[get_storage_size(level)];
+		for(int y = 0; y < h; y++)
+			for(int x = 0; x < w; x++)
+				dst[get_texel_index(level, x, y)] = src[src_index[x + y * w]];
+		this->layout = old_layout;
+
+		delete[] src;
+		if(level == 0) {
+			data = dst;
+			capacity = get_storage_size(0);
+		} else {
+			mip_levels[level - 1] = dst;
+		}
 	}
 
-	static rge::input::code convert_sys_key_to_rge_key(uint8_t sys_key) {
-		// If system key is a letter.
-		if(sys_key > 0x40 && sys_key < 0x5B)
-			return (rge::input::code)(sys_key - 0x40);
+	this->layout = layout;
+}
 
-		// If system key is a digit (keypad).
-		if(sys_key > 0x5F && sys_key < 0x6A)
-			return (rge::input::code)(sys_key - 0x60 + 30);
+int texture::get_texel_index(int level, int x, int y) const {
+	int stride = get_storage_width(level);
+	return texel_offset(stride, x, y);
+}
 
-		// If system key is a digit (alpha).
-		if(sys_key > 0x2F && sys_key < 0x3A)
-			return (rge::input::code)(sys_key - 0x30 + 30);
+int texture::get_texel_row_offset(int level, int y) const {
+	int stride = get_storage_width(level);
+	if(layout == texture_layout::LINEAR) return y * stride;
+	return tiled_index(stride, 0, y);
+}
 
-		// Otherwise...
-		switch(sys_key) {
-			case VK_SPACE: return	rge::input::KEY_SPACE;
-			case VK_CAPITAL: return rge::input::KEY_CAPS;
-			case VK_RETURN: return	rge::input::KEY_RETURN;
-			case VK_LEFT: return	rge::input::KEY_LEFT;
-			case VK_UP: return		rge::input::KEY_UP;
-			case VK_RIGHT: return	rge::input::KEY_RIGHT;
-			case VK_DOWN: return	rge::input::KEY_DOWN;
-			case VK_LSHIFT: return	rge::input::KEY_LEFT_SHIFT;
-			case VK_CONTROL: return rge::input::KEY_LEFT_CTRL;
-			case VK_RSHIFT: return	rge::input::KEY_RIGHT_SHIFT;
-			case VK_TAB: return		rge::input::KEY_TAB;
-			case VK_BACK: return	rge::input::KEY_BACKSPACE;
-			case VK_ESCAPE: return	rge::input::KEY_ESC;
+int texture::get_texel_column_offset(int level, int x) const {
+	if(layout == texture_layout::LINEAR) return x;
+	return tiled_index(get_storage_width(level), x, 0);
+}
+
+int texture::get_storage_width(int level) const {
+	int w = get_mip_width(level);
+	if(layout == texture_layout::TILED) return (w + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+	return w;
+}
+
+int texture::get_storage_size(int level) const {
+	int h = get_mip_height(level);
+	if(layout == texture_layout::TILED) h = (h + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+	return get_storage_width(level) * h;
+}
+
+void texture::clear_mipmaps() {
+	for(size_t i = 0; i < mip_levels.size(); i++)
+		delete[] mip_levels[i];
+	mip_levels.clear();
+}
+
+namespace mip {
+	const int TEXELS_PER_JOB = 8192;
+	const int KAISER_TAPS = 6;
+
+	// Zeroth order modified Bessel function of the first kind.
+	inline float bessel_i0(float x) {
+		float sum = 1.0F;
+		float term = 1.0F;
+		for(int k = 1; k < 16; k++) {
+			term *= (x / (2.0F * k)) * (x / (2.0F * k));
+			sum += term;
 		}
+		return sum;
+	}
 
-		return rge::input::NONE;
+	struct kaiser_table {
+		float weights[KAISER_TAPS];
+	};
+
+	inline kaiser_table build_kaiser_table() {
+		const float alpha = 4.0F;
+		const float radius = 3.0F;
+		kaiser_table table;
+		float total = 0.0F;
+		for(int k = 0; k < KAISER_TAPS; k++) {
+			float d = float(k) - 2.5F;
+			float s = PI * d / 2.0F;
+			float sinc = sinf(s) / s;
+			float r = d / radius;
+			table.weights[k] = sinc * bessel_i0(alpha * sqrtf(1.0F - r * r)) / bessel_i0(alpha);
+			total += table.weights[k];
+		}
+		for(int k = 0; k < KAISER_TAPS; k++) table.weights[k] /= total;
+		return table;
 	}
 
-	void set_window_title(const std::string& title) override {
-		if(!has_window) return;
+	// Kaiser windowed sinc weights, for taps at -2.5..2.5 source texels from the destination center.
+	// Built on first use, mip jobs may race to it & a local static initializes once.
+	inline const float* kaiser_weights() {
+		static const kaiser_table table = build_kaiser_table();
+		return table.weights;
+	}
 
-		#ifdef UNICODE
-		SetWindowText(handle, convert_str_to_wstr(title).c_str());
-		#else
-		SetWindowText(handle, title.c_str());
-		#endif
+	inline int wrap(int i, int n) {
+		i %= n;
+		return i < 0 ? i + n : i;
 	}
 
-	void set_window_size(int width, int height) override {
-		// TODO: Test
-		if(width < 1) width = 1;
-		if(height < 1) height = 1;
-		window_width = width;
-		window_height = height;
-		SetWindowPos(handle, NULL, 0, 0, width, height, SWP_NOMOVE | SWP_NOZORDER);
+	void downsample_box(const color* src, int sw, int sh, color* dst, int dw, int dh) {
+		jobs::parallel_for(dh, math::max(1, TEXELS_PER_JOB / dw), [=](int begin, int end) {
+			simd::f32x4 quarter = simd::set1(0.25F);
+
+			for(int y = begin; y < end; y++) {
+				const color* row0 = src + math::min(y * 2, sh - 1) * sw;
+				const color* row1 = src + math::min(y * 2 + 1, sh - 1) * sw;
+
+				for(int x = 0; x < dw; x++) {
+					int x0 = math::min(x * 2, sw - 1);
+					int x1 = math::min(x * 2 + 1, sw - 1);
+					simd::f32x4 sum = simd::add(
+						simd::add(simd::load(row0[x0]), simd::load(row0[x1])),
+						simd::add(simd::load(row1[x0]), simd::load(row1[x1]))
+					);
+					simd::store(dst[x + y * dw], simd::mul(sum, quarter));
+				}
+			}
+		});
 	}
 
-	void set_fullscreen(bool fullscreen) override {
-		// TODO
+	void downsample_kaiser(const color* src, int sw, int sh, color* dst, int dw, int dh) {
+		const float* weights = kaiser_weights();
+		std::vector<color> temp(dw * sh);
+		color* horizontal = temp.data();
+
+		// Horizontal pass, source rows into half width rows.
+		jobs::parallel_for(sh, math::max(1, TEXELS_PER_JOB / dw), [=](int begin, int end) {
+			for(int y = begin; y < end; y++) {
+				const color* row = src + y * sw;
+				for(int x = 0; x < dw; x++) {
+					simd::f32x4 sum = simd::set1(0.0F);
+					for(int k = 0; k < KAISER_TAPS; k++)
+						sum = simd::add(sum, simd::mul(simd::load(row[wrap(x * 2 - 2 + k, sw)]), simd::set1(weights[k])));
+					simd::store(horizontal[x + y * dw], sum);
+				}
+			}
+		});
+
+		// Vertical pass, half width rows into destination.
+		jobs::parallel_for(dh, math::max(1, TEXELS_PER_JOB / dw), [=](int begin, int end) {
+			for(int y = begin; y < end; y++) {
+				for(int x = 0; x < dw; x++) {
+					simd::f32x4 sum = simd::set1(0.0F);
+					for(int k = 0; k < KAISER_TAPS; k++)
+						sum = simd::add(sum, simd::mul(simd::load(horizontal[x + wrap(y * 2 - 2 + k, sh) * dw]), simd::set1(weights[k])));
+					simd::store(dst[x + y * dw], simd::clamp01(sum));
+				}
+			}
+		});
 	}
+}
 
-	void poll_events() override {
-		if(!has_window) return;
+void texture::generate_mipmaps(mip_filter mode) {
+	if(data == nullptr) return;
 
-		MSG msg;
+	clear_mipmaps();
 
-		while(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE) > 0) {
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-		}
+	// Filters walk rows, so build the chain linear and convert back after.
+	texture_layout final_layout = layout;
+	set_layout(texture_layout::LINEAR);
+
+	const color* src = data;
+	int w = width;
+	int h = height;
+
+	while(w > 1 || h > 1) {
+		int dw = math::max(1, w / 2);
+		int dh = math::max(1, h / 2);
+		color* dst = new color[dw * dh];
+
+		if(mode == mip_filter::KAISER)
+			mip::downsample_kaiser(src, w, h, dst, dw, dh);
+		else
+			mip::downsample_box(src, w, h, dst, dw, dh);
+
+		mip_levels.push_back(dst);
+		src = dst;
+		w = dw;
+		h = dh;
 	}
 
-	void refresh_window() override {
-		if(!has_window) return;
+	set_layout(final_layout);
+}
 
-		#ifdef SYS_SOFTWARE_GL
-		InvalidateRect(handle, NULL, FALSE);
-		UpdateWindow(handle);
-		#elif SYS_OPENGL_1_0
-		// TODO
-		// SwapBuffers();
-		#endif
+color* texture::get_data() const {
+	return data;
+}
+
+uint32_t texture::get_handle() const {
+	return handle;
+}
+
+namespace letterbox {
+	// Largest scale fitting the texture in the buffer with its aspect ratio
+	// kept, whole if asked & the buffer is larger.
+	inline float fit_scale(int buffer_width, int buffer_height, int width, int height, bool whole) {
+		float scale = fminf((float)buffer_width / width, (float)buffer_height / height);
+		return whole && scale >= 1.0F ? floorf(scale) : scale;
 	}
 
-	static LRESULT CALLBACK on_event(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-		switch(msg) {
-			case WM_CLOSE: {
-				window_close_requested_event e;
-				engine::get_instance()->post_event(e);
-				break;
+	// Black bars around the image rect, opaque in either byte order.
+	inline void fill_bars(uint32_t* pixels, int buffer_width, int buffer_height, int x, int y, int width, int height) {
+		const uint32_t black = 0xFF000000;
+		for(int row = 0; row < buffer_height; row++) {
+			uint32_t* p = pixels + row * buffer_width;
+			if(row < y || row >= y + height) {
+				std::fill(p, p + buffer_width, black);
+			} else {
+				std::fill(p, p + x, black);
+				std::fill(p + x + width, p + buffer_width, black);
 			}
+		}
+	}
 
-			case WM_DESTROY: {
-				PostQuitMessage(0);
-				DestroyWindow(hwnd);
-				break;
-			}
+	// Whole factor nearest scaling of a width x height image. Each source
+	// row is converted to 32 bit pixels once, then spread through a column
+	// table & repeated.
+	inline void scale_nearest(uint32_t* pixels, int buffer_width, int buffer_height, int width, int height, const std::function<void(int y, uint32_t* row)>& convert_row) {
+		float scale = fit_scale(buffer_width, buffer_height, width, height, true);
+		int out_width = math::clamp((int)(width * scale + 0.5F), 1, buffer_width);
+		int out_height = math::clamp((int)(height * scale + 0.5F), 1, buffer_height);
+		int out_x = (buffer_width - out_width) / 2;
+		int out_y = (buffer_height - out_height) / 2;
+		fill_bars(pixels, buffer_width, buffer_height, out_x, out_y, out_width, out_height);
 
-			case WM_SIZE: {
-				window_resized_event e;
-				e.width = LOWORD(lParam);
-				e.height = HIWORD(lParam);
+		std::vector<int> columns(out_width);
+		for(int x = 0; x < out_width; x++)
+			columns[x] = math::min((int)((x + 0.5F) / scale), width - 1);
 
-				get_instance()->create_frame(e.width, e.height);
-				engine::get_instance()->post_event(e);
-				break;
-			}
+		std::vector<uint32_t> converted(width);
+		int converted_y = -1;
 
-			case WM_MOVE: {
-				window_moved_event e;
-				e.x = (int)(short)LOWORD(lParam); // Horizontal position.
-				e.y = (int)(short)HIWORD(lParam); // Vertical position.
-				engine::get_instance()->post_event(e);
-				break;
-			}
+		for(int y = 0; y < out_height; y++) {
+			int sy = math::min((int)((y + 0.5F) / scale), height - 1);
+			uint32_t* dest = pixels + out_x + (out_y + y) * buffer_width;
 
-			case WM_KILLFOCUS: {
-				get_instance()->has_focus = false;
-				window_unfocused_event e;
-				engine::get_instance()->post_event(e);
-				break;
+			if(sy == converted_y) {
+				memcpy(dest, dest - buffer_width, out_width * sizeof(uint32_t));
+				continue;
 			}
 
-			case WM_SETFOCUS: {
-				get_instance()->has_focus = true;
-				window_focused_event e;
-				engine::get_instance()->post_event(e);
-				break;
-			}
-			
-			case WM_KEYUP: {
-				key_released_event e;
-				e.input_code = convert_sys_key_to_rge_key((uint8_t)wParam);
-				engine::get_instance()->post_event(e);
-				break;
+			convert_row(sy, converted.data());
+			converted_y = sy;
+
+			for(int x = 0; x < out_width; x++)
+				dest[x] = converted[columns[x]];
+		}
+	}
+}
+
+void texture::dump_to_raw_buffer(uint8_t* buffer, pixel_format format, bool dither) const {
+	if(!is_on_cpu()) return;
+
+	for(int y = 0; y < height; y++)
+		dump_row_to_raw_buffer(y, buffer + y * width * 4, format, dither);
+}
+
+void texture::dump_to_raw_buffer(uint8_t* buffer, int buffer_width, int buffer_height, texture_filter filter, pixel_format format, bool dither) const {
+	if(!is_on_cpu() || buffer_width < 1 || buffer_height < 1) return;
+
+	if(buffer_width == width && buffer_height == height) {
+		dump_to_raw_buffer(buffer, format, dither);
+		return;
+	}
+
+	if(filter == texture_filter::NEAREST) {
+		letterbox::scale_nearest((uint32_t*)buffer, buffer_width, buffer_height, width, height, [&](int y, uint32_t* row) {
+			dump_row_to_raw_buffer(y, (uint8_t*)row, format, dither);
+		});
+		return;
+	}
+
+	float scale = letterbox::fit_scale(buffer_width, buffer_height, width, height, false);
+	int out_width = math::clamp((int)(width * scale + 0.5F), 1, buffer_width);
+	int out_height = math::clamp((int)(height * scale + 0.5F), 1, buffer_height);
+	int out_x = (buffer_width - out_width) / 2;
+	int out_y = (buffer_height - out_height) / 2;
+	uint32_t* pixels = (uint32_t*)buffer;
+	letterbox::fill_bars(pixels, buffer_width, buffer_height, out_x, out_y, out_width, out_height);
+
+	// Sharp bilinear, a blend only within a pixel of each texel edge.
+	std::vector<int> columns(out_width);
+	std::vector<float> blends(out_width);
+	for(int x = 0; x < out_width; x++) {
+		float t = (x + 0.5F) / scale - 0.5F;
+		float base = floorf(t);
+		columns[x] = (int)base;
+		blends[x] = fminf(fmaxf((t - base - 0.5F) * scale + 0.5F, 0.0F), 1.0F);
+	}
+
+	simd::f32x4 byte_scale = simd::set1(255.0F);
+	bool swap = format == pixel_format::BGRA8;
+	std::vector<color> blended(width);
+	simd::i32x4 bytes[4];
+	int32_t lanes[4];
+	int last_y0 = -1, last_y1 = -1;
+	float last_blend = -1.0F;
+
+	for(int y = 0; y < out_height; y++) {
+		float t = (y + 0.5F) / scale - 0.5F;
+		float base = floorf(t);
+		float blend = fminf(fmaxf((t - base - 0.5F) * scale + 0.5F, 0.0F), 1.0F);
+		int y0 = math::clamp((int)base, 0, height - 1);
+		int y1 = math::clamp((int)base + 1, 0, height - 1);
+		uint32_t* dest = pixels + out_x + (out_y + y) * buffer_width;
+
+		// Rows away from texel edges repeat the one above.
+		if(y0 == last_y0 && y1 == last_y1 && blend == last_blend) {
+			memcpy(dest, dest - buffer_width, out_width * sizeof(uint32_t));
+			continue;
+		}
+
+		last_y0 = y0;
+		last_y1 = y1;
+		last_blend = blend;
+
+		simd::f32x4 wy = simd::set1(blend);
+		for(int x = 0; x < width; x++)
+			simd::store(blended[x], simd::lerp(simd::load(data[get_texel_index(0, x, y0)]), simd::load(data[get_texel_index(0, x, y1)]), wy));
+
+		for(int x = 0; x < out_width; x += 4) {
+			int count = math::min(4, out_width - x);
+			for(int i = 0; i < count; i++) {
+				int c0 = math::clamp(columns[x + i], 0, width - 1);
+				int c1 = math::clamp(columns[x + i] + 1, 0, width - 1);
+				simd::f32x4 c = simd::clamp01(simd::lerp(simd::load(blended[c0]), simd::load(blended[c1]), simd::set1(blends[x + i])));
+				if(swap) c = simd::swap_rb(c);
+				bytes[i] = simd::round_to_int(simd::mul(c, byte_scale));
 			}
 
-			case WM_KEYDOWN: {
-				bool key_was_down = ((lParam & (1 << 30)) != 0);
-				if(!key_was_down) {
-					key_pressed_event e;
-					e.input_code = convert_sys_key_to_rge_key((uint8_t)wParam);
-					engine::get_instance()->post_event(e);
+			if(count == 4) {
+				simd::store_bytes((uint8_t*)(dest + x), bytes[0], bytes[1], bytes[2], bytes[3]);
+			} else {
+				for(int i = 0; i < count; i++) {
+					simd::store(lanes, bytes[i]);
+					uint8_t* p = (uint8_t*)(dest + x + i);
+					for(int j = 0; j < 4; j++) p[j] = (uint8_t)lanes[j];
 				}
-				break;
 			}
+		}
+	}
+}
 
-			case WM_LBUTTONDOWN: {
-				mouse_pressed_event e;
-				e.input_code = rge::input::MOUSE_LEFT;
-				engine::get_instance()->post_event(e);
-				break;
-			}
-
-			case WM_RBUTTONDOWN: {
-				mouse_pressed_event e;
-				e.input_code = rge::input::MOUSE_RIGHT;
-				engine::get_instance()->post_event(e);
-				break;
-			}
-
-			case WM_MBUTTONDOWN: {
-				mouse_pressed_event e;
-				e.input_code = rge::input::MOUSE_MIDDLE;
-				engine::get_instance()->post_event(e);
-				break;
-			}
-
-			case WM_LBUTTONUP: {
-				mouse_released_event e;
-				e.input_code = rge::input::MOUSE_LEFT;
-				engine::get_instance()->post_event(e);
-				break;
-			}
-
-			case WM_RBUTTONUP: {
-				mouse_released_event e;
-				e.input_code = rge::input::MOUSE_RIGHT;
-				engine::get_instance()->post_event(e);
-				break;
-			}
+void texture::dump_row_to_raw_buffer(int y, uint8_t* dest, pixel_format format, bool dither) const {
+	// 4x4 Bayer matrix, in 1/16ths of a byte step.
+	static const float bayer[16] = { 0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5 };
 
-			case WM_MBUTTONUP: {
-				mouse_released_event e;
-				e.input_code = rge::input::MOUSE_MIDDLE;
-				engine::get_instance()->post_event(e);
-				break;
-			}
+	simd::f32x4 scale = simd::set1(255.0F);
+	bool swap = format == pixel_format::BGRA8;
+	bool linear = layout == texture_layout::LINEAR;
+	simd::i32x4 bytes[4];
+	int32_t lanes[4];
 
-			case WM_MOUSEMOVE: {
-				mouse_moved_event e;
-				e.x = (int)(short)LOWORD(lParam); // Horizontal position.
-				e.y = (int)(short)HIWORD(lParam); // Vertical position.
-				engine::get_instance()->post_event(e);
-				break;
-			}
+	// Rounding offsets of the 4 columns a group covers.
+	simd::f32x4 offsets[4];
+	for(int i = 0; i < 4; i++)
+		offsets[i] = simd::set1(dither ? (bayer[(y & 3) * 4 + i] + 0.5F) / 16.0F - 0.5F : 0.0F);
 
-			case WM_MOUSEWHEEL: {
-				mouse_scrolled_event e;
-				e.scroll = (short)HIWORD(wParam) / 120;
-				engine::get_instance()->post_event(e);
-				break;
-			}
+	const color* row = linear ? data + y * width : nullptr;
 
-			default: {
-				return DefWindowProc(hwnd, msg, wParam, lParam);
-			}
+	int x = 0;
+	for(; x + 4 <= width; x += 4) {
+		for(int i = 0; i < 4; i++) {
+			simd::f32x4 c = simd::clamp01(simd::load(linear ? row[x + i] : data[get_texel_index(0, x + i, y)]));
+			if(swap) c = simd::swap_rb(c);
+			bytes[i] = simd::round_to_int(simd::add(simd::mul(c, scale), offsets[i]));
 		}
 
-		return 0;
+		simd::store_bytes(dest + x * 4, bytes[0], bytes[1], bytes[2], bytes[3]);
 	}
 
-	inline void post_gamepad_axis(float v, input::code ic, int u) {
-		gamepad_axis_event e;
-		e.input_code = ic;
-		e.user = u;
-		e.value = v;
-		engine::get_instance()->post_event(e);
+	for(; x < width; x++) {
+		simd::f32x4 c = simd::clamp01(simd::load(linear ? row[x] : data[get_texel_index(0, x, y)]));
+		if(swap) c = simd::swap_rb(c);
+		simd::store(lanes, simd::round_to_int(simd::add(simd::mul(c, scale), offsets[x & 3])));
+		for(int i = 0; i < 4; i++) dest[x * 4 + i] = (uint8_t)lanes[i];
 	}
+}
 
-	void poll_gamepads() override {
-		for(int u = 0; u < input::MAX_GAMEPAD_COUNT; u++) {
-			XINPUT_STATE state;
-			if(XInputGetState(u, &state) != ERROR_SUCCESS)
-				continue;
+rge::result texture::write_to_disk(const std::string& path) const {
+	if(!is_on_cpu()) return rge::FAIL;
 
-			post_gamepad_axis(float(state.Gamepad.bLeftTrigger) / 255, input::GAMEPAD_LEFT_TRIGGER, u);
-			post_gamepad_axis(float(state.Gamepad.bRightTrigger) / 255, input::GAMEPAD_RIGHT_TRIGGER, u);
-			post_gamepad_axis(fmaxf(-1, (float)state.Gamepad.sThumbLX / 32767), input::GAMEPAD_LEFT_STICK_X, u);
-			post_gamepad_axis(fmaxf(-1, (float)state.Gamepad.sThumbLY / 32767), input::GAMEPAD_LEFT_STICK_Y, u);
-			post_gamepad_axis(fmaxf(-1, (float)state.Gamepad.sThumbRX / 32767), input::GAMEPAD_RIGHT_STICK_X, u);
-			post_gamepad_axis(fmaxf(-1, (float)state.Gamepad.sThumbRY / 32767), input::GAMEPAD_RIGHT_STICK_Y, u);
+	#ifdef RGE_USE_STB_IMAGE_WRITE
+	uint8_t* buffer = (uint8_t*)malloc(4 * width * height);
+	dump_to_raw_buffer(buffer);
+	
+	if(!stbi_write_bmp(path.c_str(), width, height, 4, buffer)) {
+		rge::log::error("File write fail.");
+		free(buffer);
+		return rge::FAIL;
+	} else {
+		free(buffer);
+		return rge::OK;
+	}
+	#else
+	LOG_MISSING_DEP(write_texture_to_disk, stb_image_write.h)
+	return rge::FAIL;
+	#endif
+}
 
-			// Generate gamepad button events.
-			int i;
-			int mask;
-			bool is_pressed;
-			bool was_pressed;
-			for(i = input::GAMEPAD_UP; i <= input::GAMEPAD_START; i++) {
-				switch(i) {
-					case input::GAMEPAD_UP:
-						mask = 0x0001;
-						break;
-					case input::GAMEPAD_DOWN:
-						mask = 0x0002;
-						break;
-					case input::GAMEPAD_LEFT:
-						mask = 0x0004;
-						break;
-					case input::GAMEPAD_RIGHT:
-						mask = 0x0008;
-						break;
+void texture::allocate() {
+	if(data) return;
+	capacity = get_storage_size(0);
+	data = new color[capacity];
+}
 
-					case input::GAMEPAD_NORTH:
-						mask = 0x8000;
-						break;
-					case input::GAMEPAD_SOUTH:
-						mask = 0x1000;
-						break;
-					case input::GAMEPAD_WEST:
-						mask = 0x4000;
-						break;
-					case input::GAMEPAD_EAST:
-						mask = 0x2000;
-						break;
+rge::result texture::reshape(int width, int height) {
+	if(width < 1 || height < 1) return rge::FAIL;
+	if(layout != texture_layout::LINEAR || !mip_levels.empty()) return rge::FAIL;
+	if(is_on_cpu() && width * height > capacity) return rge::FAIL;
 
-					case input::GAMEPAD_LEFT_BUMPER:
-						mask = 0x0100;
-						break;
-					case input::GAMEPAD_RIGHT_BUMPER:
-						mask = 0x0200;
-						break;
+	this->width = width;
+	this->height = height;
 
-					case input::GAMEPAD_LEFT_STICK:
-						mask = 0x0040;
-						break;
-					case input::GAMEPAD_RIGHT_STICK:
-						mask = 0x0080;
-						break;
+	return rge::OK;
+}
 
-					case input::GAMEPAD_OPTIONS:
-						mask = 0x0020;
-						break;
-					case input::GAMEPAD_START:
-						mask = 0x0010;
-						break;
+void texture::flush_registry() {
+	for(auto it = registry.begin(); it != registry.end(); it++) {
+		if(it->second.use_count() <= 1) {
+			// TODO: Last ref texture is in table itself, therefore we free the memory.
+		}
+	}
+}
 
-					default:
-						continue;
-				}
+texture::ptr texture::load(const std::string& path, bool load_to_gpu) {
+	if(registry.count(path) > 0) {
+		texture::ptr t = registry.find(path)->second;
+		if(load_to_gpu && !t->is_on_gpu())
+			engine::get_renderer()->upload_texture(*t);
+		return t;
+	}
 
-				is_pressed = state.Gamepad.wButtons & mask;
-				was_pressed = input::is_down((input::code)i, u);
+	texture::ptr texture;
 
-				if(is_pressed && !was_pressed) {
-					gamepad_pressed_event e;
-					e.input_code = (input::code)i;
-					e.user = u;
-					engine::get_instance()->post_event(e);
-				} else if(!is_pressed && was_pressed) {
-					gamepad_released_event e;
-					e.input_code = (input::code)i;
-					e.user = u;
-					engine::get_instance()->post_event(e);
-				}
-			}
+	// Prefer mounted archives, reading straight from the mapped file.
+	const uint8_t* packed_data;
+	size_t packed_size;
+	std::vector<uint8_t> scratch;
+	if(pak::find(path, packed_data, packed_size, scratch)) {
+		texture = load_from_memory(packed_data, packed_size, false);
+		if(texture == nullptr) {
+			rge::log::error("Could not load texture: %s", path.c_str());
+			return nullptr;
+		}
+	} else if(is_baked_path(path)) {
+		texture = read_baked_from_disk(path);
+		if(texture == nullptr) return nullptr;
+	} else {
+		#ifdef RGE_USE_STB_IMAGE
+		int w, h, ch;
+		uint8_t* input_buffer = stbi_load(path.c_str(), &w, &h, &ch, 4);
+
+		if(!input_buffer) {
+			rge::log::error("Could not load texture: %s", path.c_str());
+			return nullptr;
 		}
+
+		texture = create_from_raw_buffer(input_buffer, w, h, ch);
+		stbi_image_free(input_buffer);
+
+		if(texture == nullptr) return nullptr;
+		#else
+		LOG_MISSING_DEP(read_texture_from_disk, stb_image.h)
+		return nullptr;
+		#endif
 	}
 
-	void create_frame(int width, int height) {
-		window_width = width;
-		window_height = height;
-		#ifdef SYS_SOFTWARE_GL
-		frame.bitmap_info.bmiHeader.biWidth = width;
-		frame.bitmap_info.bmiHeader.biHeight = height;
+	registry.insert(std::pair<std::string, texture::ptr>(path, texture));
 
-		if(frame.bitmap)
-			DeleteObject(frame.bitmap);
+	if(load_to_gpu)
+		engine::get_renderer()->upload_texture(*texture);
 
-		frame.bitmap = CreateDIBSection(NULL, &frame.bitmap_info, DIB_RGB_COLORS, &frame.buffer, 0, 0);
-		if(frame.bitmap == NULL)
-			return;
+	return texture;
+}
 
-		SelectObject(device_context, frame.bitmap);
-		#endif /* SYS_SOFTWARE_GL */
-	}
+texture::ptr texture::load_from_memory(const uint8_t* buffer, size_t size, bool load_to_gpu) {
+	texture::ptr texture;
 
-	uint8_t* get_frame_buffer() {
-		return (uint8_t*)frame.buffer;
+	if(size >= sizeof(baked_header) && ((const baked_header*)buffer)->magic == BAKED_MAGIC) {
+		texture = create_from_baked_buffer(buffer, size);
+	} else {
+		#ifdef RGE_USE_STB_IMAGE
+		int w, h, ch;
+		uint8_t* input_buffer = stbi_load_from_memory(buffer, (int)size, &w, &h, &ch, 4);
+
+		if(!input_buffer) {
+			rge::log::error("Could not decode texture from memory!");
+			return nullptr;
+		}
+
+		texture = create_from_raw_buffer(input_buffer, w, h, ch);
+		stbi_image_free(input_buffer);
+		#else
+		LOG_MISSING_DEP(read_texture_from_memory, stb_image.h)
+		return nullptr;
+		#endif
 	}
 
-	bool is_focused() const override {
-		return has_focus;
+	if(texture != nullptr && load_to_gpu)
+		engine::get_renderer()->upload_texture(*texture);
+
+	return texture;
+}
+
+texture::ptr texture::create_from_raw_buffer(const uint8_t* input_buffer, int w, int h, int ch) {
+	if(ch != 3 && ch != 4) {
+		rge::log::error("Texture file read failed: only RGB & RGBA formats supported!");
+		return nullptr;
 	}
 
-	void clean_up() override {
+	texture::ptr texture = create(w, h);
+	texture->allocate();
 
+	// Input buffer is always expanded to 4 channels by the decoder.
+	color* tex_data = texture->get_data();
+	for(int i = 0; i < w * h; ++i) {
+		tex_data[i] = color(
+			input_buffer[i * 4] / 255.0F,
+			input_buffer[i * 4 + 1] / 255.0F,
+			input_buffer[i * 4 + 2] / 255.0F,
+			ch == 4 ? input_buffer[i * 4 + 3] / 255.0F : 1.0F
+		);
 	}
-};
-#endif /* SYS_WINDOWS */
-//********************************************//
-//* Windows platform class.                  *//
-//********************************************//
-#pragma endregion
 
+	return texture;
+}
 
-#pragma region /* rge::linux */
-//********************************************//
-//* Linux platform class.                    *//
-//********************************************//
-#ifdef SYS_LINUX
-class linux : public platform {
+bool texture::is_baked_path(const std::string& path) {
+	const std::string ext = ".rtex";
+	return path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
 
-};
-#endif /* SYS_LINUX */
-//********************************************//
-//* Linux platform class.                    *//
-//********************************************//
-#pragma endregion
+uint64_t texture::get_baked_payload_size(const baked_header& head) {
+	if(head.magic != BAKED_MAGIC || head.version != BAKED_VERSION) return 0;
+	if(head.format != (uint32_t)texture_format::RGBA32F) return 0;
+	if(head.filter > (uint32_t)texture_filter::TRILINEAR) return 0;
+	if(head.layout > (uint32_t)texture_layout::TILED) return 0;
+	if(head.width < 1 || head.width > (uint32_t)BAKED_MAX_SIZE) return 0;
+	if(head.height < 1 || head.height > (uint32_t)BAKED_MAX_SIZE) return 0;
 
+	// Levels halve down to 1x1, no further.
+	uint32_t levels = 1;
+	while((head.width >> levels) > 0 || (head.height >> levels) > 0) levels++;
+	if(head.mip_count < 1 || head.mip_count > levels) return 0;
 
-#pragma region /* rge::macosx */
+	uint64_t size = 0;
+	for(uint32_t level = 0; level < head.mip_count; level++) {
+		uint64_t w = math::max(1, (int)(head.width >> level));
+		uint64_t h = math::max(1, (int)(head.height >> level));
+		if(head.layout == (uint32_t)texture_layout::TILED) {
+			w = (w + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+			h = (h + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+		}
+		size += w * h * sizeof(color);
+	}
+	return size;
+}
+
+texture::ptr texture::create_from_baked_header(const baked_header& head) {
+	texture::ptr texture = create((int)head.width, (int)head.height);
+	texture->filter = (texture_filter)head.filter;
+	texture->layout = (texture_layout)head.layout;
+	texture->allocate();
+	return texture;
+}
+
+texture::ptr texture::create_from_baked_buffer(const uint8_t* buffer, size_t size) {
+	baked_header head;
+	if(size < sizeof(baked_header)) {
+		rge::log::error("Baked texture is truncated!");
+		return nullptr;
+	}
+	memcpy(&head, buffer, sizeof(baked_header));
+
+	uint64_t payload = get_baked_payload_size(head);
+	if(payload == 0) {
+		rge::log::error("Baked texture has unsupported header!");
+		return nullptr;
+	}
+
+	if(payload > size - sizeof(baked_header)) {
+		rge::log::error("Baked texture is truncated!");
+		return nullptr;
+	}
+
+	texture::ptr texture = create_from_baked_header(head);
+
+	// Texel data is already in the in-memory layout, levels stored back to back.
+	size_t offset = sizeof(baked_header);
+	for(int level = 0; level < (int)head.mip_count; level++) {
+		size_t level_size = (size_t)texture->get_storage_size(level) * sizeof(color);
+		if(level > 0) texture->mip_levels.push_back(new color[texture->get_storage_size(level)]);
+		memcpy(texture->get_mip_data(level), buffer + offset, level_size);
+		offset += level_size;
+	}
+
+	return texture;
+}
+
+texture::ptr texture::read_baked_from_disk(const std::string& path) {
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if(!in.is_open()) {
+		rge::log::error("Could not load texture: %s", path.c_str());
+		return nullptr;
+	}
+
+	uint64_t file_size = (uint64_t)in.tellg();
+	in.seekg(0);
+
+	baked_header head;
+	in.read((char*)&head, sizeof(baked_header));
+
+	uint64_t payload = in.good() ? get_baked_payload_size(head) : 0;
+	if(payload == 0) {
+		rge::log::error("Baked texture has unsupported header: %s", path.c_str());
+		return nullptr;
+	}
+
+	// Sized from the file before allocating, so a bad header can't ask for more.
+	if(payload > file_size - sizeof(baked_header)) {
+		rge::log::error("Baked texture is truncated: %s", path.c_str());
+		return nullptr;
+	}
+
+	texture::ptr texture = create_from_baked_header(head);
+
+	// One read per level, straight into the texel buffers.
+	for(int level = 0; level < (int)head.mip_count; level++) {
+		int count = texture->get_storage_size(level);
+		if(level > 0) texture->mip_levels.push_back(new color[count]);
+
+		in.read((char*)texture->get_mip_data(level), (std::streamsize)count * sizeof(color));
+		if(!in.good()) {
+			rge::log::error("Baked texture is truncated: %s", path.c_str());
+			return nullptr;
+		}
+	}
+
+	return texture;
+}
+
+rge::result texture::write_baked_to_disk(const std::string& path) const {
+	if(!is_on_cpu()) return rge::FAIL;
+
+	baked_header head;
+	head.magic = BAKED_MAGIC;
+	head.version = BAKED_VERSION;
+	head.width = (uint32_t)width;
+	head.height = (uint32_t)height;
+	head.format = (uint32_t)texture_format::RGBA32F;
+	head.filter = (uint32_t)filter;
+	head.mip_count = (uint32_t)get_mip_count();
+	head.layout = (uint32_t)layout;
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()) {
+		rge::log::error("File write fail.");
+		return rge::FAIL;
+	}
+
+	out.write((const char*)&head, sizeof(baked_header));
+	for(int level = 0; level < get_mip_count(); level++)
+		out.write((const char*)get_mip_data(level), (std::streamsize)get_storage_size(level) * sizeof(color));
+
+	return out.good() ? rge::OK : rge::FAIL;
+}
 //********************************************//
-//* MacOS X platform class.                  *//
+//* Texture Class                            *//
 //********************************************//
-#ifdef SYS_MACOSX
-class macosx : public platform {
-private:
-	int window_width;
-	int window_height;
-	std::function<void()> loop_func;
+#pragma endregion
 
-	static macosx* get_instance() {
-		return (macosx*)engine::get_platform();
+
+#pragma region /* rge::palette */
+//********************************************//
+//* Palette Class                            *//
+//********************************************//
+palette::ptr palette::create(const std::vector<color>& colors) {
+	if(colors.empty() || (int)colors.size() > MAX_COLORS) return nullptr;
+
+	return std::make_shared<palette>(colors);
+}
+
+palette::palette(const std::vector<color>& colors) {
+	this->colors = colors;
+}
+
+int palette::get_size() const {
+	return (int)colors.size();
+}
+
+color palette::get_color(int index) const {
+	if(index < 0 || index >= (int)colors.size()) return color(0, 0, 0);
+	return colors[index];
+}
+
+void palette::set_color(int index, const color& c) {
+	if(index < 0 || index >= (int)colors.size()) return;
+	colors[index] = c;
+}
+
+void palette::rotate(int first, int last, int count) {
+	first = math::max(first, 0);
+	last = math::min(last, (int)colors.size() - 1);
+	if(first >= last) return;
+
+	int length = last - first + 1;
+	count = ((count % length) + length) % length;
+	std::rotate(colors.begin() + first, colors.begin() + last + 1 - count, colors.begin() + last + 1);
+}
+
+uint8_t palette::find_nearest(const color& c) const {
+	int best = 0;
+	float best_distance = -1.0F;
+
+	for(int i = 0; i < (int)colors.size(); i++) {
+		float dr = colors[i].r - c.r;
+		float dg = colors[i].g - c.g;
+		float db = colors[i].b - c.b;
+		float distance = dr * dr + dg * dg + db * db;
+
+		if(best_distance < 0.0F || distance < best_distance) {
+			best = i;
+			best_distance = distance;
+		}
 	}
 
-public:
-	macosx() {
-		window_width = 800;
-		window_height = 600;
+	return (uint8_t)best;
+}
+
+void palette::pack(uint32_t* out, pixel_format format) const {
+	for(int i = 0; i < MAX_COLORS; i++) {
+		color c = get_color(i);
+		if(i >= (int)colors.size()) c.a = 1.0F;
+
+		uint8_t r = (uint8_t)(fminf(fmaxf(c.r, 0.0F), 1.0F) * 255.0F + 0.5F);
+		uint8_t g = (uint8_t)(fminf(fmaxf(c.g, 0.0F), 1.0F) * 255.0F + 0.5F);
+		uint8_t b = (uint8_t)(fminf(fmaxf(c.b, 0.0F), 1.0F) * 255.0F + 0.5F);
+		uint8_t a = (uint8_t)(fminf(fmaxf(c.a, 0.0F), 1.0F) * 255.0F + 0.5F);
+		uint8_t bytes[4] = { r, g, b, a };
+		if(format == pixel_format::BGRA8) std::swap(bytes[0], bytes[2]);
+
+		memcpy(&out[i], bytes, sizeof(uint32_t));
 	}
+}
+//********************************************//
+//* Palette Class                            *//
+//********************************************//
+#pragma endregion
 
-	rge::result init(rge::engine* engine) override {
-		Class GLUTViewClass = objc_getClass("GLUTView");
 
-		// SEL scrollWheelSel = sel_registerName("scrollWheel:");
-		// bool resultAddMethod = class_addMethod(GLUTViewClass, scrollWheelSel, (IMP)scrollWheelUpdate, "v@:@");
-		// assert(resultAddMethod);
+#pragma region /* rge::indexed_texture */
+//********************************************//
+//* Indexed Texture Class                    *//
+//********************************************//
+indexed_texture::ptr indexed_texture::create(int width, int height) {
+	if(width < 1) return nullptr;
+	if(height < 1) return nullptr;
 
-		int argc = 0;
-		char* argv[1] = { (char*)"" };
-		glutInit(&argc, argv);
-		glutInitWindowPosition(0, 0);
-		glutInitWindowSize(window_width, window_height);
-		glutInitDisplayMode(GLUT_SINGLE | GLUT_DEPTH | GLUT_RGBA);
+	return std::make_shared<indexed_texture>(width, height);
+}
 
-		return rge::OK;
+indexed_texture::ptr indexed_texture::load(const std::string& path, const palette& palette, uint8_t transparent_index) {
+	texture::ptr source = texture::load(path, false);
+	if(source == nullptr) return nullptr;
+
+	return create_from_texture(*source, palette, transparent_index);
+}
+
+indexed_texture::ptr indexed_texture::create_from_texture(const texture& texture, const palette& palette, uint8_t transparent_index) {
+	if(!texture.is_on_cpu()) return nullptr;
+
+	indexed_texture::ptr indexed = create(texture.get_width(), texture.get_height());
+	if(indexed == nullptr) return nullptr;
+
+	const color* texels = texture.get_data();
+	uint8_t* dest = indexed->get_data();
+
+	// Art limited to the palette repeats few colors, so the last match is
+	// usually right again.
+	color last_texel;
+	uint8_t last_index = 0;
+	bool has_last = false;
+
+	for(int y = 0; y < texture.get_height(); y++) {
+		for(int x = 0; x < texture.get_width(); x++) {
+			const color& texel = texels[texture.get_texel_index(0, x, y)];
+
+			if(texel.a < 0.5F) {
+				dest[x + y * indexed->width] = transparent_index;
+				continue;
+			}
+
+			if(!has_last || memcmp(&texel, &last_texel, sizeof(color)) != 0) {
+				last_texel = texel;
+				last_index = palette.find_nearest(texel);
+				has_last = true;
+			}
+
+			dest[x + y * indexed->width] = last_index;
+		}
 	}
 
-	rge::result create_window() override {
-		glutCreateWindow("Retro Game Engine");
+	return indexed;
+}
 
-		if(false) {
-			window_width = glutGet(GLUT_SCREEN_WIDTH);
-			window_height = glutGet(GLUT_SCREEN_HEIGHT);
-			glutFullScreen();
+indexed_texture::indexed_texture(int width, int height) {
+	this->width = width;
+	this->height = height;
+	data.assign(width * height, 0);
+}
+
+int indexed_texture::get_width() const {
+	return width;
+}
+
+int indexed_texture::get_height() const {
+	return height;
+}
+
+uint8_t* indexed_texture::get_data() {
+	return data.data();
+}
+
+const uint8_t* indexed_texture::get_data() const {
+	return data.data();
+}
+
+void indexed_texture::clear(uint8_t index) {
+	memset(data.data(), index, data.size());
+}
+
+void indexed_texture::draw(const indexed_texture& source, int x, int y, int src_x, int src_y, int src_width, int src_height, int transparent_index, bool flip_x, bool flip_y) {
+	// Clip the source rect to the source, then the destination rect to this.
+	if(src_x < 0) { x -= src_x; src_width += src_x; src_x = 0; }
+	if(src_y < 0) { y -= src_y; src_height += src_y; src_y = 0; }
+	src_width = math::min(src_width, source.width - src_x);
+	src_height = math::min(src_height, source.height - src_y);
+
+	int x_min = math::max(x, 0);
+	int y_min = math::max(y, 0);
+	int x_max = math::min(x + src_width, width);
+	int y_max = math::min(y + src_height, height);
+	if(x_min >= x_max || y_min >= y_max) return;
+
+	int span = x_max - x_min;
+	bool keyed = transparent_index >= 0 && transparent_index < palette::MAX_COLORS;
+	uint8_t key = (uint8_t)transparent_index;
+	if(flip_x) flipped_row.resize(span);
+
+	for(int dy = y_min; dy < y_max; dy++) {
+		int row = dy - y;
+		int sy = src_y + (flip_y ? src_height - 1 - row : row);
+		uint8_t* dest = &data[x_min + dy * width];
+		const uint8_t* src;
+
+		if(flip_x) {
+			// Mirrored spans are reversed once, then copied like any other.
+			const uint8_t* mirrored = &source.data[src_x + src_width - 1 - (x_min - x) + sy * source.width];
+			for(int i = 0; i < span; i++) flipped_row[i] = mirrored[-i];
+			src = flipped_row.data();
+		} else {
+			src = &source.data[src_x + (x_min - x) + sy * source.width];
 		}
 
-		glutIgnoreKeyRepeat(true);
-		glutDisplayFunc(update);
-		glutIdleFunc(idle);
-		glutReshapeFunc(on_window_reshape);
-		glutWMCloseFunc(on_window_try_close);
+		if(!keyed) {
+			memmove(dest, src, span);
+			continue;
+		}
 
-		glutKeyboardFunc([](uint8_t sys_key, int x, int y) -> void {
-			key_pressed_event e;
+		int i = 0;
+		for(; i + 16 <= span; i += 16) simd::copy_bytes_keyed(dest + i, src + i, key);
+		for(; i < span; i++) if(src[i] != key) dest[i] = src[i];
+	}
+}
 
-			if(sys_key >= 'a' && sys_key <= 'z') {
-				e.input_code = (input::code)(sys_key - 96);
-			} else if(sys_key >= 'A' && sys_key <= 'Z') {
-				e.input_code = (input::code)(sys_key - 64);
-			} else if(sys_key >= '0' && sys_key <= '9') {
-				e.input_code = (input::code)(sys_key - 18);
-			} else return;
+void indexed_texture::draw(const indexed_texture& source, int x, int y, int transparent_index) {
+	draw(source, x, y, 0, 0, source.width, source.height, transparent_index);
+}
 
-			engine::get_instance()->post_event(e);
-		});
+void indexed_texture::dump_to_raw_buffer(uint8_t* buffer, int buffer_width, int buffer_height, const palette& palette, pixel_format format) const {
+	if(buffer_width < 1 || buffer_height < 1) return;
 
-		glutKeyboardUpFunc([](uint8_t sys_key, int x, int y) -> void {
-			key_released_event e;
+	uint32_t colors[palette::MAX_COLORS];
+	palette.pack(colors, format);
 
-			if(sys_key >= 'a' && sys_key <= 'z') {
-				e.input_code = (input::code)(sys_key - 96);
-			} else if(sys_key >= 'A' && sys_key <= 'Z') {
-				e.input_code = (input::code)(sys_key - 64);
-			} else if(sys_key >= '0' && sys_key <= '9') {
-				e.input_code = (input::code)(sys_key - 18);
-			} else return;
+	letterbox::scale_nearest((uint32_t*)buffer, buffer_width, buffer_height, width, height, [&](int y, uint32_t* row) {
+		const uint8_t* indices = &data[y * width];
+		for(int x = 0; x < width; x++) row[x] = colors[indices[x]];
+	});
+}
+//********************************************//
+//* Indexed Texture Class                    *//
+//********************************************//
+#pragma endregion
 
-			engine::get_instance()->post_event(e);
-		});
 
-		glutMouseFunc([](int button, int state, int x, int y) -> void {
-			switch (button) {
-			case GLUT_LEFT_BUTTON:
-				if(state == GLUT_UP) {
-					mouse_released_event e;
-					e.input_code = input::MOUSE_LEFT;
-					engine::get_instance()->post_event(e);
-				} else if(state == GLUT_DOWN) {
-					mouse_pressed_event e;
-					e.input_code = input::MOUSE_LEFT;
-					engine::get_instance()->post_event(e);
-				}
-				break;
-			case GLUT_MIDDLE_BUTTON:
-				if(state == GLUT_UP) {
-					mouse_released_event e;
-					e.input_code = input::MOUSE_MIDDLE;
-					engine::get_instance()->post_event(e);
-				} else if(state == GLUT_DOWN) {
-					mouse_pressed_event e;
-					e.input_code = input::MOUSE_MIDDLE;
-					engine::get_instance()->post_event(e);
-				}
-				break;
-			case GLUT_RIGHT_BUTTON:
-				if(state == GLUT_UP) {
-					mouse_released_event e;
-					e.input_code = input::MOUSE_RIGHT;
-					engine::get_instance()->post_event(e);
-				} else if(state == GLUT_DOWN) {
-					mouse_pressed_event e;
-					e.input_code = input::MOUSE_RIGHT;
-					engine::get_instance()->post_event(e);
-				}
-				break;
-			}
-		});
+#pragma region /* rge::post_process */
+//********************************************//
+//* Post Process Classes                     *//
+//********************************************//
+namespace post {
+	// 4x4 Bayer matrix, in 1/16ths.
+	const float BAYER[16] = { 0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5 };
 
-		glutMotionFunc([](int x, int y) -> void {
-			mouse_moved_event e;
-			e.x = x;
-			e.y = y;
-			engine::get_instance()->post_event(e);
-		});
+	// Bayer thresholds of the 4 columns of a row, in [0, 1).
+	inline void bayer_row(int y, simd::f32x4* out) {
+		for(int i = 0; i < 4; i++) out[i] = simd::set1((BAYER[(y & 3) * 4 + i] + 0.5F) / 16.0F);
+	}
+}
 
-		glutPassiveMotionFunc([](int x, int y) -> void {
-			mouse_moved_event e;
-			e.x = x;
-			e.y = y;
-			engine::get_instance()->post_event(e);
-		});
+dither_pass::ptr dither_pass::create(int levels) {
+	return std::make_shared<dither_pass>(levels);
+}
+
+dither_pass::dither_pass(int levels) {
+	this->levels = levels;
+}
+
+void dither_pass::apply(const texture& source, texture& destination, int begin, int end) const {
+	int width = source.get_width();
+	const color* src = source.get_data();
+	color* dest = destination.get_data();
+
+	float steps = (float)math::max(levels - 1, 1);
+	simd::f32x4 scale = simd::set1(steps);
+	simd::f32x4 inv_scale = simd::set1(1.0F / steps);
+	simd::f32x4 thresholds[4];
+
+	for(int y = begin; y < end; y++) {
+		post::bayer_row(y, thresholds);
+
+		for(int x = 0; x < width; x++) {
+			int ptr = x + y * width;
+			simd::f32x4 c = simd::mul(simd::clamp01(simd::load(src[ptr])), scale);
+			simd::store(dest[ptr], simd::mul(simd::floor(simd::add(c, thresholds[x & 3])), inv_scale));
+		}
+	}
+}
+
+palette_pass::ptr palette_pass::create(palette::ptr palette, float dither) {
+	if(palette == nullptr) return nullptr;
+
+	return std::make_shared<palette_pass>(palette, dither);
+}
+
+palette_pass::palette_pass(palette::ptr palette, float dither) {
+	colors = palette;
+	this->dither = dither;
+	prepare();
+}
+
+void palette_pass::prepare() {
+	int count = colors->get_size();
+
+	bool same = (int)splat_colors.size() == count;
+	for(int i = 0; same && i < count; i++) {
+		color c = colors->get_color(i);
+		same = memcmp(&c, &splat_colors[i], sizeof(color)) == 0;
+	}
+	if(same) return;
+
+	splat_colors.resize(count);
+	for(int i = 0; i < count; i++) {
+		color c = colors->get_color(i);
+		splat_colors[i] = c;
+
+		for(int lane = 0; lane < 4; lane++) {
+			splat[i][0][lane] = c.r;
+			splat[i][1][lane] = c.g;
+			splat[i][2][lane] = c.b;
+		}
+	}
+}
+
+void palette_pass::apply(const texture& source, texture& destination, int begin, int end) const {
+	int width = source.get_width();
+	const color* src = source.get_data();
+	color* dest = destination.get_data();
+	int count = (int)splat_colors.size();
+
+	float r[4], g[4], b[4], offset[4], index[4];
+	simd::f32x4 one = simd::set1(1.0F);
+
+	for(int y = begin; y < end; y++) {
+		for(int i = 0; i < 4; i++)
+			offset[i] = ((post::BAYER[(y & 3) * 4 + i] + 0.5F) / 16.0F - 0.5F) * dither;
+		simd::f32x4 offsets = simd::load(offset);
+
+		for(int x = 0; x < width; x += 4) {
+			int lanes = math::min(4, width - x);
+			for(int i = 0; i < 4; i++) {
+				const color& c = src[x + math::min(i, lanes - 1) + y * width];
+				r[i] = c.r;
+				g[i] = c.g;
+				b[i] = c.b;
+			}
+
+			simd::f32x4 pr = simd::add(simd::load(r), offsets);
+			simd::f32x4 pg = simd::add(simd::load(g), offsets);
+			simd::f32x4 pb = simd::add(simd::load(b), offsets);
+			simd::f32x4 best = simd::set1(1e30F);
+			simd::f32x4 best_index = simd::set1(0.0F);
+			simd::f32x4 candidate = simd::set1(0.0F);
+
+			for(int i = 0; i < count; i++) {
+				simd::f32x4 dr = simd::sub(pr, simd::load(splat[i][0]));
+				simd::f32x4 dg = simd::sub(pg, simd::load(splat[i][1]));
+				simd::f32x4 db = simd::sub(pb, simd::load(splat[i][2]));
+				simd::f32x4 distance = simd::add(simd::add(simd::mul(dr, dr), simd::mul(dg, dg)), simd::mul(db, db));
+
+				// Index moves to the candidate where it is closer.
+				best_index = simd::add(best_index, simd::mask_less(distance, best, simd::sub(candidate, best_index)));
+				best = simd::min(best, distance);
+				candidate = simd::add(candidate, one);
+			}
+
+			simd::store(index, best_index);
+			for(int i = 0; i < lanes; i++) {
+				int ptr = x + i + y * width;
+				color c = splat_colors[(int)index[i]];
+				c.a = src[ptr].a;
+				dest[ptr] = c;
+			}
+		}
+	}
+}
+
+scanline_pass::ptr scanline_pass::create(float intensity, int period) {
+	return std::make_shared<scanline_pass>(intensity, period);
+}
+
+scanline_pass::scanline_pass(float intensity, int period) {
+	this->intensity = intensity;
+	this->period = period;
+}
+
+void scanline_pass::apply(const texture& source, texture& destination, int begin, int end) const {
+	int width = source.get_width();
+	const color* src = source.get_data();
+	color* dest = destination.get_data();
+
+	// Alpha is kept as is.
+	float keep = 1.0F - intensity;
+	simd::f32x4 darken = simd::load(color(keep, keep, keep, 1.0F));
+	int rows = math::max(period, 1);
+
+	for(int y = begin; y < end; y++) {
+		const color* src_row = src + y * width;
+		color* dest_row = dest + y * width;
+
+		if(y % rows != rows - 1) {
+			memcpy(dest_row, src_row, width * sizeof(color));
+			continue;
+		}
+
+		for(int x = 0; x < width; x++)
+			simd::store(dest_row[x], simd::mul(simd::load(src_row[x]), darken));
+	}
+}
+
+crt_pass::ptr crt_pass::create(float curvature, float bloom) {
+	return std::make_shared<crt_pass>(curvature, bloom);
+}
+
+crt_pass::crt_pass(float curvature, float bloom) {
+	this->curvature = curvature;
+	this->bloom = bloom;
+	bloom_threshold = 0.6F;
+	bloom_radius = 2;
+}
+
+void crt_pass::apply(const texture& source, texture& destination, int begin, int end) const {
+	int width = source.get_width();
+	int height = source.get_height();
+	const color* src = source.get_data();
+	color* dest = destination.get_data();
+
+	simd::f32x4 black = simd::load(color(0, 0, 0, 1));
+	simd::f32x4 zero = simd::set1(0.0F);
+	simd::f32x4 threshold = simd::set1(bloom_threshold);
+	simd::f32x4 glow_scale = simd::set1(bloom / fmaxf(1.0F - bloom_threshold, 0.001F) / 4.0F);
+	simd::f32x4 alpha_mask = simd::load(color(1, 1, 1, 0));
+	int radius = math::max(bloom_radius, 1);
+
+	for(int y = begin; y < end; y++) {
+		float ny = (y + 0.5F) / height * 2.0F - 1.0F;
+
+		for(int x = 0; x < width; x++) {
+			float nx = (x + 0.5F) / width * 2.0F - 1.0F;
+			float bend = 1.0F + curvature * (nx * nx + ny * ny);
+			int sx = (int)floorf((nx * bend + 1.0F) * 0.5F * width);
+			int sy = (int)floorf((ny * bend + 1.0F) * 0.5F * height);
+
+			if(sx < 0 || sx >= width || sy < 0 || sy >= height) {
+				simd::store(dest[x + y * width], black);
+				continue;
+			}
+
+			simd::f32x4 c = simd::load(src[sx + sy * width]);
+
+			if(bloom > 0.0F) {
+				// Brightness past the threshold in 4 neighbours, color only.
+				simd::f32x4 glow = zero;
+				glow = simd::add(glow, simd::max(simd::sub(simd::load(src[math::max(sx - radius, 0) + sy * width]), threshold), zero));
+				glow = simd::add(glow, simd::max(simd::sub(simd::load(src[math::min(sx + radius, width - 1) + sy * width]), threshold), zero));
+				glow = simd::add(glow, simd::max(simd::sub(simd::load(src[sx + math::max(sy - radius, 0) * width]), threshold), zero));
+				glow = simd::add(glow, simd::max(simd::sub(simd::load(src[sx + math::min(sy + radius, height - 1) * width]), threshold), zero));
+				c = simd::add(c, simd::mul(simd::mul(glow, glow_scale), alpha_mask));
+			}
+
+			simd::store(dest[x + y * width], c);
+		}
+	}
+}
+//********************************************//
+//* Post Process Classes                     *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::frame_capture */
+//********************************************//
+//* Frame Capture Class                      *//
+//********************************************//
+frame_capture::ptr frame_capture::create(const std::string& path, capture_format format, int width, int height, int fps, int ring_size) {
+	if(width < 1 || height < 1 || fps < 1 || ring_size < 1) return nullptr;
+
+	#ifndef RGE_USE_STB_IMAGE_WRITE
+	if(format == capture_format::PNG_SEQUENCE) {
+		LOG_MISSING_DEP(capture_png_sequence, stb_image_write.h)
+		return nullptr;
+	}
+	#endif
+
+	frame_capture::ptr capture = std::make_shared<frame_capture>(path, format, width, height, fps, ring_size);
+	if(format == capture_format::Y4M && !capture->video.is_open()) {
+		rge::log::error("Failed to open capture file: %s", path.c_str());
+		return nullptr;
+	}
+
+	return capture;
+}
+
+frame_capture::frame_capture(const std::string& path, capture_format format, int width, int height, int fps, int ring_size) {
+	this->path = path;
+	this->format = format;
+	this->width = width;
+	this->height = height;
+
+	// All buffers up front, the game thread never allocates.
+	ring.resize(ring_size);
+	for(int i = 0; i < ring_size; i++) {
+		ring[i].resize(width * height * 4);
+		free_slots.push_back(i);
+	}
+
+	encoding = 0;
+	frames_submitted = 0;
+	frames_written = 0;
+	frames_dropped = 0;
+	quit = false;
+
+	if(format == capture_format::Y4M) {
+		video.open(path, std::ios::binary);
+		if(video.is_open()) video << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C420jpeg\n";
+	}
+
+	encoder = std::thread(&frame_capture::encode_loop, this);
+}
+
+frame_capture::~frame_capture() {
+	flush();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+		signal.notify_all();
+	}
+	encoder.join();
+
+	if(video.is_open()) video.close();
+}
+
+rge::result frame_capture::submit(const texture& frame) {
+	if(frame.get_width() != width || frame.get_height() != height || !frame.is_on_cpu()) {
+		frames_dropped++;
+		return rge::FAIL;
+	}
+
+	int slot;
+	int number;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(free_slots.empty()) {
+			frames_dropped++;
+			return rge::FAIL;
+		}
+
+		slot = free_slots.back();
+		free_slots.pop_back();
+		number = frames_submitted++;
+	}
+
+	// The slot is ours until queued, so the copy needs no lock.
+	frame.dump_to_raw_buffer(ring[slot].data());
+
+	std::lock_guard<std::mutex> lock(mutex);
+	queued.push(std::make_pair(slot, number));
+	signal.notify_all();
+
+	return rge::OK;
+}
+
+void frame_capture::flush() {
+	std::unique_lock<std::mutex> lock(mutex);
+	signal.wait(lock, [this] { return queued.empty() && encoding == 0; });
+}
+
+int frame_capture::get_frames_written() const {
+	return frames_written;
+}
+
+int frame_capture::get_frames_dropped() const {
+	return frames_dropped;
+}
+
+void frame_capture::encode_loop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for(;;) {
+		signal.wait(lock, [this] { return !queued.empty() || quit; });
+		if(queued.empty()) return;
+
+		std::pair<int, int> job = queued.front();
+		queued.pop();
+		encoding++;
+
+		lock.unlock();
+		encode(ring[job.first], job.second);
+		frames_written++;
+		lock.lock();
+
+		encoding--;
+		free_slots.push_back(job.first);
+		signal.notify_all();
+	}
+}
+
+void frame_capture::encode(std::vector<uint8_t>& pixels, int frame) {
+	// Frames are stored bottom row first, files want the top row first.
+	int stride = width * 4;
+	std::vector<uint8_t> swap(stride);
+	for(int y = 0; y < height / 2; y++) {
+		uint8_t* a = &pixels[y * stride];
+		uint8_t* b = &pixels[(height - 1 - y) * stride];
+		memcpy(swap.data(), a, stride);
+		memcpy(a, b, stride);
+		memcpy(b, swap.data(), stride);
+	}
+
+	if(format == capture_format::PNG_SEQUENCE) {
+		#ifdef RGE_USE_STB_IMAGE_WRITE
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), "_%06d.png", frame);
+		if(!stbi_write_png((path + suffix).c_str(), width, height, 4, pixels.data(), stride))
+			rge::log::error("Failed to write capture frame: %s%s", path.c_str(), suffix);
+		#endif
+		return;
+	}
+
+	// Full range BT.601, chroma averaged over 2x2 pixels.
+	int chroma_width = (width + 1) / 2;
+	int chroma_height = (height + 1) / 2;
+	planes.resize(width * height + chroma_width * chroma_height * 2);
+	uint8_t* y_plane = planes.data();
+	uint8_t* u_plane = y_plane + width * height;
+	uint8_t* v_plane = u_plane + chroma_width * chroma_height;
+
+	simd::f32x4 y_r = simd::set1(0.299F), y_g = simd::set1(0.587F), y_b = simd::set1(0.114F);
+	simd::f32x4 u_r = simd::set1(-0.168736F), u_g = simd::set1(-0.331264F), u_b = simd::set1(0.5F);
+	simd::f32x4 v_r = simd::set1(0.5F), v_g = simd::set1(-0.418688F), v_b = simd::set1(-0.081312F);
+	simd::f32x4 bias = simd::set1(128.0F);
+	float r[4], g[4], b[4];
+	int32_t out[4];
+
+	// Luma, 4 pixels at a time.
+	for(int i = 0; i < width * height; i += 4) {
+		int lanes = math::min(4, width * height - i);
+		for(int k = 0; k < 4; k++) {
+			const uint8_t* p = &pixels[(i + math::min(k, lanes - 1)) * 4];
+			r[k] = p[0];
+			g[k] = p[1];
+			b[k] = p[2];
+		}
+
+		simd::f32x4 vr = simd::load(r), vg = simd::load(g), vb = simd::load(b);
+		simd::store(out, simd::round_to_int(simd::add(simd::add(simd::mul(vr, y_r), simd::mul(vg, y_g)), simd::mul(vb, y_b))));
+		for(int k = 0; k < lanes; k++) y_plane[i + k] = (uint8_t)math::clamp(out[k], 0, 255);
+	}
+
+	// Chroma, 4 averaged 2x2 blocks at a time.
+	for(int cy = 0; cy < chroma_height; cy++) {
+		int y0 = cy * 2;
+		int y1 = math::min(y0 + 1, height - 1);
+
+		for(int cx = 0; cx < chroma_width; cx += 4) {
+			int lanes = math::min(4, chroma_width - cx);
+			for(int k = 0; k < 4; k++) {
+				int x0 = (cx + math::min(k, lanes - 1)) * 2;
+				int x1 = math::min(x0 + 1, width - 1);
+				const uint8_t* p00 = &pixels[(x0 + y0 * width) * 4];
+				const uint8_t* p10 = &pixels[(x1 + y0 * width) * 4];
+				const uint8_t* p01 = &pixels[(x0 + y1 * width) * 4];
+				const uint8_t* p11 = &pixels[(x1 + y1 * width) * 4];
+				r[k] = (p00[0] + p10[0] + p01[0] + p11[0]) * 0.25F;
+				g[k] = (p00[1] + p10[1] + p01[1] + p11[1]) * 0.25F;
+				b[k] = (p00[2] + p10[2] + p01[2] + p11[2]) * 0.25F;
+			}
+
+			simd::f32x4 vr = simd::load(r), vg = simd::load(g), vb = simd::load(b);
+			int ptr = cx + cy * chroma_width;
+
+			simd::store(out, simd::round_to_int(simd::add(simd::add(simd::add(simd::mul(vr, u_r), simd::mul(vg, u_g)), simd::mul(vb, u_b)), bias)));
+			for(int k = 0; k < lanes; k++) u_plane[ptr + k] = (uint8_t)math::clamp(out[k], 0, 255);
+
+			simd::store(out, simd::round_to_int(simd::add(simd::add(simd::add(simd::mul(vr, v_r), simd::mul(vg, v_g)), simd::mul(vb, v_b)), bias)));
+			for(int k = 0; k < lanes; k++) v_plane[ptr + k] = (uint8_t)math::clamp(out[k], 0, 255);
+		}
+	}
+
+	video << "FRAME\n";
+	video.write((const char*)planes.data(), (std::streamsize)planes.size());
+}
+//********************************************//
+//* Frame Capture Class                      *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::material */
+//********************************************//
+//* Material Class                           *//
+//********************************************//
+material::ptr material::create() {
+	return std::make_shared<material>();
+}
+
+material::material() {
+	diffuse = color(1,1,1);
+	specular = color(1,1,1);
+	shininess = 0;
+	raster = raster_mode::PERSPECTIVE;
+	shading = shading_model::BLINN_PHONG;
+	alpha_cutoff = 0.0F;
+}
+
+material::~material() {
+	
+}
+//********************************************//
+//* Material Class                           *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::sprite */
+//********************************************//
+//* Sprite Class                             *//
+//********************************************//
+sprite::ptr sprite::create() {
+	return std::make_shared<sprite>();
+}
+
+sprite::ptr sprite::create(const rge::texture::ptr& texture) {
+	return std::make_shared<sprite>(texture);
+}
+
+sprite::sprite() {
+	transform = rge::transform::create();
+	centered = false;
+	billboard = false;
+	pixels_per_unit = 32;
+	layer = 0;
+}
+
+sprite::sprite(const rge::texture::ptr& texture) : sprite() {
+	this->texture = texture;
+}
+
+sprite::~sprite() {
+
+}
+//********************************************//
+//* Sprite Class                             *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::render_target */
+//********************************************//
+//* Render Target class.                     *//
+//********************************************//
+render_target::ptr render_target::create(renderer* renderer, int width, int height) {
+	if(renderer == nullptr) return nullptr;
+	if(width < 1) return nullptr;
+	if(height < 1) return nullptr;
+
+	return std::make_shared<render_target>(renderer, width, height);
+}
+
+rge::result render_target::resize(int width, int height) {
+	if(width < 1) return rge::FAIL;
+	if(height < 1) return rge::FAIL;
+
+	this->width = width;
+	this->height = height;
+
+	// Reinterpret the buffers at the new size, if they are large enough.
+	bool reshaped = frame_buffer && depth_buffer && width * height <= capacity;
+	reshaped = reshaped && frame_buffer->reshape(width, height) && depth_buffer->reshape(width, height);
+
+	if(!reshaped) {
+		if(frame_buffer) renderer_instance->free_texture(*frame_buffer);
+		if(depth_buffer) renderer_instance->free_texture(*depth_buffer);
+
+		frame_buffer = renderer_instance->create_texture(width, height);
+		depth_buffer = renderer_instance->create_texture(width, height);
+		capacity = width * height;
+	}
+
+	// Nothing known about the depth buffer yet, so bounds that never reject.
+	depth_tile unknown = { 0.0F, 1.0F };
+	depth_tiles_x = (width + DEPTH_TILE_SIZE - 1) / DEPTH_TILE_SIZE;
+	depth_tiles_y = (height + DEPTH_TILE_SIZE - 1) / DEPTH_TILE_SIZE;
+	depth_tiles.assign(depth_tiles_x * depth_tiles_y, unknown);
+	clear_tiles.assign(depth_tiles_x * depth_tiles_y, 0);
+	clear_pending = false;
+
+	return rge::OK;
+}
+
+int render_target::get_width() const {
+	return width;
+}
+
+int render_target::get_height() const {
+	return height;
+}
+
+int render_target::get_capacity() const {
+	return capacity;
+}
+
+texture* render_target::get_frame_buffer() const {
+	return frame_buffer.get();
+}
+
+texture* render_target::get_depth_buffer() const {
+	return depth_buffer.get();
+}
+
+render_target::depth_tile* render_target::get_depth_tiles() {
+	return depth_tiles.data();
+}
+
+int render_target::get_depth_tiles_x() const {
+	return depth_tiles_x;
+}
+
+int render_target::get_depth_tiles_y() const {
+	return depth_tiles_y;
+}
+
+void render_target::clear(const color& background, bool lazy) {
+	if(!frame_buffer->is_on_cpu() || !depth_buffer->is_on_cpu()) return;
+
+	depth_tile far_plane = { 1.0F, 1.0F };
+	depth_tiles.assign(depth_tiles_x * depth_tiles_y, far_plane);
+
+	if(lazy) {
+		clear_color = background;
+		clear_tiles.assign(depth_tiles_x * depth_tiles_y, 1);
+		clear_pending = true;
+		return;
+	}
+
+	clear_tiles.assign(depth_tiles_x * depth_tiles_y, 0);
+	clear_pending = false;
+
+	jobs::parallel_for(height, 16, [&](int begin, int end) {
+		fill_rows(0, begin, width, end, background);
+	});
+}
+
+void render_target::resolve_clear(int x_min, int y_min, int x_max, int y_max) {
+	if(!clear_pending) return;
+
+	x_min = math::max(x_min, 0);
+	y_min = math::max(y_min, 0);
+	x_max = math::min(x_max, width);
+	y_max = math::min(y_max, height);
+
+	for(int ty = y_min / DEPTH_TILE_SIZE; ty * DEPTH_TILE_SIZE < y_max; ty++) {
+		for(int tx = x_min / DEPTH_TILE_SIZE; tx * DEPTH_TILE_SIZE < x_max; tx++) {
+			uint8_t& pending = clear_tiles[tx + ty * depth_tiles_x];
+			if(!pending) continue;
+
+			fill_rows(
+				tx * DEPTH_TILE_SIZE,
+				ty * DEPTH_TILE_SIZE,
+				math::min(tx * DEPTH_TILE_SIZE + DEPTH_TILE_SIZE, width),
+				math::min(ty * DEPTH_TILE_SIZE + DEPTH_TILE_SIZE, height),
+				clear_color
+			);
+			pending = 0;
+		}
+	}
+}
+
+void render_target::resolve_clear() {
+	if(!clear_pending) return;
+
+	// Whole rows of tiles, so workers never share a tile.
+	jobs::parallel_for(depth_tiles_y, 1, [&](int begin, int end) {
+		resolve_clear(0, begin * DEPTH_TILE_SIZE, width, end * DEPTH_TILE_SIZE);
+	});
+
+	clear_pending = false;
+}
+
+void render_target::fill_rows(int x_min, int y_min, int x_max, int y_max, const color& background) {
+	color* frame = frame_buffer->get_data();
+	color* depth = depth_buffer->get_data();
+	int span = x_max - x_min;
+
+	// Only transparent black is all zero bytes, so a memset. Opaque black
+	// has a 1.0 alpha & takes the store loop like any other color.
+	bool zero = background.r == 0.0F && background.g == 0.0F && background.b == 0.0F && background.a == 0.0F;
+
+	simd::f32x4 frame_value = simd::load(background);
+	simd::f32x4 depth_value = simd::load(color(1, 0, 0, 0));
+
+	for(int y = y_min; y < y_max; y++) {
+		color* frame_row = frame + x_min + y * width;
+		color* depth_row = depth + x_min + y * width;
+
+		if(zero) {
+			memset((void*)frame_row, 0, span * sizeof(color));
+		} else {
+			for(int x = 0; x < span; x++) simd::store(frame_row[x], frame_value);
+		}
+
+		for(int x = 0; x < span; x++) simd::store(depth_row[x], depth_value);
+	}
+}
+
+render_target::~render_target() {
+	frame_buffer.reset();
+	depth_buffer.reset();
+}
+
+render_target::render_target(renderer* renderer, int width, int height) {
+	renderer_instance = renderer;
+	capacity = 0;
+	resize(width, height);
+}
+//********************************************//
+//* Render Target class.                     *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::render_target_pool */
+//********************************************//
+//* Render Target Pool class.                *//
+//********************************************//
+render_target_pool::render_target_pool(renderer* renderer) {
+	renderer_instance = renderer;
+}
+
+render_target::ptr render_target_pool::acquire(int width, int height, bool transient) {
+	if(width < 1 || height < 1) return nullptr;
+
+	// A free target of the same size is used as is, else the smallest free
+	// one large enough is resized in place.
+	entry* best = nullptr;
+	for(size_t i = 0; i < entries.size(); i++) {
+		entry& e = entries[i];
+		if(!is_free(e)) continue;
+
+		if(e.target->get_width() == width && e.target->get_height() == height) {
+			best = &e;
+			break;
+		}
+
+		if(e.target->get_capacity() >= width * height && (best == nullptr || e.target->get_capacity() < best->target->get_capacity()))
+			best = &e;
+	}
+
+	if(best == nullptr) {
+		render_target::ptr target = render_target::create(renderer_instance, width, height);
+		if(target == nullptr) return nullptr;
+
+		entry e = { target, false, false, 0 };
+		entries.push_back(e);
+		best = &entries.back();
+	}
+
+	if(best->target->get_width() != width || best->target->get_height() != height)
+		best->target->resize(width, height);
+
+	best->acquired = true;
+	best->transient = transient;
+	best->idle_frames = 0;
+	return best->target;
+}
+
+void render_target_pool::release(const render_target::ptr& target) {
+	for(size_t i = 0; i < entries.size(); i++) {
+		if(entries[i].target == target) entries[i].acquired = false;
+	}
+}
+
+void render_target_pool::next_frame() {
+	for(size_t i = 0; i < entries.size(); i++) {
+		entry& e = entries[i];
+		if(e.transient) e.acquired = false;
+
+		if(is_free(e)) e.idle_frames++;
+		else e.idle_frames = 0;
+	}
+
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [this](const entry& e) {
+		return is_free(e) && e.idle_frames > MAX_IDLE_FRAMES;
+	}), entries.end());
+}
+
+void render_target_pool::trim() {
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [this](const entry& e) {
+		return is_free(e);
+	}), entries.end());
+}
+
+bool render_target_pool::is_free(const entry& e) const {
+	// Persistent targets also return once nothing else refers to them.
+	if(e.acquired && !e.transient && e.target.use_count() <= 1) return true;
+	return !e.acquired;
+}
+//********************************************//
+//* Render Target Pool class.                *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::renderer */
+//********************************************//
+//* Renderer class.                          *//
+//********************************************//
+renderer::renderer() : target_pool(this) {
+	input_camera = nullptr;
+	output_render = nullptr;
+	ambient_color = color(0,0,0);
+	current_blit_mode = blit_mode::COPY;
+	color_key = color(1, 0, 1);
+	sprite_sort_by_texture = false;
+	lights_generation = 0;
+}
+
+void renderer::set_camera(camera::ptr camera) {
+	input_camera = camera;
+}
+
+void renderer::set_ambience(const color& ambient_color) {
+	this->ambient_color = ambient_color;
+}
+
+void renderer::add_light(light::ptr light) {
+	if(light == nullptr) return;
+	if(std::find(lights.begin(), lights.end(), light) != lights.end()) return;
+	lights.push_back(light);
+	lights_generation++;
+}
+
+void renderer::remove_light(light::ptr light) {
+	lights.erase(std::remove(lights.begin(), lights.end(), light), lights.end());
+	lights_generation++;
+}
+
+void renderer::clear_lights() {
+	lights.clear();
+	lights_generation++;
+}
+
+const std::vector<light::ptr>& renderer::get_lights() const {
+	return lights;
+}
+
+void renderer::add_post_process(post_process::ptr pass) {
+	if(pass == nullptr) return;
+	post_processes.push_back(pass);
+}
+
+void renderer::remove_post_process(post_process::ptr pass) {
+	post_processes.erase(std::remove(post_processes.begin(), post_processes.end(), pass), post_processes.end());
+}
+
+void renderer::clear_post_processes() {
+	post_processes.clear();
+}
+
+const std::vector<post_process::ptr>& renderer::get_post_processes() const {
+	return post_processes;
+}
+
+void renderer::set_blit_mode(blit_mode mode, const color& key) {
+	current_blit_mode = mode;
+	color_key = key;
+}
+
+void renderer::set_sprite_sort_by_texture(bool enabled) {
+	sprite_sort_by_texture = enabled;
+}
+
+rge::result renderer::set_target(render_target::ptr target) {
+	output_render = target;
+	return rge::OK;
+}
+
+render_target::ptr renderer::get_target() const {
+	return output_render;
+}
+
+render_target_pool& renderer::get_target_pool() {
+	return target_pool;
+}
+//********************************************//
+//* Renderer class.                          *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::windows */
+//********************************************//
+//* Windows platform class.                  *//
+//********************************************//
+#ifdef SYS_WINDOWS
+// Real win32 entry point for release mode (DesktopApp).
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow) {
+	// TODO: Get entry parameters.
+
+	return main(0, nullptr);
+}
+
+class windows : public platform {
+public:
+	const LPCWSTR CLASS_NAME = L"RETRO_GAME_ENGINE_CLASS";
+	WNDCLASS config;
+	HWND handle;
+	HDC device_context;
+
+	int window_width;
+	int window_height;
+
+	bool has_init;
+	bool has_window;
+	bool has_focus;
+
+	struct {
+		BITMAPINFO bitmap_info;
+		HBITMAP bitmap;
+		void* buffer;
+	} frame;
+
+
+	static windows* get_instance() {
+		return (windows*)engine::get_platform();
+	}
+
+	windows() {
+		has_init = false;
+		has_window = false;
+		has_focus = false;
+	}
+
+public:
+	rge::result init(rge::engine* engine) override {
+		if(has_init) return rge::FAIL;
+
+		ZeroMemory(&config, sizeof(WNDCLASS));
+		config.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+		config.hCursor = LoadCursor(NULL, IDC_ARROW);
+		config.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
+		config.hInstance = GetModuleHandle(nullptr);
+		config.lpfnWndProc = on_event;
+		config.cbClsExtra = 0;
+		config.cbWndExtra = 0;
+		config.lpszMenuName = nullptr;
+		config.hbrBackground = nullptr;
+		config.lpszClassName = CLASS_NAME;
+
+		if(!RegisterClass(&config)) {
+			rge::log::error("Failed to register platform class (winapi).");
+			return rge::FAIL;
+		}
+
+		#ifdef SYS_SOFTWARE_GL
+		device_context = CreateCompatibleDC(0);
+		#endif /* SYS_SOFTWARE_GL */
+		
+		has_init = true;
+		return rge::OK;
+	}
+
+	rge::result create_window(const std::string& title, int width, int height, bool fullscreen) override {
+		if(!has_init) return rge::FAIL;
+		if(has_window) return rge::FAIL;
+
+		DWORD style_ex = WS_EX_APPWINDOW | WS_EX_WINDOWEDGE;
+		DWORD style = WS_CAPTION | WS_SYSMENU | WS_VISIBLE | WS_THICKFRAME;
+
+		RECT rWndRect = { 0, 0, width, height };
+		AdjustWindowRectEx(&rWndRect, style, FALSE, style_ex);
+		window_width = rWndRect.right - rWndRect.left;
+		window_height = rWndRect.bottom - rWndRect.top;
+
+		handle = CreateWindowEx(
+			style_ex,
+			CLASS_NAME,
+			convert_str_to_wstr(title).c_str(),
+			style,
+			CW_USEDEFAULT,
+			CW_USEDEFAULT,
+			window_width,
+			window_height,
+			nullptr,
+			nullptr,
+			config.hInstance,
+			0
+		);
+
+		if(handle == nullptr) {
+			rge::log::error("Failed to create window (winapi).");
+			return rge::FAIL;
+		}
+
+		// TODO: Add fullscreen
+
+		has_window = true;
+		return rge::OK;
+	}
+
+	static std::wstring convert_str_to_wstr(const std::string& str) {
+		#ifdef __MINGW32__
+		wchar_t* buffer = new wchar_t[str.length() + 1];
+		mbstowcs(buffer, str.c_str(), str.length());
+		buffer[str.length()] = L'\0';
+		#else
+		int count = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, NULL, 0);
+		wchar_t* buffer = new wchar_t[count];
+		MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, buffer, count);
+		#endif
+
+		std::wstring w(buffer);
+		delete[] buffer;
+
+		return w;
+	}
+
+	static rge::input::code convert_sys_key_to_rge_key(uint8_t sys_key) {
+		// If system key is a letter.
+		if(sys_key > 0x40 && sys_key < 0x5B)
+			return (rge::input::code)(sys_key - 0x40);
+
+		// If system key is a digit (keypad).
+		if(sys_key > 0x5F && sys_key < 0x6A)
+			return (rge::input::code)(sys_key - 0x60 + 30);
+
+		// If system key is a digit (alpha).
+		if(sys_key > 0x2F && sys_key < 0x3A)
+			return (rge::input::code)(sys_key - 0x30 + 30);
+
+		// Otherwise...
+		switch(sys_key) {
+			case VK_SPACE: return	rge::input::KEY_SPACE;
+			case VK_CAPITAL: return rge::input::KEY_CAPS;
+			case VK_RETURN: return	rge::input::KEY_RETURN;
+			case VK_LEFT: return	rge::input::KEY_LEFT;
+			case VK_UP: return		rge::input::KEY_UP;
+			case VK_RIGHT: return	rge::input::KEY_RIGHT;
+			case VK_DOWN: return	rge::input::KEY_DOWN;
+			case VK_LSHIFT: return	rge::input::KEY_LEFT_SHIFT;
+			case VK_CONTROL: return rge::input::KEY_LEFT_CTRL;
+			case VK_RSHIFT: return	rge::input::KEY_RIGHT_SHIFT;
+			case VK_TAB: return		rge::input::KEY_TAB;
+			case VK_BACK: return	rge::input::KEY_BACKSPACE;
+			case VK_ESCAPE: return	rge::input::KEY_ESC;
+		}
+
+		return rge::input::NONE;
+	}
+
+	void set_window_title(const std::string& title) override {
+		if(!has_window) return;
+
+		#ifdef UNICODE
+		SetWindowText(handle, convert_str_to_wstr(title).c_str());
+		#else
+		SetWindowText(handle, title.c_str());
+		#endif
+	}
+
+	void set_window_size(int width, int height) override {
+		// TODO: Test
+		if(width < 1) width = 1;
+		if(height < 1) height = 1;
+		window_width = width;
+		window_height = height;
+		SetWindowPos(handle, NULL, 0, 0, width, height, SWP_NOMOVE | SWP_NOZORDER);
+	}
+
+	void set_fullscreen(bool fullscreen) override {
+		// TODO
+	}
+
+	void poll_events() override {
+		if(!has_window) return;
+
+		MSG msg;
+
+		while(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE) > 0) {
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+		}
+	}
+
+	void refresh_window() override {
+		if(!has_window) return;
+
+		#ifdef SYS_SOFTWARE_GL
+		InvalidateRect(handle, NULL, FALSE);
+		UpdateWindow(handle);
+		#elif SYS_OPENGL_1_0
+		// TODO
+		// SwapBuffers();
+		#endif
+	}
+
+	static LRESULT CALLBACK on_event(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+		switch(msg) {
+			case WM_CLOSE: {
+				window_close_requested_event e;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_DESTROY: {
+				PostQuitMessage(0);
+				DestroyWindow(hwnd);
+				break;
+			}
+
+			case WM_SIZE: {
+				window_resized_event e;
+				e.width = LOWORD(lParam);
+				e.height = HIWORD(lParam);
+
+				// The frame bitmap may still be written by the renderer.
+				if(engine::get_renderer() != nullptr) engine::get_renderer()->wait_for_present();
+
+				get_instance()->create_frame(e.width, e.height);
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_MOVE: {
+				window_moved_event e;
+				e.x = (int)(short)LOWORD(lParam); // Horizontal position.
+				e.y = (int)(short)HIWORD(lParam); // Vertical position.
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_KILLFOCUS: {
+				get_instance()->has_focus = false;
+				window_unfocused_event e;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_SETFOCUS: {
+				get_instance()->has_focus = true;
+				window_focused_event e;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+			
+			case WM_KEYUP: {
+				key_released_event e;
+				e.input_code = convert_sys_key_to_rge_key((uint8_t)wParam);
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_KEYDOWN: {
+				bool key_was_down = ((lParam & (1 << 30)) != 0);
+				if(!key_was_down) {
+					key_pressed_event e;
+					e.input_code = convert_sys_key_to_rge_key((uint8_t)wParam);
+					engine::get_instance()->post_event(e);
+				}
+				break;
+			}
+
+			case WM_LBUTTONDOWN: {
+				mouse_pressed_event e;
+				e.input_code = rge::input::MOUSE_LEFT;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_RBUTTONDOWN: {
+				mouse_pressed_event e;
+				e.input_code = rge::input::MOUSE_RIGHT;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_MBUTTONDOWN: {
+				mouse_pressed_event e;
+				e.input_code = rge::input::MOUSE_MIDDLE;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_LBUTTONUP: {
+				mouse_released_event e;
+				e.input_code = rge::input::MOUSE_LEFT;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_RBUTTONUP: {
+				mouse_released_event e;
+				e.input_code = rge::input::MOUSE_RIGHT;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_MBUTTONUP: {
+				mouse_released_event e;
+				e.input_code = rge::input::MOUSE_MIDDLE;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_MOUSEMOVE: {
+				mouse_moved_event e;
+				e.x = (int)(short)LOWORD(lParam); // Horizontal position.
+				e.y = (int)(short)HIWORD(lParam); // Vertical position.
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			case WM_MOUSEWHEEL: {
+				mouse_scrolled_event e;
+				e.scroll = (short)HIWORD(wParam) / 120;
+				engine::get_instance()->post_event(e);
+				break;
+			}
+
+			default: {
+				return DefWindowProc(hwnd, msg, wParam, lParam);
+			}
+		}
+
+		return 0;
+	}
+
+	inline void post_gamepad_axis(float v, input::code ic, int u) {
+		gamepad_axis_event e;
+		e.input_code = ic;
+		e.user = u;
+		e.value = v;
+		engine::get_instance()->post_event(e);
+	}
+
+	void poll_gamepads() override {
+		for(int u = 0; u < input::MAX_GAMEPAD_COUNT; u++) {
+			XINPUT_STATE state;
+			if(XInputGetState(u, &state) != ERROR_SUCCESS)
+				continue;
+
+			post_gamepad_axis(float(state.Gamepad.bLeftTrigger) / 255, input::GAMEPAD_LEFT_TRIGGER, u);
+			post_gamepad_axis(float(state.Gamepad.bRightTrigger) / 255, input::GAMEPAD_RIGHT_TRIGGER, u);
+			post_gamepad_axis(fmaxf(-1, (float)state.Gamepad.sThumbLX / 32767), input::GAMEPAD_LEFT_STICK_X, u);
+			post_gamepad_axis(fmaxf(-1, (float)state.Gamepad.sThumbLY / 32767), input::GAMEPAD_LEFT_STICK_Y, u);
+			post_gamepad_axis(fmaxf(-1, (float)state.Gamepad.sThumbRX / 32767), input::GAMEPAD_RIGHT_STICK_X, u);
+			post_gamepad_axis(fmaxf(-1, (float)state.Gamepad.sThumbRY / 32767), input::GAMEPAD_RIGHT_STICK_Y, u);
+
+			// Generate gamepad button events.
+			int i;
+			int mask;
+			bool is_pressed;
+			bool was_pressed;
+			for(i = input::GAMEPAD_UP; i <= input::GAMEPAD_START; i++) {
+				switch(i) {
+					case input::GAMEPAD_UP:
+						mask = 0x0001;
+						break;
+					case input::GAMEPAD_DOWN:
+						mask = 0x0002;
+						break;
+					case input::GAMEPAD_LEFT:
+						mask = 0x0004;
+						break;
+					case input::GAMEPAD_RIGHT:
+						mask = 0x0008;
+						break;
+
+					case input::GAMEPAD_NORTH:
+						mask = 0x8000;
+						break;
+					case input::GAMEPAD_SOUTH:
+						mask = 0x1000;
+						break;
+					case input::GAMEPAD_WEST:
+						mask = 0x4000;
+						break;
+					case input::GAMEPAD_EAST:
+						mask = 0x2000;
+						break;
+
+					case input::GAMEPAD_LEFT_BUMPER:
+						mask = 0x0100;
+						break;
+					case input::GAMEPAD_RIGHT_BUMPER:
+						mask = 0x0200;
+						break;
+
+					case input::GAMEPAD_LEFT_STICK:
+						mask = 0x0040;
+						break;
+					case input::GAMEPAD_RIGHT_STICK:
+						mask = 0x0080;
+						break;
+
+					case input::GAMEPAD_OPTIONS:
+						mask = 0x0020;
+						break;
+					case input::GAMEPAD_START:
+						mask = 0x0010;
+						break;
+
+					default:
+						continue;
+				}
+
+				is_pressed = state.Gamepad.wButtons & mask;
+				was_pressed = input::is_down((input::code)i, u);
+
+				if(is_pressed && !was_pressed) {
+					gamepad_pressed_event e;
+					e.input_code = (input::code)i;
+					e.user = u;
+					engine::get_instance()->post_event(e);
+				} else if(!is_pressed && was_pressed) {
+					gamepad_released_event e;
+					e.input_code = (input::code)i;
+					e.user = u;
+					engine::get_instance()->post_event(e);
+				}
+			}
+		}
+	}
+
+	void create_frame(int width, int height) {
+		window_width = width;
+		window_height = height;
+		#ifdef SYS_SOFTWARE_GL
+		frame.bitmap_info.bmiHeader.biWidth = width;
+		frame.bitmap_info.bmiHeader.biHeight = height;
+
+		if(frame.bitmap)
+			DeleteObject(frame.bitmap);
+
+		frame.bitmap = CreateDIBSection(NULL, &frame.bitmap_info, DIB_RGB_COLORS, &frame.buffer, 0, 0);
+		if(frame.bitmap == NULL)
+			return;
+
+		SelectObject(device_context, frame.bitmap);
+		#endif /* SYS_SOFTWARE_GL */
+	}
+
+	uint8_t* get_frame_buffer() {
+		return (uint8_t*)frame.buffer;
+	}
+
+	bool is_focused() const override {
+		return has_focus;
+	}
+
+	void clean_up() override {
+
+	}
+};
+#endif /* SYS_WINDOWS */
+//********************************************//
+//* Windows platform class.                  *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::linux */
+//********************************************//
+//* Linux platform class.                    *//
+//********************************************//
+#ifdef SYS_LINUX
+// No window yet, runs headless. The GL renderers draw to a context made
+// current by the caller, like tools/glcheck does through EGL.
+class linux : public platform {
+public:
+	rge::result init(rge::engine* engine) override {
+		return rge::OK;
+	}
+
+	rge::result create_window(const std::string& title, int width, int height, bool fullscreen) override {
+		set_window_size(width, height);
+		return rge::OK;
+	}
+
+	void set_window_title(const std::string& title) override {
+
+	}
+
+	// Only tells the renderer the new frame size.
+	void set_window_size(int width, int height) override {
+		window_resized_event e;
+		e.width = width;
+		e.height = height;
+		engine::get_instance()->post_event(e);
+	}
+
+	void set_fullscreen(bool fullscreen) override {
+
+	}
+
+	void poll_events() override {
+
+	}
+
+	void poll_gamepads() override {
+
+	}
+
+	void refresh_window() override {
+
+	}
+
+	bool is_focused() const override {
+		return true;
+	}
+
+	void clean_up() override {
+
+	}
+};
+#endif /* SYS_LINUX */
+//********************************************//
+//* Linux platform class.                    *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::macosx */
+//********************************************//
+//* MacOS X platform class.                  *//
+//********************************************//
+#ifdef SYS_MACOSX
+class macosx : public platform {
+private:
+	int window_width;
+	int window_height;
+	std::function<void()> loop_func;
+
+	static macosx* get_instance() {
+		return (macosx*)engine::get_platform();
+	}
+
+public:
+	macosx() {
+		window_width = 800;
+		window_height = 600;
+	}
+
+	rge::result init(rge::engine* engine) override {
+		Class GLUTViewClass = objc_getClass("GLUTView");
+
+		// SEL scrollWheelSel = sel_registerName("scrollWheel:");
+		// bool resultAddMethod = class_addMethod(GLUTViewClass, scrollWheelSel, (IMP)scrollWheelUpdate, "v@:@");
+		// assert(resultAddMethod);
+
+		int argc = 0;
+		char* argv[1] = { (char*)"" };
+		glutInit(&argc, argv);
+		glutInitWindowPosition(0, 0);
+		glutInitWindowSize(window_width, window_height);
+		glutInitDisplayMode(GLUT_SINGLE | GLUT_DEPTH | GLUT_RGBA);
+
+		return rge::OK;
+	}
+
+	rge::result create_window() override {
+		glutCreateWindow("Retro Game Engine");
+
+		if(false) {
+			window_width = glutGet(GLUT_SCREEN_WIDTH);
+			window_height = glutGet(GLUT_SCREEN_HEIGHT);
+			glutFullScreen();
+		}
+
+		glutIgnoreKeyRepeat(true);
+		glutDisplayFunc(update);
+		glutIdleFunc(idle);
+		glutReshapeFunc(on_window_reshape);
+		glutWMCloseFunc(on_window_try_close);
+
+		glutKeyboardFunc([](uint8_t sys_key, int x, int y) -> void {
+			key_pressed_event e;
+
+			if(sys_key >= 'a' && sys_key <= 'z') {
+				e.input_code = (input::code)(sys_key - 96);
+			} else if(sys_key >= 'A' && sys_key <= 'Z') {
+				e.input_code = (input::code)(sys_key - 64);
+			} else if(sys_key >= '0' && sys_key <= '9') {
+				e.input_code = (input::code)(sys_key - 18);
+			} else return;
+
+			engine::get_instance()->post_event(e);
+		});
+
+		glutKeyboardUpFunc([](uint8_t sys_key, int x, int y) -> void {
+			key_released_event e;
+
+			if(sys_key >= 'a' && sys_key <= 'z') {
+				e.input_code = (input::code)(sys_key - 96);
+			} else if(sys_key >= 'A' && sys_key <= 'Z') {
+				e.input_code = (input::code)(sys_key - 64);
+			} else if(sys_key >= '0' && sys_key <= '9') {
+				e.input_code = (input::code)(sys_key - 18);
+			} else return;
+
+			engine::get_instance()->post_event(e);
+		});
+
+		glutMouseFunc([](int button, int state, int x, int y) -> void {
+			switch (button) {
+			case GLUT_LEFT_BUTTON:
+				if(state == GLUT_UP) {
+					mouse_released_event e;
+					e.input_code = input::MOUSE_LEFT;
+					engine::get_instance()->post_event(e);
+				} else if(state == GLUT_DOWN) {
+					mouse_pressed_event e;
+					e.input_code = input::MOUSE_LEFT;
+					engine::get_instance()->post_event(e);
+				}
+				break;
+			case GLUT_MIDDLE_BUTTON:
+				if(state == GLUT_UP) {
+					mouse_released_event e;
+					e.input_code = input::MOUSE_MIDDLE;
+					engine::get_instance()->post_event(e);
+				} else if(state == GLUT_DOWN) {
+					mouse_pressed_event e;
+					e.input_code = input::MOUSE_MIDDLE;
+					engine::get_instance()->post_event(e);
+				}
+				break;
+			case GLUT_RIGHT_BUTTON:
+				if(state == GLUT_UP) {
+					mouse_released_event e;
+					e.input_code = input::MOUSE_RIGHT;
+					engine::get_instance()->post_event(e);
+				} else if(state == GLUT_DOWN) {
+					mouse_pressed_event e;
+					e.input_code = input::MOUSE_RIGHT;
+					engine::get_instance()->post_event(e);
+				}
+				break;
+			}
+		});
+
+		glutMotionFunc([](int x, int y) -> void {
+			mouse_moved_event e;
+			e.x = x;
+			e.y = y;
+			engine::get_instance()->post_event(e);
+		});
+
+		glutPassiveMotionFunc([](int x, int y) -> void {
+			mouse_moved_event e;
+			e.x = x;
+			e.y = y;
+			engine::get_instance()->post_event(e);
+		});
+
+		// TODO: Events to implement...
+		// 		window moved event
+		// 		window focus/unfocus event
+		// 		mouse scroll event
+
+		return rge::OK;
+	}
+
+	bool use_custom_loop() const override {
+		return true;
+	}
+
+	static void update() {
+		get_instance()->loop_func();
+	}
+
+	static void idle() {
+		static bool cocoa_enabled = false;
+		if(!cocoa_enabled) {
+			Class ns_app_class = objc_getClass("NSApplication");
+			SEL shared_app_sel = sel_registerName("sharedApplication");
+			id ns_app = ((id(*)(Class, SEL))objc_msgSend)(ns_app_class, shared_app_sel);
+			SEL main_window_sel = sel_registerName("mainWindow");
+			id window = ((id(*)(id, SEL))objc_msgSend)(ns_app, main_window_sel);
+			SEL set_style_mask_sel = sel_registerName("setStyleMask:");
+			int style_mask = (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3);
+			// [window setStyleMask: NSWindowStyleMaskClosable | ~NSWindowStyleMaskResizable]
+			((void (*)(id, SEL, NSUInteger))objc_msgSend)(window, set_style_mask_sel, style_mask);
+			cocoa_enabled = true;
+		}
+
+		if(!engine::get_instance()->get_is_running()) {
+			exit(0);
+			return;
+		}
+
+		glutPostRedisplay();
+	}
+
+	static void on_window_reshape(int w, int h) {
+		get_instance()->window_width = w;
+		get_instance()->window_height = h;
+
+		window_resized_event e;
+		e.width = w;
+		e.height = h;
+		engine::get_instance()->post_event(e);
+	}
+
+	static void on_window_try_close() {
+		window_close_requested_event e;
+		engine::get_instance()->post_event(e);
+	}
+
+	void enter_loop(std::function<void()> loop) override {
+		this->loop_func = loop;
+		
+		glutMainLoop();
+	}
+
+	void set_window_title(const std::string& title) override {
+		glutSetWindowTitle(title.c_str());
+	}
+
+	void poll_gamepads() override {
+		// TODO
+	}
+
+	void poll_events() override {
+		// TODO
+	}
+
+	void refresh_window() override {
+		// TODO
+	}
+
+	bool is_focused() const override {
+		// TODO
+		return true;
+	}
+
+	void clean_up() override {
+
+	}
+};
+#endif /* SYS_MACOSX */
+//********************************************//
+//* MacOS X platform class.                  *//
+//********************************************//
+#pragma endregion
+
+
+#pragma region /* rge::software_gl */
+//********************************************//
+//* Software Renderer                        *//
+//********************************************//
+#ifdef SYS_SOFTWARE_GL
+class software_gl : public renderer {
+private:
+	render_target::ptr output_window;
+	platform* platform_instance;
+	bool depth_prepass;
+	bool deferred_shading;
+	bool lazy_clear;
+
+	// The window frame is converted to the platform bitmap on its own
+	// thread, overlapping the next frame's update.
+	std::thread present_thread;
+	std::mutex present_mutex;
+	std::condition_variable present_signal;
+	bool present_pending;
+	bool present_quit;
+	bool present_dither;
+	uint8_t* present_buffer;
+	int present_width;
+	int present_height;
+
+	// Fixed window frame size, 0 by 0 follows the window.
+	int virtual_width;
+	int virtual_height;
+	texture_filter virtual_filter;
+	int window_width;
+	int window_height;
+
+	// Presented in place of the window frame when set. The present thread
+	// works on copies, so the game can draw the next frame meanwhile.
+	indexed_texture::ptr indexed_frame;
+	palette::ptr indexed_palette;
+	indexed_texture::ptr present_indexed_frame;
+	palette::ptr present_palette;
+
+	frame_capture::ptr capture;
+
+	render_target::ptr get_real_target() {
+		if(output_render != nullptr) return output_render;
+
+		// Drawing to the window waits for the last frame to be presented.
+		wait_for_present();
+		return output_window;
+	}
+
+	void present_loop() {
+		std::unique_lock<std::mutex> lock(present_mutex);
+		for(;;) {
+			present_signal.wait(lock, [this] { return present_pending || present_quit; });
+			if(present_quit) return;
+
+			lock.unlock();
+			if(present_indexed_frame != nullptr) present_indexed_frame->dump_to_raw_buffer(present_buffer, present_width, present_height, *present_palette, pixel_format::BGRA8);
+			else output_window->get_frame_buffer()->dump_to_raw_buffer(present_buffer, present_width, present_height, virtual_filter, pixel_format::BGRA8, present_dither);
+
+			#ifdef SYS_WINDOWS
+			InvalidateRect(((windows*)platform_instance)->handle, NULL, FALSE);
+			#endif
+
+			lock.lock();
+			present_pending = false;
+			present_signal.notify_all();
+		}
+	}
+
+	// Runs the post passes over the window frame, split over worker rows,
+	// ping-ponging between pooled targets. The last pass writes back to
+	// the window frame.
+	void apply_post_processes() {
+		if(post_processes.empty()) return;
+
+		int width = output_window->get_width();
+		int height = output_window->get_height();
+		render_target::ptr ping = target_pool.acquire(width, height, true);
+		render_target::ptr pong = post_processes.size() > 1 ? target_pool.acquire(width, height, true) : nullptr;
+
+		// A single pass can't read & write the window frame at once.
+		texture* source = output_window->get_frame_buffer();
+		if(pong == nullptr) {
+			memcpy(ping->get_frame_buffer()->get_data(), source->get_data(), width * height * sizeof(color));
+			source = ping->get_frame_buffer();
+		}
+
+		for(size_t i = 0; i < post_processes.size(); i++) {
+			texture* destination = output_window->get_frame_buffer();
+			if(i + 1 < post_processes.size()) destination = (i % 2 == 0 ? ping : pong)->get_frame_buffer();
+
+			post_process& pass = *post_processes[i];
+			pass.prepare();
+			jobs::parallel_for(height, 8, [&](int begin, int end) {
+				pass.apply(*source, *destination, begin, end);
+			});
+
+			source = destination;
+		}
+
+		target_pool.release(ping);
+		if(pong != nullptr) target_pool.release(pong);
+	}
+
+	// Hands the window frame to the present thread, for a buffer of the
+	// window's size.
+	void present(uint8_t* buffer) {
+		if(!present_thread.joinable()) present_thread = std::thread(&software_gl::present_loop, this);
+
+		std::lock_guard<std::mutex> lock(present_mutex);
+
+		if(indexed_frame != nullptr) {
+			if(present_indexed_frame == nullptr) present_indexed_frame = indexed_texture::create(indexed_frame->get_width(), indexed_frame->get_height());
+			if(present_palette == nullptr) present_palette = palette::create(std::vector<color>(1));
+			*present_indexed_frame = *indexed_frame;
+			*present_palette = *indexed_palette;
+		} else {
+			present_indexed_frame = nullptr;
+		}
+
+		present_buffer = buffer;
+		present_width = window_width > 0 ? window_width : output_window->get_width();
+		present_height = window_height > 0 ? window_height : output_window->get_height();
+		present_pending = true;
+		present_signal.notify_all();
+	}
+
+public:
+	software_gl() : renderer() {
+		depth_prepass = false;
+		deferred_shading = false;
+		light_tiles_x = 0;
+		light_tiles_width = 0;
+		light_tiles_height = 0;
+		light_tiles_generation = 0;
+		lazy_clear = false;
+		present_pending = false;
+		present_quit = false;
+		present_dither = false;
+		present_buffer = nullptr;
+		present_width = 0;
+		present_height = 0;
+		virtual_width = 0;
+		virtual_height = 0;
+		virtual_filter = texture_filter::NEAREST;
+		window_width = 0;
+		window_height = 0;
+	}
+
+	~software_gl() {
+		if(present_thread.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(present_mutex);
+				present_quit = true;
+				present_signal.notify_all();
+			}
+			present_thread.join();
+		}
+	}
+
+	// Clears only flag the depth tiles of the target, each tile is filled on
+	// its first draw or at display. Mostly empty frames skip most of the fill.
+	void set_lazy_clear(bool enabled) {
+		lazy_clear = enabled;
+	}
+
+	// Dithers the window frame when converting it to bytes, hiding banding
+	// in smooth gradients.
+	void set_present_dither(bool enabled) {
+		present_dither = enabled;
+	}
+
+	// Records every displayed window frame, after post-processing. Null
+	// stops recording.
+	void set_capture(frame_capture::ptr capture) {
+		this->capture = capture;
+	}
+
+	// Returns the window frame at its virtual resolution, post-processed
+	// once displayed. Valid until the window is drawn to again.
+	const texture& get_window_frame() const {
+		return *output_window->get_frame_buffer();
+	}
+
+	// Presents an indexed frame through a palette instead of the window
+	// frame, scaled up to the window like a NEAREST virtual resolution.
+	// Palette swaps & cycling cost nothing until present. Null frame or
+	// palette presents the window frame again.
+	void set_indexed_frame(indexed_texture::ptr frame, palette::ptr palette) {
+		wait_for_present();
+
+		bool valid = frame != nullptr && palette != nullptr;
+		indexed_frame = valid ? frame : nullptr;
+		indexed_palette = valid ? palette : nullptr;
+	}
+
+	// Renders the window frame at a fixed resolution, like 320x180, scaled
+	// up to the window at present between black bars. NEAREST keeps square
+	// pixels with whole scales, BILINEAR fills the window with sharp edges.
+	// 0 by 0 renders at the window's resolution again.
+	void set_virtual_resolution(int width, int height, texture_filter filter = texture_filter::NEAREST) {
+		wait_for_present();
+
+		virtual_width = math::max(width, 0);
+		virtual_height = math::max(height, 0);
+		virtual_filter = filter;
+
+		// Before init() there is no window frame yet, init() applies the size.
+		if(output_window == nullptr) return;
+
+		if(virtual_width > 0 && virtual_height > 0) output_window->resize(virtual_width, virtual_height);
+		else if(window_width > 0 && window_height > 0) output_window->resize(window_width, window_height);
+	}
+
+	// Defers mesh triangles until the next flush, then rasterizes their
+	// depth before shading, so each covered pixel is shaded only once.
+	// Pays off on scenes with a lot of overdraw.
+	void set_depth_prepass(bool enabled) {
+		if(!enabled) flush_prepass();
+		depth_prepass = enabled;
+	}
+
+	// Rasterizes meshes into a G-buffer of depth, normal, albedo & material
+	// ID, then lights each visible pixel once in a parallel pass, before
+	// the next sprites, blit or display. Overdraw no longer costs lighting.
+	void set_deferred_shading(bool enabled) {
+		if(!enabled) {
+			flush_prepass();
+			resolve_deferred();
+		}
+		deferred_shading = enabled;
+	}
+
+public:
+	rge::result init(platform* platform) override {
+		platform_instance = platform;
+
+		// A virtual resolution may be set before init().
+		bool virtual_size = virtual_width > 0 && virtual_height > 0;
+		output_window = render_target::create(this, virtual_size ? virtual_width : 1, virtual_size ? virtual_height : 1);
+		return rge::OK;
+	}
+
+	texture::ptr create_texture(int width, int height) override {
+		texture::ptr texture = texture::create(width, height);
+
+		texture->allocate();
+
+		return texture;
+	}
+
+	void alloc_texture(texture& texture) override {
+		texture.allocate();
+	}
+
+	void upload_texture(texture& texture) override {
+		// NOTE: N/A to software renderer.
+	}
+
+	void free_texture(texture& texture) override {
+		// NOTE: N/A to software renderer, texels are owned by the texture.
+	}
+
+	int get_width() const override {
+		return output_render != nullptr ? output_render->get_width() : output_window->get_width();
+	}
+
+	int get_height() const override {
+		return output_render != nullptr ? output_render->get_height() : output_window->get_height();
+	}
+
+	void wait_for_present() override {
+		std::unique_lock<std::mutex> lock(present_mutex);
+		present_signal.wait(lock, [this] { return !present_pending; });
+	}
+
+	bool on_window_resized(const window_resized_event& e) override {
+		wait_for_present();
+		window_width = e.width;
+		window_height = e.height;
+
+		// A virtual resolution stays, only the upscale changes.
+		if(virtual_width == 0 || virtual_height == 0) output_window->resize(e.width, e.height);
+		return false; // Do not consume event. Let it propagate through higher layers.
+	}
+
+	rge::result set_target(render_target::ptr target) override {
+		// The target drawn so far may be sampled as a texture next.
+		if(output_render != nullptr && output_render != target) output_render->resolve_clear();
+
+		return renderer::set_target(target);
+	}
+
+	void clear(color background) override {
+		flush_batches();
+
+		get_real_target()->clear(background, lazy_clear);
+
+		// A new frame, the lights may have moved.
+		light_tiles_target = nullptr;
+	}
+
+	void flush() override {
+		flush_batches();
+		get_real_target()->resolve_clear();
+	}
+
+	void display() override {
+		flush_batches();
+
+		// Post passes & the present thread read the whole frame.
+		wait_for_present();
+		output_window->resolve_clear();
+		apply_post_processes();
+
+		#ifdef SYS_WINDOWS
+		windows* winapi = (windows*)platform_instance;
+		uint8_t* buffer = winapi->get_frame_buffer();
+		if(buffer != nullptr) present(buffer);
+		#endif
+
+		// Only reads the frame, so it overlaps the present.
+		if(capture != nullptr) capture->submit(*output_window->get_frame_buffer());
+	}
+
+	rge::result draw(
+		const mat4& local_to_world,
+		const std::vector<vec3>& vertices,
+		const std::vector<int>& triangles,
+		const std::vector<vec3>& normals,
+		const std::vector<vec2>& uvs,
+		const material& material
+	) override {
+		if(input_camera == nullptr || output_render == nullptr) return rge::FAIL;
+
+		flush_sprites();
+
+		int i;
+		vec3 world_v1;
+		vec3 world_v2;
+		vec3 world_v3;
+		vec3 world_n1;
+		vec3 world_n2;
+		vec3 world_n3;
+		vec4 proj_v1;
+		vec4 proj_v2;
+		vec4 proj_v3;
+		vec3 proj_tri_normal;
+		vec3 proj_tri_center;
+		vec2 normalized_v1;
+		vec2 normalized_v2;
+		vec2 normalized_v3;
+		vec4 texturespace_v1;
+		vec4 texturespace_v2;
+		vec4 texturespace_v3;
+		vec3 camera_position = input_camera->transform != nullptr ? input_camera->transform->get_global_position() : vec3();
+		mat4 world_to_projection = input_camera->get_projection_matrix() * input_camera->get_view_matrix();
+
+		float w = (float)get_real_target()->get_width();
+		float h = (float)get_real_target()->get_height();
+
+		update_light_tiles(world_to_projection);
+
+		// Span modes are always shaded as they are drawn.
+		bool spans = material.raster != raster_mode::PERSPECTIVE;
+
+		// Only per pixel lighting is worth deferring. Alpha tested pixels
+		// can't be told apart by depth alone, so skip the prepass.
+		bool deferrable = !spans && material.shading == shading_model::BLINN_PHONG;
+		bool prepass = depth_prepass && !spans && material.alpha_cutoff <= 0.0F;
+
+		// 0 shades each pixel as it is drawn.
+		uint16_t material_id = deferred_shading && deferrable ? get_gbuffer_material(material, world_to_projection, camera_position) : 0;
+
+		// Triangles queued for another target go out first.
+		if(prepass) {
+			if(prepass_target != get_real_target()) {
+				flush_prepass();
+				prepass_target = get_real_target();
+			}
+
+			prepass_draw queued;
+			queued.material = material;
+			queued.material_id = material_id;
+			queued.camera_position = camera_position;
+			queued.rasterizer = get_triangle_rasterizer(material);
+			prepass_draws.push_back(queued);
+		}
+
+		triangle_rasterizer rasterizer = get_triangle_rasterizer(material);
+
+		// Loop through each of the triplets of triangle indices.
+		for(i = 0; i < triangles.size(); i += 3) {
+			// Transform model vertices to world vertices.
+			world_v1 = local_to_world.multiply_point_3x4(vertices[triangles[i]]);
+			world_v2 = local_to_world.multiply_point_3x4(vertices[triangles[i + 1]]);
+			world_v3 = local_to_world.multiply_point_3x4(vertices[triangles[i + 2]]);
+
+			// Transform model normals to world normals.
+			world_n1 = local_to_world.multiply_vector(normals[triangles[i]]);
+			world_n2 = local_to_world.multiply_vector(normals[triangles[i + 1]]);
+			world_n3 = local_to_world.multiply_vector(normals[triangles[i + 2]]);
+
+			// Get the projected vertices that make up the triangle based
+			// on these indices.
+			proj_v1 = project_world_vertex(world_v1, world_to_projection);
+			proj_v2 = project_world_vertex(world_v2, world_to_projection);
+			proj_v3 = project_world_vertex(world_v3, world_to_projection);
+
+			// Cheap hack: convert camera space z from [-1, 1] to [0, 1]
+			proj_v1.z /= 2.0F;
+			proj_v1.z += 0.5F;
+			proj_v2.z /= 2.0F;
+			proj_v2.z += 0.5F;
+			proj_v3.z /= 2.0F;
+			proj_v3.z += 0.5F;
+
+			// NOTE: Debugging
+			// printf("p1x: %f, p1y: %f, p1z: %f\n", proj_v1.x, proj_v1.y, proj_v1.z);
+			// printf("p2x: %f, p2y: %f, p2z: %f\n", proj_v2.x, proj_v2.y, proj_v2.z);
+			// printf("p3x: %f, p3y: %f, p3z: %f\n", proj_v3.x, proj_v3.y, proj_v3.z);
+
+			if(/* Check if all three projected vertices are within homogeneous clip bounds. */
+			   proj_v1.x >= -1 && proj_v1.x <= 1 && proj_v1.y >= -1 && proj_v1.y <= 1 &&
+			   proj_v2.x >= -1 && proj_v2.x <= 1 && proj_v2.y >= -1 && proj_v2.y <= 1 &&
+			   proj_v3.x >= -1 && proj_v3.x <= 1 && proj_v3.y >= -1 && proj_v3.y <= 1
+			   ) {
+				// NOTE: Debugging
+				// printf("inside bounds\n");
+
+				// Calculate the normal of the projected triangle from the cross
+				// product of two of its edges.
+				proj_tri_normal = vec3::cross(proj_v2 - proj_v1, proj_v3 - proj_v1);
+
+				// Calculate the centre of the projected triangle.
+				proj_tri_center = (proj_v1 + proj_v2 + proj_v3) / 3;
+
+				// NOTE: Debugging
+				// printf("cx: %f\n", camera_position.x);
+				// printf("cy: %f\n", camera_position.y);
+				// printf("cz: %f\n", camera_position.z);
+				// printf("nx: %f\n", proj_tri_normal.x);
+				// printf("ny: %f\n", proj_tri_normal.y);
+				// printf("nz: %f\n", proj_tri_normal.z);
+				// printf("ax: %f\n", proj_tri_center.x);
+				// printf("ay: %f\n", proj_tri_center.y);
+				// printf("az: %f\n", proj_tri_center.z);
+
+				// Check the dot project of the projected triangle normal and
+				// the camera to triangle centre vector - if the dot product is
+				// <=0, the normal and vector point at each other, and the triangle
+				// must be facing the camera, so we should render it. If the dot
+				// product is >0, the are facing the same direction, therefore
+				// the triangle is facing away from the camera - don't render it.
+				float d = vec3::dot(proj_tri_normal, proj_tri_center - camera_position);
+
+				// NOTE: Debugging
+				// printf("d: %f\n", d);
+
+				if(d >= 0) {
+					// Normalize our projected vertices so that they are in the range
+					// Between 0 and 1 (instead of -1 and 1).
+					normalized_v1 = vec2((proj_v1.x + 1) / 2.0F, (proj_v1.y + 1) / 2.0F);
+					normalized_v2 = vec2((proj_v2.x + 1) / 2.0F, (proj_v2.y + 1) / 2.0F);
+					normalized_v3 = vec2((proj_v3.x + 1) / 2.0F, (proj_v3.y + 1) / 2.0F);
+
+					// Multiply our normalized vertex positions by the render target size
+					// to get their position in texture space (or if we were rendering
+					// to the screen - screen space).
+					texturespace_v1 = vec4(normalized_v1.x * w, normalized_v1.y * h, proj_v1.z, proj_v1.w);
+					texturespace_v2 = vec4(normalized_v2.x * w, normalized_v2.y * h, proj_v2.z, proj_v2.w);
+					texturespace_v3 = vec4(normalized_v3.x * w, normalized_v3.y * h, proj_v3.z, proj_v3.w);
+
+					if(spans) {
+						rasterize_spans(
+							*get_real_target(),
+							texturespace_v1,
+							texturespace_v2,
+							texturespace_v3,
+							world_v1,
+							world_v2,
+							world_v3,
+							world_n1,
+							world_n2,
+							world_n3,
+							uvs[triangles[i]],
+							uvs[triangles[i + 1]],
+							uvs[triangles[i + 2]],
+							material,
+							camera_position
+						);
+						continue;
+					}
+
+					if(prepass) {
+						prepass_triangle triangle = {
+							{ texturespace_v1, texturespace_v2, texturespace_v3 },
+							{ world_v1, world_v2, world_v3 },
+							{ world_n1, world_n2, world_n3 },
+							{ uvs[triangles[i]], uvs[triangles[i + 1]], uvs[triangles[i + 2]] },
+							(uint32_t)prepass_draws.size() - 1
+						};
+						prepass_triangles.push_back(triangle);
+						continue;
+					}
+
+					// Draw the triangle interpolated between the three vertices,
+					// using the colours calculated for these vertices based
+					// on the triangle indices.
+					(this->*rasterizer)(
+						*get_real_target(),
+						raster_pass::DEPTH_AND_COLOR,
+						texturespace_v1,
+						texturespace_v2,
+						texturespace_v3,
+						world_v1,
+						world_v2,
+						world_v3,
+						world_n1,
+						world_n2,
+						world_n3,
+						uvs[triangles[i]],
+						uvs[triangles[i + 1]],
+						uvs[triangles[i + 2]],
+						material,
+						camera_position,
+						material_id
+					);
+				}
+			}
+		}
+
+		return rge::OK;
+	}
+
+	// Draw a 2D texture onto (dest)[0, 1] view space, from (src)[0, 1] uv space.
+	void draw(const texture& texture, vec2 dest_min, vec2 dest_max, vec2 src_min, vec2 src_max) override {
+		float wt = (float)get_real_target()->get_width();
+		float ht = (float)get_real_target()->get_height();
+
+		draw(
+			texture,
+			(int)roundf(dest_min.x * wt),
+			(int)roundf(dest_min.y * ht),
+			(int)roundf(dest_max.x * wt),
+			(int)roundf(dest_max.y * ht),
+			(int)roundf(src_min.x * texture.get_width()),
+			(int)roundf(src_min.y * texture.get_height()),
+			(int)roundf(src_max.x * texture.get_width()),
+			(int)roundf(src_max.y * texture.get_height())
+		);
+	}
+
+	// Draw a 2D texture onto (dest)[0, w/h] frame space, from (src)[0, w/h] texel space.
+	void draw(
+		const texture& texture,
+		int dest_min_x,
+		int dest_min_y,
+		int dest_max_x,
+		int dest_max_y,
+		int src_min_x,
+		int src_min_y,
+		int src_max_x,
+		int src_max_y
+	) override {
+		if(!texture.is_on_cpu()) return;
+
+		flush_batches();
+
+		int dest_width = dest_max_x - dest_min_x;
+		int dest_height = dest_max_y - dest_min_y;
+		int src_width = src_max_x - src_min_x;
+		int src_height = src_max_y - src_min_y;
+		if(dest_width <= 0 || dest_height <= 0 || src_width <= 0 || src_height <= 0) return;
+
+		int wt = get_real_target()->get_width();
+		int ht = get_real_target()->get_height();
+		color* frame_buffer = get_real_target()->get_frame_buffer()->get_data();
+
+		// Clip once, so the spans below never check bounds.
+		int x_min = math::max(dest_min_x, 0);
+		int y_min = math::max(dest_min_y, 0);
+		int x_max = math::min(dest_max_x, wt);
+		int y_max = math::min(dest_max_y, ht);
+		if(x_min >= x_max || y_min >= y_max) return;
+
+		get_real_target()->resolve_clear(x_min, y_min, x_max, y_max);
+
+		int span = x_max - x_min;
+		const color* texels = texture.get_data();
+		bool unscaled = dest_width == src_width && dest_height == src_height;
+		bool integer_scale = dest_width % src_width == 0 && dest_height % src_height == 0;
+
+		// Filtered scaling, texels fetched 4 at a time.
+		if(!unscaled && !integer_scale && texture.filter != texture_filter::NEAREST) {
+			blit_row.resize(span + 4);
+			blit_u.resize(span + 4);
+			float du = float(src_width) / dest_width / texture.get_width();
+			float u0 = (src_min_x + (x_min - dest_min_x + 0.5F) * float(src_width) / dest_width) / texture.get_width();
+			for(int i = 0; i < span + 4; i++) blit_u[i] = u0 + i * du;
+
+			for(int y = y_min; y < y_max; y++) {
+				float v = (src_min_y + (y - dest_min_y + 0.5F) * float(src_height) / dest_height) / texture.get_height();
+				float vs[4] = { v, v, v, v };
+				for(int i = 0; i < span; i += 4)
+					texture.sample4(&blit_u[i], vs, &blit_row[i]);
+
+				blit_span(frame_buffer + x_min + y * wt, blit_row.data(), span);
+			}
+			return;
+		}
+
+		// Source column table, so each pixel is one add & one load. Texel
+		// offsets split into row & column parts for linear or tiled layouts.
+		blit_columns.resize(span);
+		for(int x = x_min; x < x_max; x++) {
+			int sx = src_min_x + (int)((int64_t)(x - dest_min_x) * src_width / dest_width);
+			blit_columns[x - x_min] = texture.get_texel_column_offset(0, math::clamp(sx, 0, texture.get_width() - 1));
+		}
+
+		bool contiguous = unscaled && texture.get_layout() == texture_layout::LINEAR;
+		if(current_blit_mode != blit_mode::COPY || !contiguous) blit_row.resize(span);
+
+		for(int y = y_min; y < y_max; y++) {
+			int sy = src_min_y + (int)((int64_t)(y - dest_min_y) * src_height / dest_height);
+			const color* row = texels + texture.get_texel_row_offset(0, math::clamp(sy, 0, texture.get_height() - 1));
+			color* dest = frame_buffer + x_min + y * wt;
+
+			// 1:1 copy of linear texels is a straight row copy.
+			if(contiguous && current_blit_mode == blit_mode::COPY) {
+				memcpy(dest, row + blit_columns[0], span * sizeof(color));
+				continue;
+			}
+
+			if(contiguous) {
+				blit_span(dest, row + blit_columns[0], span);
+				continue;
+			}
+
+			color* gathered = current_blit_mode == blit_mode::COPY ? dest : blit_row.data();
+			for(int i = 0; i < span; i++)
+				gathered[i] = row[blit_columns[i]];
+
+			if(current_blit_mode != blit_mode::COPY)
+				blit_span(dest, gathered, span);
+		}
+	}
+
+	// Queues a sprite, drawn with the rest of the batch on the next flush.
+	void draw(const sprite& sprite) override {
+		if(input_camera == nullptr) return;
+		if(sprite.texture == nullptr || !sprite.texture->is_on_cpu()) return;
+
+		// Sprites queued for another target go out first.
+		if(sprite_batch_target != get_real_target()) {
+			flush_sprites();
+			sprite_batch_target = get_real_target();
+		}
+
+		sprite_batch_item item;
+		float wt = (float)sprite_batch_target->get_width();
+		float ht = (float)sprite_batch_target->get_height();
+		if(!project_sprite(sprite, sprite.texture->get_width(), sprite.texture->get_height(), wt, ht, item.corners)) return;
+
+		float x_min = wt, y_min = ht, x_max = 0.0F, y_max = 0.0F;
+		item.depth = 0.0F;
+		for(int i = 0; i < 4; i++) {
+			item.depth += item.corners[i].z / 4.0F;
+
+			x_min = fminf(x_min, item.corners[i].x);
+			y_min = fminf(y_min, item.corners[i].y);
+			x_max = fmaxf(x_max, item.corners[i].x);
+			y_max = fmaxf(y_max, item.corners[i].y);
+		}
+
+		item.x_min = math::max((int)floorf(x_min), 0);
+		item.y_min = math::max((int)floorf(y_min), 0);
+		item.x_max = math::min((int)ceilf(x_max), (int)wt);
+		item.y_max = math::min((int)ceilf(y_max), (int)ht);
+		if(item.x_min >= item.x_max || item.y_min >= item.y_max) return;
+
+		item.texture = sprite.texture;
+		item.tint = sprite.material != nullptr ? sprite.material->diffuse : color();
+		item.layer = sprite.layer;
+		item.order = (uint32_t)sprite_batch.size();
+
+		sprite_batch.push_back(item);
+	}
+
+	// Draws a sprite with an indexed texture to the indexed frame, placed
+	// through the camera like draw(sprite). The sprite's own texture is not
+	// used. Texels are nearest & only bytes move, texels equal to the
+	// transparent index are skipped, -1 draws all. There is no depth, nor
+	// layers, sprites draw in call order. Needs set_indexed_frame().
+	void draw_indexed(const sprite& sprite, const indexed_texture& texture, int transparent_index = -1) {
+		if(input_camera == nullptr || indexed_frame == nullptr) return;
+
+		int wt = indexed_frame->get_width();
+		int ht = indexed_frame->get_height();
+		vec3 c[4];
+		if(!project_sprite(sprite, texture.get_width(), texture.get_height(), (float)wt, (float)ht, c)) return;
+
+		// Unscaled & upright, like most sprites of a pixel perfect 2d camera,
+		// is a plain byte blit. Pixel centers pick the same texels as below.
+		const float EPSILON = 0.001F;
+		if(fabsf(c[1].x - c[0].x - texture.get_width()) < EPSILON && fabsf(c[1].y - c[0].y) < EPSILON &&
+		   fabsf(c[3].y - c[0].y - texture.get_height()) < EPSILON && fabsf(c[3].x - c[0].x) < EPSILON) {
+			// Texel row 0 is the top of the image, the last row drawn.
+			int x = first_sprite_pixel(snap_sprite_coord(c[0].x));
+			int y = first_sprite_pixel(snap_sprite_coord(c[0].y));
+			indexed_frame->draw(texture, x, y, 0, 0, texture.get_width(), texture.get_height(), transparent_index, false, true);
+			return;
+		}
+
+		float x_min = (float)wt, y_min = (float)ht, x_max = 0.0F, y_max = 0.0F;
+		for(int i = 0; i < 4; i++) {
+			x_min = fminf(x_min, c[i].x);
+			y_min = fminf(y_min, c[i].y);
+			x_max = fmaxf(x_max, c[i].x);
+			y_max = fmaxf(y_max, c[i].y);
+		}
+
+		int px_min = math::max((int)floorf(x_min), 0);
+		int py_min = math::max((int)floorf(y_min), 0);
+		int px_max = math::min((int)ceilf(x_max), wt);
+		int py_max = math::min((int)ceilf(y_max), ht);
+		if(px_min >= px_max || py_min >= py_max) return;
+
+		// Same two affine triangles & edges as rasterize_sprite.
+		sprite_triangle tris[2] = {
+			setup_sprite_triangle(c[0], c[1], c[2], vec2(0, 1), vec2(1, 1), vec2(1, 0)),
+			setup_sprite_triangle(c[0], c[2], c[3], vec2(0, 1), vec2(1, 0), vec2(0, 0))
+		};
+		sprite_edges edges = setup_sprite_edges(c);
+
+		bool keyed = transparent_index >= 0 && transparent_index < palette::MAX_COLORS;
+		uint8_t key = (uint8_t)transparent_index;
+		int tw = texture.get_width();
+		int th = texture.get_height();
+		const uint8_t* texels = texture.get_data();
+		uint8_t* frame = indexed_frame->get_data();
+
+		for(int y = py_min; y < py_max; y++) {
+			float py = y + 0.5F;
+			uint8_t* dest = frame + y * wt;
+
+			for(int x = px_min; x < px_max; x++) {
+				if(!sprite_covers(edges, x, y)) continue;
+
+				float px = x + 0.5F;
+				const sprite_triangle& tri = tris[sprite_triangle_at(edges, x, y)];
+				float dx = px - tri.origin.x;
+				float dy = py - tri.origin.y;
+				int tx = math::clamp((int)floorf((tri.u0 + tri.dudx * dx + tri.dudy * dy) * tw), 0, tw - 1);
+				int ty = math::clamp((int)floorf((tri.v0 + tri.dvdx * dx + tri.dvdy * dy) * th), 0, th - 1);
+
+				uint8_t index = texels[tx + ty * tw];
+				if(!keyed || index != key) dest[x] = index;
+			}
+		}
+	}
+
+private:
+	std::vector<int> blit_columns;
+	std::vector<color> blit_row;
+	std::vector<float> blit_u;
+
+	// How rasterize_triangle treats depth.
+	enum class raster_pass {
+		DEPTH_AND_COLOR, // Depth tested, writes both.
+		DEPTH_ONLY,      // Prepass, only keeps the closest depth.
+		COLOR_EQUAL      // After the prepass, shades just the pixels each triangle won.
+	};
+
+	// A rasterize_triangle specialized for one shader.
+	typedef void (software_gl::*triangle_rasterizer)(
+		render_target& target,
+		raster_pass pass,
+		const vec4& r_v1, const vec4& r_v2, const vec4& r_v3,
+		const vec3& w_v1, const vec3& w_v2, const vec3& w_v3,
+		const vec3& w_n1, const vec3& w_n2, const vec3& w_n3,
+		const vec2& t_uv1, const vec2& t_uv2, const vec2& t_uv3,
+		const material& material,
+		const vec3& camera_position,
+		uint16_t material_id
+	);
+
+	// What the shader stages of one triangle read.
+	struct shader_context {
+		const rge::material* material;
+		const vec3* w_v; // World vertices.
+		const vec3* w_n; // World normals.
+		vec3 camera_position;
+		color ambient;
+		const std::vector<light::ptr>* lights;
+		const std::vector<uint16_t>* vertex_lights; // Every light, for per vertex lighting.
+		color vertex_color[3]; // Written by the vertex stage.
+	};
+
+	// Vertex stages run once per triangle, before its pixels.
+	struct no_vertex_stage {
+		void operator()(shader_context& context) const {}
+	};
+
+	// Blinn-Phong at each vertex, for a white surface. The fragment stage
+	// tints it by the surface color.
+	struct lit_vertex_stage {
+		void operator()(shader_context& context) const {
+			const material& m = *context.material;
+			for(int i = 0; i < 3; i++) {
+				context.vertex_color[i] = calculate_blinn_phong(
+					context.w_v[i],
+					context.w_n[i],
+					color(1, 1, 1),
+					m.specular,
+					context.ambient,
+					m.shininess,
+					context.camera_position,
+					*context.lights,
+					*context.vertex_lights
+				);
+			}
+		}
+	};
+
+	// Fragment stages split a pixel in two. surface() returns the albedo,
+	// alpha tested & written to the G-buffer when deferred. shade() lights
+	// it. Flags are compile time constants, the rasterizer's checks on them
+	// fold away.
+	template<bool textured, bool alpha_tested>
+	struct fragment_stage_base {
+		static const bool TEXTURED = textured;
+		static const bool ALPHA_TESTED = alpha_tested;
+
+		color surface(const shader_context& context, const color& texel) const {
+			color albedo = context.material->diffuse;
+			if(textured) albedo *= texel;
+			return albedo;
+		}
+	};
+
+	template<bool textured, bool alpha_tested>
+	struct unlit_fragment_stage : fragment_stage_base<textured, alpha_tested> {
+		static const bool DEFERRABLE = false;
+
+		color shade(const shader_context& context, const float* weight, const color& albedo, const std::vector<uint16_t>& tile_lights) const {
+			return albedo;
+		}
+	};
+
+	template<bool textured, bool alpha_tested>
+	struct vertex_lit_fragment_stage : fragment_stage_base<textured, alpha_tested> {
+		static const bool DEFERRABLE = false;
+
+		color shade(const shader_context& context, const float* weight, const color& albedo, const std::vector<uint16_t>& tile_lights) const {
+			color light = context.vertex_color[0] * weight[0] + context.vertex_color[1] * weight[1] + context.vertex_color[2] * weight[2];
+			color source = light * albedo;
+			source.a = albedo.a;
+			return source;
+		}
+	};
+
+	template<bool textured, bool alpha_tested>
+	struct blinn_phong_fragment_stage : fragment_stage_base<textured, alpha_tested> {
+		static const bool DEFERRABLE = true;
+
+		color shade(const shader_context& context, const float* weight, const color& albedo, const std::vector<uint16_t>& tile_lights) const {
+			const material& m = *context.material;
+			vec3 v = context.w_v[0] * weight[0] + context.w_v[1] * weight[1] + context.w_v[2] * weight[2];
+			vec3 n = context.w_n[0] * weight[0] + context.w_n[1] * weight[1] + context.w_n[2] * weight[2];
+
+			color source = calculate_blinn_phong(v, n, albedo, m.specular, context.ambient, m.shininess, context.camera_position, *context.lights, tile_lights);
+
+			// Match alpha to diffuse.
+			source.a = albedo.a;
+			return source;
+		}
+	};
+
+	// Returns the rasterizer specialized for the material's shading model,
+	// texture & alpha test.
+	static triangle_rasterizer get_triangle_rasterizer(const material& material) {
+		static const triangle_rasterizer rasterizers[3][2][2] = {
+			{ // BLINN_PHONG
+				{ &software_gl::rasterize_triangle<no_vertex_stage, blinn_phong_fragment_stage<false, false>>, &software_gl::rasterize_triangle<no_vertex_stage, blinn_phong_fragment_stage<false, true>> },
+				{ &software_gl::rasterize_triangle<no_vertex_stage, blinn_phong_fragment_stage<true, false>>,  &software_gl::rasterize_triangle<no_vertex_stage, blinn_phong_fragment_stage<true, true>> }
+			},
+			{ // VERTEX_LIT
+				{ &software_gl::rasterize_triangle<lit_vertex_stage, vertex_lit_fragment_stage<false, false>>, &software_gl::rasterize_triangle<lit_vertex_stage, vertex_lit_fragment_stage<false, true>> },
+				{ &software_gl::rasterize_triangle<lit_vertex_stage, vertex_lit_fragment_stage<true, false>>,  &software_gl::rasterize_triangle<lit_vertex_stage, vertex_lit_fragment_stage<true, true>> }
+			},
+			{ // UNLIT
+				{ &software_gl::rasterize_triangle<no_vertex_stage, unlit_fragment_stage<false, false>>, &software_gl::rasterize_triangle<no_vertex_stage, unlit_fragment_stage<false, true>> },
+				{ &software_gl::rasterize_triangle<no_vertex_stage, unlit_fragment_stage<true, false>>,  &software_gl::rasterize_triangle<no_vertex_stage, unlit_fragment_stage<true, true>> }
+			}
+		};
+
+		int shading = math::clamp((int)material.shading, 0, 2);
+		return rasterizers[shading][material.texture != nullptr ? 1 : 0][material.alpha_cutoff > 0.0F ? 1 : 0];
+	}
+
+	// A mesh draw deferred by the depth prepass.
+	struct prepass_draw {
+		rge::material material;
+		uint16_t material_id;
+		vec3 camera_position;
+		triangle_rasterizer rasterizer;
+	};
+
+	// A projected triangle deferred by the depth prepass.
+	struct prepass_triangle {
+		vec4 r_v[3];
+		vec3 w_v[3];
+		vec3 w_n[3];
+		vec2 uv[3];
+		uint32_t draw;
+	};
+
+	std::vector<prepass_draw> prepass_draws;
+	std::vector<prepass_triangle> prepass_triangles;
+	render_target::ptr prepass_target;
+
+	// Lays down the depth of every queued triangle, then shades the ones
+	// that ended up in front.
+	void flush_prepass() {
+		if(prepass_triangles.empty()) return;
+
+		raster_pass passes[2] = { raster_pass::DEPTH_ONLY, raster_pass::COLOR_EQUAL };
+		for(int pass = 0; pass < 2; pass++) {
+			for(size_t i = 0; i < prepass_triangles.size(); i++) {
+				const prepass_triangle& t = prepass_triangles[i];
+				const prepass_draw& queued = prepass_draws[t.draw];
+				(this->*queued.rasterizer)(
+					*prepass_target,
+					passes[pass],
+					t.r_v[0], t.r_v[1], t.r_v[2],
+					t.w_v[0], t.w_v[1], t.w_v[2],
+					t.w_n[0], t.w_n[1], t.w_n[2],
+					t.uv[0], t.uv[1], t.uv[2],
+					queued.material,
+					queued.camera_position,
+					queued.material_id
+				);
+			}
+		}
+
+		prepass_draws.clear();
+		prepass_triangles.clear();
+		prepass_target = nullptr;
+	}
+
+	static const int LIGHT_TILE_SIZE = 16;
+
+	// The lights with a transform, & per screen tile the indices of the
+	// ones that can reach it. Directional lights are in every tile. Held
+	// by reference, so a light removed mid-frame outlives pending shading.
+	std::vector<light::ptr> culled_lights;
+	std::vector<uint16_t> all_lights; // Every culled light, for lighting vertices.
+	std::vector<std::vector<uint16_t>> light_tiles;
+	int light_tiles_x;
+	int light_tiles_width;
+	int light_tiles_height;
+	render_target::ptr light_tiles_target;
+	mat4 light_tiles_world_to_projection;
+	uint32_t light_tiles_generation;
+
+	// Rebuilds the light tiles once per frame, & whenever the camera,
+	// target or light list changes. Shading still waiting on the old tiles
+	// goes first.
+	void update_light_tiles(const mat4& world_to_projection) {
+		int w = get_real_target()->get_width();
+		int h = get_real_target()->get_height();
+		bool same_view = memcmp(&world_to_projection, &light_tiles_world_to_projection, sizeof(mat4)) == 0;
+		bool same_lights = light_tiles_generation == lights_generation;
+		if(light_tiles_target == get_real_target() && same_view && same_lights && light_tiles_width == w && light_tiles_height == h) return;
+
+		flush_prepass();
+		resolve_deferred();
+
+		light_tiles_target = get_real_target();
+		light_tiles_world_to_projection = world_to_projection;
+		light_tiles_generation = lights_generation;
+		light_tiles_width = w;
+		light_tiles_height = h;
+		light_tiles_x = (w + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+		int light_tiles_y = (h + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+
+		light_tiles.resize(light_tiles_x * light_tiles_y);
+		for(size_t i = 0; i < light_tiles.size(); i++) light_tiles[i].clear();
+
+		culled_lights.clear();
+		all_lights.clear();
+		for(size_t i = 0; i < lights.size() && culled_lights.size() <= UINT16_MAX; i++) {
+			light* light = lights[i].get();
+			if(light->transform == nullptr) continue;
+
+			uint16_t index = (uint16_t)culled_lights.size();
+			culled_lights.push_back(lights[i]);
+			all_lights.push_back(index);
+
+			if(light->type == light_mode::DIRECTIONAL) {
+				for(size_t t = 0; t < light_tiles.size(); t++) light_tiles[t].push_back(index);
+				continue;
+			}
+
+			// Screen bounds of the cube around the light's range. A corner
+			// behind the camera means the light can reach the whole screen.
+			vec3 center = light->transform->get_global_position();
+			float x_min = (float)w, y_min = (float)h, x_max = 0.0F, y_max = 0.0F;
+			int behind = 0, beyond = 0;
+			bool full_screen = false;
+
+			for(int c = 0; c < 8; c++) {
+				vec3 corner = center + vec3(c & 1 ? light->range : -light->range, c & 2 ? light->range : -light->range, c & 4 ? light->range : -light->range);
+				vec4 hp = world_to_projection * vec4(corner.x, corner.y, corner.z, 1);
+
+				if(hp.w <= 0.0F) {
+					full_screen = true;
+					behind++;
+					continue;
+				}
+				if(hp.z > hp.w) beyond++;
+
+				float sx = (hp.x / hp.w + 1.0F) / 2.0F * w;
+				float sy = (hp.y / hp.w + 1.0F) / 2.0F * h;
+				x_min = fminf(x_min, sx);
+				y_min = fminf(y_min, sy);
+				x_max = fmaxf(x_max, sx);
+				y_max = fmaxf(y_max, sy);
+			}
+
+			// Entirely behind the camera, or past the far plane.
+			if(behind == 8 || beyond == 8) continue;
+
+			int tx_min = 0, ty_min = 0, tx_max = light_tiles_x - 1, ty_max = light_tiles_y - 1;
+			if(!full_screen) {
+				if(x_max < 0.0F || y_max < 0.0F || x_min >= w || y_min >= h) continue;
+				tx_min = math::max((int)x_min / LIGHT_TILE_SIZE, 0);
+				ty_min = math::max((int)y_min / LIGHT_TILE_SIZE, 0);
+				tx_max = math::min((int)x_max / LIGHT_TILE_SIZE, light_tiles_x - 1);
+				ty_max = math::min((int)y_max / LIGHT_TILE_SIZE, light_tiles_y - 1);
+			}
+
+			for(int ty = ty_min; ty <= ty_max; ty++)
+				for(int tx = tx_min; tx <= tx_max; tx++)
+					light_tiles[tx + ty * light_tiles_x].push_back(index);
+		}
+	}
+
+	// Draws everything queued, in submission order.
+	void flush_batches() {
+		flush_prepass();
+		resolve_deferred();
+		flush_sprites();
+	}
+
+	// Surface attributes of the visible pixels, lit by resolve_deferred().
+	// Positions are rebuilt from the depth buffer. Rows are padded to a
+	// multiple of 4 pixels, so the lighting pass always reads whole lanes.
+	struct g_buffer {
+		int width;
+		int height;
+		int stride;
+		std::vector<float> normal_x;
+		std::vector<float> normal_y;
+		std::vector<float> normal_z;
+		std::vector<color> albedo;
+		std::vector<uint16_t> material_id; // 0 where nothing is waiting to be lit.
+	};
+
+	// The parts of a material the lighting pass needs, the rest is baked
+	// into the albedo.
+	struct g_buffer_material {
+		color specular;
+		float shininess;
+	};
+
+	g_buffer gbuffer;
+	std::vector<g_buffer_material> gbuffer_materials;
+	render_target::ptr gbuffer_target;
+	mat4 gbuffer_world_to_projection;
+	vec3 gbuffer_camera_position;
+
+	// Returns the G-buffer material ID for a mesh draw. Pixels waiting for
+	// another target or camera are lit first.
+	uint16_t get_gbuffer_material(const material& material, const mat4& world_to_projection, const vec3& camera_position) {
+		bool same_view = memcmp(&world_to_projection, &gbuffer_world_to_projection, sizeof(mat4)) == 0;
+		if(gbuffer_target != get_real_target() || !same_view || gbuffer_materials.size() > UINT16_MAX) {
+			flush_prepass();
+			resolve_deferred();
+		}
+
+		if(gbuffer_target != get_real_target() || gbuffer.width != get_real_target()->get_width() || gbuffer.height != get_real_target()->get_height()) {
+			gbuffer_target = get_real_target();
+			gbuffer.width = gbuffer_target->get_width();
+			gbuffer.height = gbuffer_target->get_height();
+			gbuffer.stride = (gbuffer.width + 3) & ~3;
+
+			size_t size = gbuffer.stride * gbuffer.height;
+			gbuffer.normal_x.assign(size, 0.0F);
+			gbuffer.normal_y.assign(size, 0.0F);
+			gbuffer.normal_z.assign(size, 0.0F);
+			gbuffer.albedo.assign(size, color());
+			gbuffer.material_id.assign(size, 0);
+		}
+
+		gbuffer_world_to_projection = world_to_projection;
+		gbuffer_camera_position = camera_position;
+
+		// ID 0 marks empty pixels.
+		if(gbuffer_materials.empty()) gbuffer_materials.push_back(g_buffer_material());
+
+		const g_buffer_material& last = gbuffer_materials.back();
+		if(gbuffer_materials.size() > 1 && last.shininess == material.shininess && memcmp(&last.specular, &material.specular, sizeof(color)) == 0)
+			return (uint16_t)(gbuffer_materials.size() - 1);
+
+		g_buffer_material entry = { material.specular, material.shininess };
+		gbuffer_materials.push_back(entry);
+		return (uint16_t)(gbuffer_materials.size() - 1);
+	}
+
+	// Lights every pixel written to the G-buffer since the last resolve,
+	// 4 pixels per SIMD lane set, rows spread across the job threads.
+	void resolve_deferred() {
+		if(gbuffer_materials.size() <= 1) return;
+
+		// A directional light is a direction with w = 0, the same as calculate_blinn_phong().
+		struct lane_light {
+			simd::f32x4 x, y, z, w;
+			simd::f32x4 r, g, b;
+			simd::f32x4 range;
+			bool directional;
+		};
+
+		std::vector<lane_light> lane_lights;
+		for(size_t i = 0; i < culled_lights.size(); i++) {
+			light* light = culled_lights[i].get();
+
+			bool directional = light->type == light_mode::DIRECTIONAL;
+			vec3 p = directional ? light->transform->get_global_backward() : light->transform->get_global_position();
+			color c = light->tint * light->intensity;
+
+			lane_light l = {
+				simd::set1(p.x), simd::set1(p.y), simd::set1(p.z), simd::set1(directional ? 0.0F : 1.0F),
+				simd::set1(c.r), simd::set1(c.g), simd::set1(c.b),
+				simd::set1(light->range),
+				directional
+			};
+			lane_lights.push_back(l);
+		}
+
+		color* frame_buffer = gbuffer_target->get_frame_buffer()->get_data();
+		const color* depth_buffer = gbuffer_target->get_depth_buffer()->get_data();
+		const g_buffer_material* materials = gbuffer_materials.data();
+		int width = gbuffer.width;
+		float ndc_scale_x = 2.0F / gbuffer.width;
+		float ndc_scale_y = 2.0F / gbuffer.height;
+
+		// Projection back to world space, one splat per matrix element.
+		mat4 projection_to_world = gbuffer_world_to_projection.inverse();
+		simd::f32x4 inv[4][4];
+		for(int r = 0; r < 4; r++)
+			for(int c = 0; c < 4; c++)
+				inv[r][c] = simd::set1(projection_to_world.m[r][c]);
+
+		simd::f32x4 zero = simd::set1(0.0F);
+		simd::f32x4 one = simd::set1(1.0F);
+		simd::f32x4 two = simd::set1(2.0F);
+		simd::f32x4 camera_x = simd::set1(gbuffer_camera_position.x);
+		simd::f32x4 camera_y = simd::set1(gbuffer_camera_position.y);
+		simd::f32x4 camera_z = simd::set1(gbuffer_camera_position.z);
+		simd::f32x4 ambient_r = simd::set1(ambient_color.r);
+		simd::f32x4 ambient_g = simd::set1(ambient_color.g);
+		simd::f32x4 ambient_b = simd::set1(ambient_color.b);
+
+		jobs::parallel_for(gbuffer.height, 4, [&](int begin, int end) {
+			float depth[4], ndc_x[4];
+			float albedo_r[4], albedo_g[4], albedo_b[4];
+			float specular_r[4], specular_g[4], specular_b[4], shininess[4];
+			float lane[4], power[4];
+			float out_r[4], out_g[4], out_b[4];
+
+			for(int y = begin; y < end; y++) {
+				simd::f32x4 ndc_y = simd::set1((y + 0.5F) * ndc_scale_y - 1.0F);
+
+				for(int x = 0; x < width; x += 4) {
+					int gptr = x + y * gbuffer.stride;
+					const uint16_t* ids = &gbuffer.material_id[gptr];
+					if((ids[0] | ids[1] | ids[2] | ids[3]) == 0) continue;
+
+					// Gather the per pixel attributes that are not stored as planes.
+					for(int i = 0; i < 4; i++) {
+						const color& albedo = gbuffer.albedo[gptr + i];
+						const g_buffer_material& m = materials[ids[i]];
+						depth[i] = ids[i] != 0 ? depth_buffer[x + i + y * width].r : 1.0F;
+						ndc_x[i] = (x + i + 0.5F) * ndc_scale_x - 1.0F;
+						albedo_r[i] = albedo.r;
+						albedo_g[i] = albedo.g;
+						albedo_b[i] = albedo.b;
+						specular_r[i] = m.specular.r;
+						specular_g[i] = m.specular.g;
+						specular_b[i] = m.specular.b;
+						shininess[i] = m.shininess * 128;
+					}
+
+					// World position, from the pixel center & its [0, 1] depth.
+					simd::f32x4 px = simd::load(ndc_x);
+					simd::f32x4 pz = simd::sub(simd::mul(simd::load(depth), two), one);
+					simd::f32x4 hx = simd::add(simd::add(simd::mul(inv[0][0], px), simd::mul(inv[0][1], ndc_y)), simd::add(simd::mul(inv[0][2], pz), inv[0][3]));
+					simd::f32x4 hy = simd::add(simd::add(simd::mul(inv[1][0], px), simd::mul(inv[1][1], ndc_y)), simd::add(simd::mul(inv[1][2], pz), inv[1][3]));
+					simd::f32x4 hz = simd::add(simd::add(simd::mul(inv[2][0], px), simd::mul(inv[2][1], ndc_y)), simd::add(simd::mul(inv[2][2], pz), inv[2][3]));
+					simd::f32x4 hw = simd::add(simd::add(simd::mul(inv[3][0], px), simd::mul(inv[3][1], ndc_y)), simd::add(simd::mul(inv[3][2], pz), inv[3][3]));
+					simd::f32x4 rcp_w = simd::div(one, hw);
+					simd::f32x4 wx = simd::mul(hx, rcp_w);
+					simd::f32x4 wy = simd::mul(hy, rcp_w);
+					simd::f32x4 wz = simd::mul(hz, rcp_w);
+
+					// Normal & view direction, normalized.
+					simd::f32x4 nx = simd::load(&gbuffer.normal_x[gptr]);
+					simd::f32x4 ny = simd::load(&gbuffer.normal_y[gptr]);
+					simd::f32x4 nz = simd::load(&gbuffer.normal_z[gptr]);
+					simd::f32x4 n_scale = simd::div(one, simd::sqrt(simd::add(simd::add(simd::mul(nx, nx), simd::mul(ny, ny)), simd::mul(nz, nz))));
+					nx = simd::mul(nx, n_scale);
+					ny = simd::mul(ny, n_scale);
+					nz = simd::mul(nz, n_scale);
+
+					simd::f32x4 vx = simd::sub(camera_x, wx);
+					simd::f32x4 vy = simd::sub(camera_y, wy);
+					simd::f32x4 vz = simd::sub(camera_z, wz);
+					simd::f32x4 v_scale = simd::div(one, simd::sqrt(simd::add(simd::add(simd::mul(vx, vx), simd::mul(vy, vy)), simd::mul(vz, vz))));
+					vx = simd::mul(vx, v_scale);
+					vy = simd::mul(vy, v_scale);
+					vz = simd::mul(vz, v_scale);
+
+					simd::f32x4 ar = simd::load(albedo_r);
+					simd::f32x4 ag = simd::load(albedo_g);
+					simd::f32x4 ab = simd::load(albedo_b);
+					simd::f32x4 sr = simd::load(specular_r);
+					simd::f32x4 sg = simd::load(specular_g);
+					simd::f32x4 sb = simd::load(specular_b);
+					simd::f32x4 n_dot_v = simd::max(zero, simd::add(simd::add(simd::mul(nx, vx), simd::mul(ny, vy)), simd::mul(nz, vz)));
+
+					simd::f32x4 sum_r = simd::mul(ambient_r, ar);
+					simd::f32x4 sum_g = simd::mul(ambient_g, ag);
+					simd::f32x4 sum_b = simd::mul(ambient_b, ab);
+
+					// Light tiles are a multiple of 4 pixels wide, so all 4 share one.
+					const std::vector<uint16_t>& tile_lights = light_tiles[x / LIGHT_TILE_SIZE + y / LIGHT_TILE_SIZE * light_tiles_x];
+					for(size_t l = 0; l < tile_lights.size(); l++) {
+						const lane_light& light = lane_lights[tile_lights[l]];
+
+						// Light direction, unnormalized for point lights.
+						simd::f32x4 lx = simd::sub(light.x, simd::mul(wx, light.w));
+						simd::f32x4 ly = simd::sub(light.y, simd::mul(wy, light.w));
+						simd::f32x4 lz = simd::sub(light.z, simd::mul(wz, light.w));
+
+						simd::f32x4 lr = light.r, lg = light.g, lb = light.b;
+						simd::f32x4 attenuation = one;
+						if(!light.directional) {
+							simd::f32x4 distance = simd::sqrt(simd::add(simd::add(simd::mul(lx, lx), simd::mul(ly, ly)), simd::mul(lz, lz)));
+							attenuation = simd::div(one, distance);
+							lr = simd::mask_less(distance, light.range, lr);
+							lg = simd::mask_less(distance, light.range, lg);
+							lb = simd::mask_less(distance, light.range, lb);
+						}
+
+						simd::f32x4 diffuse_term = simd::mul(n_dot_v, attenuation);
+						sum_r = simd::add(sum_r, simd::mul(simd::mul(lr, ar), diffuse_term));
+						sum_g = simd::add(sum_g, simd::mul(simd::mul(lg, ag), diffuse_term));
+						sum_b = simd::add(sum_b, simd::mul(simd::mul(lb, ab), diffuse_term));
+
+						// Blinn-Phong half vector, only lit where the normal faces the light.
+						simd::f32x4 n_dot_l = simd::add(simd::add(simd::mul(nx, lx), simd::mul(ny, ly)), simd::mul(nz, lz));
+						simd::f32x4 half_x = simd::add(lx, vx);
+						simd::f32x4 half_y = simd::add(ly, vy);
+						simd::f32x4 half_z = simd::add(lz, vz);
+						simd::f32x4 half_scale = simd::div(one, simd::sqrt(simd::add(simd::add(simd::mul(half_x, half_x), simd::mul(half_y, half_y)), simd::mul(half_z, half_z))));
+						simd::f32x4 n_dot_h = simd::max(zero, simd::mul(simd::add(simd::add(simd::mul(nx, half_x), simd::mul(ny, half_y)), simd::mul(nz, half_z)), half_scale));
+
+						// No vector pow, so the exponent is per lane.
+						simd::store(lane, n_dot_h);
+						simd::store(power, n_dot_l);
+						for(int i = 0; i < 4; i++) power[i] = power[i] < 0.0F ? 0.0F : powf(lane[i], shininess[i]);
+
+						simd::f32x4 specular_term = simd::mul(simd::load(power), attenuation);
+						sum_r = simd::add(sum_r, simd::mul(simd::mul(lr, sr), specular_term));
+						sum_g = simd::add(sum_g, simd::mul(simd::mul(lg, sg), specular_term));
+						sum_b = simd::add(sum_b, simd::mul(simd::mul(lb, sb), specular_term));
+					}
+
+					simd::store(out_r, sum_r);
+					simd::store(out_g, sum_g);
+					simd::store(out_b, sum_b);
+
+					uint16_t* written = &gbuffer.material_id[gptr];
+					for(int i = 0; i < 4; i++) {
+						if(written[i] == 0) continue;
+						frame_buffer[x + i + y * width] = color(out_r[i], out_g[i], out_b[i], gbuffer.albedo[gptr + i].a);
+						written[i] = 0;
+					}
+				}
+			}
+		});
+
+		gbuffer_materials.clear();
+	}
+
+	static const int SPRITE_TILE_SIZE = 64;
+	static const int SPRITE_SUBPIXELS = 16; // Sprite corners snap to 1/16th of a pixel.
+
+	// A queued sprite, already projected to screen space.
+	struct sprite_batch_item {
+		vec3 corners[4]; // Screen x, y & depth, in bl, br, tr, tl order.
+		int x_min, y_min, x_max, y_max;
+		float depth;
+		int layer;
+		uint32_t order;
+		color tint;
+		rge::texture::ptr texture;
+	};
+
+	// One of the two triangles of a sprite quad, with the screen space
+	// gradients of its affine uv & depth.
+	struct sprite_triangle {
+		vec2 origin;
+		float u0, v0, z0;
+		float dudx, dudy, dvdx, dvdy, dzdx, dzdy;
+	};
+
+	// Coverage of a sprite quad, tested in integers on corners snapped to
+	// SPRITE_SUBPIXELS. Top-left edges own the pixel centers on them, so
+	// quads sharing an edge never both draw a pixel, however their corners
+	// round.
+	struct sprite_edges {
+		int64_t a[4], b[4], c[4];
+		int64_t bias[4]; // 0 for top-left edges, -1 for the others.
+		int64_t diag_a, diag_b, diag_c;
+	};
+
+	std::vector<sprite_batch_item> sprite_batch;
+	std::vector<std::vector<uint32_t>> sprite_tiles;
+	render_target::ptr sprite_batch_target;
+
+	// Projects the corners of a sprite of a width x height texture to a
+	// target's pixels, as x, y & depth in bl, br, tr, tl order. Returns
+	// false when the view volume culls it.
+	bool project_sprite(const sprite& sprite, int width, int height, float wt, float ht, vec3* corners) const {
+		mat4 sprite_matrix = sprite.transform->get_global_matrix();
+		mat4 camera_matrix = input_camera->transform->get_global_matrix();
+		mat4 world_to_projection = input_camera->get_projection_matrix() * input_camera->get_view_matrix();
+
+		float w = float(width) / sprite.pixels_per_unit;
+		float h = float(height) / sprite.pixels_per_unit;
+
+		vec3 p = vec2(0, 0);
+		vec3 r = vec2(w, 0);
+		vec3 u = vec2(0, h);
+
+		if(sprite.centered) {
+			p.x -= w / 2.0F;
+			p.y -= h / 2.0F;
+		}
+
+		if(sprite.billboard) {
+			corners[0] = sprite_matrix.multiply_point_3x4(p);
+			corners[1] = corners[0] + camera_matrix.multiply_vector(r);
+			corners[2] = corners[0] + camera_matrix.multiply_vector(u + r);
+			corners[3] = corners[0] + camera_matrix.multiply_vector(u);
+		} else {
+			corners[0] = sprite_matrix.multiply_point_3x4(p);
+			corners[1] = sprite_matrix.multiply_point_3x4(p + r);
+			corners[2] = sprite_matrix.multiply_point_3x4(p + r + u);
+			corners[3] = sprite_matrix.multiply_point_3x4(p + u);
+		}
+
+		int outside_left = 0, outside_right = 0, outside_bottom = 0, outside_top = 0, outside_depth = 0;
+
+		for(int i = 0; i < 4; i++) {
+			vec4 proj = project_world_vertex(corners[i], world_to_projection);
+
+			// Cull against the view volume, a sprite is out if all corners
+			// are past the same side.
+			if(proj.x < -1.0F) outside_left++;
+			if(proj.x > 1.0F) outside_right++;
+			if(proj.y < -1.0F) outside_bottom++;
+			if(proj.y > 1.0F) outside_top++;
+			if(proj.z < -1.0F || proj.z > 1.0F || proj.w <= 0.0F) outside_depth++;
+
+			corners[i] = vec3((proj.x + 1.0F) / 2.0F * wt, (proj.y + 1.0F) / 2.0F * ht, proj.z / 2.0F + 0.5F);
+		}
+
+		// Sprites crossing the near or far plane are dropped, as there is no clipping.
+		return !(outside_left == 4 || outside_right == 4 || outside_bottom == 4 || outside_top == 4 || outside_depth > 0);
+	}
+
+	static bool sprite_draws_before(const sprite_batch_item& a, const sprite_batch_item& b) {
+		if(a.layer != b.layer) return a.layer < b.layer;
+		if(a.depth != b.depth) return a.depth > b.depth;
+		if(a.texture != b.texture) return a.texture < b.texture;
+		return a.order < b.order;
+	}
+
+	static sprite_triangle setup_sprite_triangle(const vec3& p0, const vec3& p1, const vec3& p2, const vec2& t0, const vec2& t1, const vec2& t2) {
+		sprite_triangle tri;
+		float e1x = p1.x - p0.x, e1y = p1.y - p0.y;
+		float e2x = p2.x - p0.x, e2y = p2.y - p0.y;
+		float det = e1x * e2y - e2x * e1y;
+		float inv = det != 0.0F ? 1.0F / det : 0.0F;
+
+		tri.origin = vec2(p0.x, p0.y);
+		tri.u0 = t0.x;
+		tri.v0 = t0.y;
+		tri.z0 = p0.z;
+		tri.dudx = ((t1.x - t0.x) * e2y - (t2.x - t0.x) * e1y) * inv;
+		tri.dudy = ((t2.x - t0.x) * e1x - (t1.x - t0.x) * e2x) * inv;
+		tri.dvdx = ((t1.y - t0.y) * e2y - (t2.y - t0.y) * e1y) * inv;
+		tri.dvdy = ((t2.y - t0.y) * e1x - (t1.y - t0.y) * e2x) * inv;
+		tri.dzdx = ((p1.z - p0.z) * e2y - (p2.z - p0.z) * e1y) * inv;
+		tri.dzdy = ((p2.z - p0.z) * e1x - (p1.z - p0.z) * e2x) * inv;
+		return tri;
+	}
+
+	// Returns a screen coord in SPRITE_SUBPIXELS, limited so the edge
+	// products of sprite_edges stay within 64 bits.
+	static int64_t snap_sprite_coord(float v) {
+		const float limit = float(1 << 24);
+		return (int64_t)lrintf(fminf(fmaxf(v * SPRITE_SUBPIXELS, -limit), limit));
+	}
+
+	// Returns the first pixel whose center is at or past a snapped coord.
+	static int first_sprite_pixel(int64_t v) {
+		v -= SPRITE_SUBPIXELS / 2;
+		return (int)(v >= 0 ? (v + SPRITE_SUBPIXELS - 1) / SPRITE_SUBPIXELS : -(-v / SPRITE_SUBPIXELS));
+	}
+
+	static sprite_edges setup_sprite_edges(const vec3* corners) {
+		int64_t x[4], y[4];
+		for(int i = 0; i < 4; i++) {
+			x[i] = snap_sprite_coord(corners[i].x);
+			y[i] = snap_sprite_coord(corners[i].y);
+		}
+
+		// Flipped so the inside is positive for either winding.
+		int64_t area = 0;
+		for(int i = 0; i < 4; i++) area += x[i] * y[(i + 1) % 4] - x[(i + 1) % 4] * y[i];
+		int64_t winding = area < 0 ? -1 : 1;
+
+		sprite_edges edges;
+		for(int i = 0; i < 4; i++) {
+			int j = (i + 1) % 4;
+			edges.a[i] = (y[i] - y[j]) * winding;
+			edges.b[i] = (x[j] - x[i]) * winding;
+			edges.c[i] = (x[i] * y[j] - x[j] * y[i]) * winding;
+			edges.bias[i] = edges.a[i] > 0 || (edges.a[i] == 0 && edges.b[i] > 0) ? 0 : -1;
+		}
+
+		// Diagonal bl-tr, positive on the br side.
+		edges.diag_a = (y[2] - y[0]) * winding;
+		edges.diag_b = (x[0] - x[2]) * winding;
+		edges.diag_c = (x[2] * y[0] - x[0] * y[2]) * winding;
+		return edges;
+	}
+
+	static inline bool sprite_covers(const sprite_edges& edges, int x, int y) {
+		int64_t px = (int64_t)x * SPRITE_SUBPIXELS + SPRITE_SUBPIXELS / 2;
+		int64_t py = (int64_t)y * SPRITE_SUBPIXELS + SPRITE_SUBPIXELS / 2;
+		for(int i = 0; i < 4; i++)
+			if(edges.a[i] * px + edges.b[i] * py + edges.c[i] + edges.bias[i] < 0) return false;
+		return true;
+	}
+
+	// Returns which of the two sprite triangles holds a pixel, 0 for bl-br-tr.
+	static inline int sprite_triangle_at(const sprite_edges& edges, int x, int y) {
+		int64_t px = (int64_t)x * SPRITE_SUBPIXELS + SPRITE_SUBPIXELS / 2;
+		int64_t py = (int64_t)y * SPRITE_SUBPIXELS + SPRITE_SUBPIXELS / 2;
+		return edges.diag_a * px + edges.diag_b * py + edges.diag_c >= 0 ? 0 : 1;
+	}
+
+	// Sorts the queued sprites, bins them into screen tiles & draws the
+	// tiles in parallel. Tiles never overlap, so workers never share pixels.
+	void flush_sprites() {
+		if(sprite_batch.empty()) return;
+
+		// Sprites depth test against, & blend over, the meshes drawn before them.
+		flush_prepass();
+		resolve_deferred();
+
+		int wt = sprite_batch_target->get_width();
+		int ht = sprite_batch_target->get_height();
+		int tiles_x = (wt + SPRITE_TILE_SIZE - 1) / SPRITE_TILE_SIZE;
+		int tiles_y = (ht + SPRITE_TILE_SIZE - 1) / SPRITE_TILE_SIZE;
+
+		std::sort(sprite_batch.begin(), sprite_batch.end(), sprite_draws_before);
+
+		// Binning in draw order keeps every tile's list sorted.
+		sprite_tiles.resize(tiles_x * tiles_y);
+		for(size_t i = 0; i < sprite_tiles.size(); i++) sprite_tiles[i].clear();
+
+		for(uint32_t i = 0; i < (uint32_t)sprite_batch.size(); i++) {
+			const sprite_batch_item& item = sprite_batch[i];
+			for(int ty = item.y_min / SPRITE_TILE_SIZE; ty <= (item.y_max - 1) / SPRITE_TILE_SIZE; ty++)
+				for(int tx = item.x_min / SPRITE_TILE_SIZE; tx <= (item.x_max - 1) / SPRITE_TILE_SIZE; tx++)
+					sprite_tiles[tx + ty * tiles_x].push_back(i);
+		}
+
+		color* frame_buffer = sprite_batch_target->get_frame_buffer()->get_data();
+		color* depth_buffer = sprite_batch_target->get_depth_buffer()->get_data();
+		render_target::depth_tile* depth_tiles = sprite_batch_target->get_depth_tiles();
+		int depth_tiles_x = sprite_batch_target->get_depth_tiles_x();
+		render_target* target = sprite_batch_target.get();
+
+		jobs::parallel_for(tiles_x * tiles_y, 1, [&](int begin, int end) {
+			for(int tile = begin; tile < end; tile++) {
+				int tx = (tile % tiles_x) * SPRITE_TILE_SIZE;
+				int ty = (tile / tiles_x) * SPRITE_TILE_SIZE;
+				int tile_x_max = math::min(tx + SPRITE_TILE_SIZE, wt);
+				int tile_y_max = math::min(ty + SPRITE_TILE_SIZE, ht);
+
+				// Sprite tiles are made of whole depth tiles, so are their lazy clears.
+				const std::vector<uint32_t>& bin = sprite_tiles[tile];
+				for(size_t i = 0; i < bin.size(); i++) {
+					const sprite_batch_item& item = sprite_batch[bin[i]];
+					target->resolve_clear(
+						math::max(tx, item.x_min),
+						math::max(ty, item.y_min),
+						math::min(tile_x_max, item.x_max),
+						math::min(tile_y_max, item.y_max)
+					);
+					rasterize_sprite(
+						item,
+						math::max(tx, item.x_min),
+						math::max(ty, item.y_min),
+						math::min(tile_x_max, item.x_max),
+						math::min(tile_y_max, item.y_max),
+						wt,
+						frame_buffer,
+						depth_buffer,
+						depth_tiles,
+						depth_tiles_x
+					);
+				}
+			}
+		});
+
+		sprite_batch.clear();
+		sprite_batch_target = nullptr;
+	}
+
+	// Draws the part of a sprite quad inside [x_min, x_max) x [y_min, y_max),
+	// as two affine mapped triangles split along the bl-tr diagonal.
+	// Sprite tiles are whole depth tiles, so workers never share one.
+	static void rasterize_sprite(const sprite_batch_item& item, int x_min, int y_min, int x_max, int y_max, int stride, color* frame_buffer, color* depth_buffer, render_target::depth_tile* depth_tiles, int depth_tiles_x) {
+		const vec3* c = item.corners;
+
+		// Texel row 0 is the top of the image.
+		sprite_triangle tris[2] = {
+			setup_sprite_triangle(c[0], c[1], c[2], vec2(0, 1), vec2(1, 1), vec2(1, 0)),
+			setup_sprite_triangle(c[0], c[2], c[3], vec2(0, 1), vec2(1, 0), vec2(0, 0))
+		};
+
+		sprite_edges edges = setup_sprite_edges(c);
+
+		simd::f32x4 tint = simd::load(item.tint);
+		int span_x[4];
+		float span_u[4], span_v[4], span_z[4];
+		color texels[4];
+
+		for(int y = y_min; y < y_max; y++) {
+			float py = y + 0.5F;
+			int count = 0;
+
+			for(int x = x_min; x < x_max; x++) {
+				float px = x + 0.5F;
+
+				if(sprite_covers(edges, x, y)) {
+					const sprite_triangle& tri = tris[sprite_triangle_at(edges, x, y)];
+					float dx = px - tri.origin.x;
+					float dy = py - tri.origin.y;
+					float z = tri.z0 + tri.dzdx * dx + tri.dzdy * dy;
+
+					if(z < depth_buffer[x + y * stride].r) {
+						span_x[count] = x;
+						span_u[count] = tri.u0 + tri.dudx * dx + tri.dudy * dy;
+						span_v[count] = tri.v0 + tri.dvdx * dx + tri.dvdy * dy;
+						span_z[count] = z;
+						count++;
+					}
+				}
+
+				// Fetch & blend in batches of 4 pixels.
+				if(count == 4 || (x == x_max - 1 && count > 0)) {
+					for(int i = count; i < 4; i++) {
+						span_u[i] = 0.0F;
+						span_v[i] = 0.0F;
+					}
+
+					item.texture->sample4(span_u, span_v, texels);
+
+					for(int i = 0; i < count; i++) {
+						if(texels[i].a * item.tint.a <= 0.0F) continue;
+
+						int ptr = span_x[i] + y * stride;
+						simd::f32x4 src = simd::mul(simd::load(texels[i]), tint);
+						simd::store(frame_buffer[ptr], simd::lerp(simd::load(frame_buffer[ptr]), src, simd::splat_w(src)));
+						depth_buffer[ptr].r = span_z[i];
+
+						// The tile max stays a valid, if loose, bound.
+						render_target::depth_tile& tile = depth_tiles[span_x[i] / render_target::DEPTH_TILE_SIZE + y / render_target::DEPTH_TILE_SIZE * depth_tiles_x];
+						tile.min = fminf(tile.min, span_z[i]);
+					}
+
+					count = 0;
+				}
+			}
+		}
+	}
+
+	// Writes a span of source colors over the frame, combined by blit mode.
+	void blit_span(color* dest, const color* src, int count) {
+		if(current_blit_mode == blit_mode::COPY) {
+			memcpy(dest, src, count * sizeof(color));
+		} else if(current_blit_mode == blit_mode::ALPHA_BLEND) {
+			for(int i = 0; i < count; i++) {
+				simd::f32x4 s = simd::load(src[i]);
+				simd::store(dest[i], simd::lerp(simd::load(dest[i]), s, simd::splat_w(s)));
+			}
+		} else if(current_blit_mode == blit_mode::COLOR_KEY) {
+			simd::f32x4 key = simd::load(color_key);
+			for(int i = 0; i < count; i++) {
+				simd::f32x4 s = simd::load(src[i]);
+				if(!simd::all_equal(s, key)) simd::store(dest[i], s);
+			}
+		}
+	}
+
+	// Rasterizes a triangle in 2x2 pixel quads, running the vertex stage
+	// once & the fragment stage per covered pixel. Every shader gets its
+	// own copy of the loops, see get_triangle_rasterizer().
+	template<class vertex_stage, class fragment_stage>
+	void rasterize_triangle(
+		render_target& target,
+		raster_pass pass,
+		const vec4& r_v1, // <- render_target coords
+		const vec4& r_v2, // <- ^^^
+		const vec4& r_v3, // <- ^^^
+		const vec3& w_v1, // <- world vertices
+		const vec3& w_v2, // <- ^^^
+		const vec3& w_v3, // <- ^^^
+		const vec3& w_n1, // <- world normals
+		const vec3& w_n2, // <- ^^^
+		const vec3& w_n3, // <- ^^^
+		const vec2& t_uv1, // <- texture coords
+		const vec2& t_uv2, // <- ^^^
+		const vec2& t_uv3, // <- ^^^
+		const material& material,
+		const vec3& camera_position,
+		uint16_t material_id // <- G-buffer material, 0 to shade right away
+	) {
+		int x, y;
+		int ptr;
+		float weight_v1, weight_v2, weight_v3;
+		float depth;
+		vec3 n;
+		vec2 uv;
+		color albedo;
+		color* frame_buffer = target.get_frame_buffer()->get_data();
+		color* depth_buffer = target.get_depth_buffer()->get_data();
+
+		int target_width = target.get_width();
+		int target_height = target.get_height();
+
+		render_target::depth_tile* depth_tiles = target.get_depth_tiles();
+		int depth_tiles_x = target.get_depth_tiles_x();
+		const int tile_size = render_target::DEPTH_TILE_SIZE;
+
+		// Trilinear textures pick a mip level once per 2x2 pixel quad.
+		bool use_lod = fragment_stage::TEXTURED && material.texture->filter == texture_filter::TRILINEAR && material.texture->get_mip_count() > 1;
+		float lod = 0.0F;
+
+		// Per pixel state of the current quad, so its texels are fetched in one batch.
+		bool quad_active[4];
+		int quad_ptr[4];
+		float quad_depth[4];
+		float quad_weight[4][3];
+		float quad_u[4];
+		float quad_v[4];
+		color quad_texel[4];
+
+		const vec3 w_v[3] = { w_v1, w_v2, w_v3 };
+		const vec3 w_n[3] = { w_n1, w_n2, w_n3 };
+		shader_context context;
+		context.material = &material;
+		context.w_v = w_v;
+		context.w_n = w_n;
+		context.camera_position = camera_position;
+		context.ambient = ambient_color;
+		context.lights = &culled_lights;
+		context.vertex_lights = &all_lights;
+
+		vertex_stage vertex;
+		fragment_stage fragment;
+
+		// Pixels still waiting in the G-buffer would be lit over the ones
+		// shaded right away.
+		uint16_t* material_ids = material_id == 0 && gbuffer_materials.size() > 1 && gbuffer_target.get() == &target ? gbuffer.material_id.data() : nullptr;
+
+		// Calculate the bounding rectangle of the triangle based on the
+		// three vertices.
+		int x_min = (int)fminf(r_v1.x, fminf(r_v2.x, r_v3.x));
+		int x_max = (int)fmaxf(r_v1.x, fmaxf(r_v2.x, r_v3.x));
+		int y_min = (int)fminf(r_v1.y, fminf(r_v2.y, r_v3.y));
+		int y_max = (int)fmaxf(r_v1.y, fmaxf(r_v2.y, r_v3.y));
+
+		// Cull the bounding rect to the size of the texture we're rendering to.
+		if(x_min < 0) x_min = 0;
+		if(x_max > target_width - 1) x_max = target_width - 1;
+		if(y_min < 0) y_min = 0;
+		if(y_max > target_height - 1) y_max = target_height - 1;
+		if(x_min > x_max || y_min > y_max) return;
+
+		// Depth is affine across the triangle, so the vertices bound it.
+		float z_min = fminf(r_v1.z, fminf(r_v2.z, r_v3.z));
+		float z_max = fmaxf(r_v1.z, fmaxf(r_v2.z, r_v3.z));
+
+		// Snap the vertices to 28.4 fixed point, so coverage is exact & the
+		// same for both triangles sharing an edge.
+		int64_t fx1 = (int64_t)lrintf(r_v1.x * SUBPIXELS), fy1 = (int64_t)lrintf(r_v1.y * SUBPIXELS);
+		int64_t fx2 = (int64_t)lrintf(r_v2.x * SUBPIXELS), fy2 = (int64_t)lrintf(r_v2.y * SUBPIXELS);
+		int64_t fx3 = (int64_t)lrintf(r_v3.x * SUBPIXELS), fy3 = (int64_t)lrintf(r_v3.y * SUBPIXELS);
+
+		// Edge functions, e = a * x + b * y + c, each opposite the vertex
+		// whose weight it gives.
+		int64_t edge_a[3] = { fy2 - fy3, fy3 - fy1, fy1 - fy2 };
+		int64_t edge_b[3] = { fx3 - fx2, fx1 - fx3, fx2 - fx1 };
+		int64_t edge_c[3] = { fx2 * fy3 - fy2 * fx3, fx3 * fy1 - fy3 * fx1, fx1 * fy2 - fy1 * fx2 };
+
+		// Twice the signed area, the same for either winding once flipped.
+		int64_t area = edge_c[0] + edge_c[1] + edge_c[2];
+		if(area == 0) return;
+		int64_t winding = area > 0 ? 1 : -1;
+		float inv_area = 1.0F / (float)area;
+
+		// Top-left fill rule: pixel centers exactly on an edge only belong to
+		// the triangle if that is its top or left edge.
+		int64_t edge_bias[3];
+		for(int e = 0; e < 3; e++)
+			edge_bias[e] = is_top_left_edge(edge_b[e] * winding, -edge_a[e] * winding) ? 0 : 1;
+
+		// 1/w of each vertex, attributes interpolate linearly in 1/w space.
+		float inv_w1 = r_v1.w != 0.0F ? 1.0F / r_v1.w : 1.0F;
+		float inv_w2 = r_v2.w != 0.0F ? 1.0F / r_v2.w : 1.0F;
+		float inv_w3 = r_v3.w != 0.0F ? 1.0F / r_v3.w : 1.0F;
+
+		if(pass != raster_pass::DEPTH_ONLY) vertex(context);
+
+		// Walk the covered depth tiles, in 2x2 pixel quads within each.
+		for(int ty = y_min / tile_size; ty <= y_max / tile_size; ty++) {
+			for(int tx = x_min / tile_size; tx <= x_max / tile_size; tx++) {
+				render_target::depth_tile& tile = depth_tiles[tx + ty * depth_tiles_x];
+
+				// Behind everything already drawn in this tile.
+				if(pass == raster_pass::COLOR_EQUAL ? z_min > tile.max : z_min >= tile.max) continue;
+
+				// In front of everything drawn in this tile, every depth test passes.
+				bool in_front = pass != raster_pass::COLOR_EQUAL && z_max < tile.min;
+
+				int tile_x_min = math::max(x_min, tx * tile_size);
+				int tile_x_max = math::min(x_max, tx * tile_size + tile_size - 1);
+				int tile_y_min = math::max(y_min, ty * tile_size);
+				int tile_y_max = math::min(y_max, ty * tile_size + tile_size - 1);
+
+				target.resolve_clear(tile_x_min, tile_y_min, tile_x_max + 1, tile_y_max + 1);
+
+				// Depth tiles are never split across light tiles.
+				const std::vector<uint16_t>& tile_lights = light_tiles[tx * tile_size / LIGHT_TILE_SIZE + ty * tile_size / LIGHT_TILE_SIZE * light_tiles_x];
+
+				// Bounds of the depth written to this tile.
+				int written = 0;
+				float written_min = 1.0F;
+				float written_max = 0.0F;
+
+				for(y = tile_y_min & ~1; y <= tile_y_max; y += 2) {
+					for(x = tile_x_min & ~1; x <= tile_x_max; x += 2) {
+						int active_count = 0;
+
+						for(int i = 0; i < 4; i++) {
+							int px = x + (i & 1);
+							int py = y + (i >> 1);
+
+							quad_active[i] = false;
+							quad_u[i] = 0.0F;
+							quad_v[i] = 0.0F;
+
+							if(px < tile_x_min || px > tile_x_max || py < tile_y_min || py > tile_y_max) continue;
+
+							// Pixel center in 28.4 fixed point.
+							int64_t cx = ((int64_t)px << SUBPIXEL_BITS) + SUBPIXELS / 2;
+							int64_t cy = ((int64_t)py << SUBPIXEL_BITS) + SUBPIXELS / 2;
+
+							int64_t e1 = edge_a[0] * cx + edge_b[0] * cy + edge_c[0];
+							int64_t e2 = edge_a[1] * cx + edge_b[1] * cy + edge_c[1];
+							int64_t e3 = edge_a[2] * cx + edge_b[2] * cy + edge_c[2];
+
+							// Inside when on the inner side of all three edges.
+							if(e1 * winding < edge_bias[0] || e2 * winding < edge_bias[1] || e3 * winding < edge_bias[2]) continue;
+
+							// Calculate the weights w1, w2 and w3 for the barycentric
+							// coordinates, linear in screen space.
+							weight_v1 = (float)e1 * inv_area;
+							weight_v2 = (float)e2 * inv_area;
+							weight_v3 = 1.0F - weight_v1 - weight_v2;
+
+							// Calculate the position in our buffer based on our x and y values.
+							ptr = px + (py * target_width);
+
+							// Calculate the depth value of this pixel.
+							depth = r_v1.z * weight_v1 + r_v2.z * weight_v2 + r_v3.z * weight_v3;
+
+							// If the depth value is less than what is currently in the
+							// depth buffer for this pixel. After a prepass only the
+							// exact winning depth is shaded.
+							if(pass == raster_pass::COLOR_EQUAL) {
+								if(depth != depth_buffer[ptr].r) continue;
+							} else if(!in_front && depth >= depth_buffer[ptr].r) {
+								continue;
+							}
+
+							if(pass == raster_pass::DEPTH_ONLY) {
+								depth_buffer[ptr].r = depth;
+								written_min = fminf(written_min, depth);
+								written_max = fmaxf(written_max, depth);
+								written++;
+								continue;
+							}
+
+							// Perspective correct weights for the other attributes.
+							float perspective_v1 = weight_v1 * inv_w1;
+							float perspective_v2 = weight_v2 * inv_w2;
+							float perspective_v3 = weight_v3 * inv_w3;
+							float perspective_scale = 1.0F / (perspective_v1 + perspective_v2 + perspective_v3);
+							weight_v1 = perspective_v1 * perspective_scale;
+							weight_v2 = perspective_v2 * perspective_scale;
+							weight_v3 = perspective_v3 * perspective_scale;
+
+							// Calculate the UV coordinate for this pixel.
+							if(fragment_stage::TEXTURED) {
+								uv = t_uv1 * weight_v1 + t_uv2 * weight_v2 + t_uv3 * weight_v3;
+								quad_u[i] = uv.x;
+								quad_v[i] = uv.y;
+							}
+
+							quad_active[i] = true;
+							quad_ptr[i] = ptr;
+							quad_depth[i] = depth;
+							quad_weight[i][0] = weight_v1;
+							quad_weight[i][1] = weight_v2;
+							quad_weight[i][2] = weight_v3;
+							active_count++;
+						}
+
+						if(active_count == 0) continue;
+
+						// Sample material texture for the whole quad.
+						if(fragment_stage::TEXTURED) {
+							if(use_lod) lod = calculate_quad_lod(r_v1, r_v2, r_v3, t_uv1, t_uv2, t_uv3, x, y, *material.texture);
+							material.texture->sample4(quad_u, quad_v, quad_texel, lod);
+						}
+
+						for(int i = 0; i < 4; i++) {
+							if(!quad_active[i]) continue;
+
+							ptr = quad_ptr[i];
+
+							// Base diffuse color from material.
+							albedo = fragment.surface(context, quad_texel[i]);
+							if(fragment_stage::ALPHA_TESTED && albedo.a < material.alpha_cutoff) continue;
+
+							if(fragment_stage::DEFERRABLE && material_id != 0) {
+								// Calculate the world normal for this pixel.
+								const float* weight = quad_weight[i];
+								n = w_n1 * weight[0] + w_n2 * weight[1] + w_n3 * weight[2];
+
+								// Leave the lighting to resolve_deferred().
+								int gptr = x + (i & 1) + (y + (i >> 1)) * gbuffer.stride;
+								gbuffer.normal_x[gptr] = n.x;
+								gbuffer.normal_y[gptr] = n.y;
+								gbuffer.normal_z[gptr] = n.z;
+								gbuffer.albedo[gptr] = albedo;
+								gbuffer.material_id[gptr] = material_id;
+							} else {
+								// Write color to render target.
+								frame_buffer[ptr] = fragment.shade(context, quad_weight[i], albedo, tile_lights);
+								if(material_ids != nullptr) material_ids[x + (i & 1) + (y + (i >> 1)) * gbuffer.stride] = 0;
+							}
+
+							// Update the depth buffer with this depth value.
+							if(pass != raster_pass::COLOR_EQUAL) {
+								depth_buffer[ptr].r = quad_depth[i];
+								written_min = fminf(written_min, quad_depth[i]);
+								written_max = fmaxf(written_max, quad_depth[i]);
+								written++;
+							}
+						}
+					}
+				}
+
+				// Nearer depth lowers the tile min right away. The max only
+				// drops once a single triangle covers the whole tile, until
+				// then the old one is still a valid, if loose, bound.
+				if(written > 0) {
+					tile.min = fminf(tile.min, written_min);
+					int tile_pixels = math::min(tile_size, target_width - tx * tile_size) * math::min(tile_size, target_height - ty * tile_size);
+					if(written == tile_pixels) tile.max = written_max;
+				}
+			}
+		}
+	}
+
+	// Fills a triangle one scanline at a time, for the AFFINE & FLAT raster
+	// modes. The edges are walked once per row, then depth, uv & the lit
+	// vertex color step linearly in screen space along each span. There is
+	// no perspective correction, so textures swim & bend like on the PS1.
+	void rasterize_spans(
+		render_target& target,
+		const vec4& r_v1, // <- render_target coords
+		const vec4& r_v2, // <- ^^^
+		const vec4& r_v3, // <- ^^^
+		const vec3& w_v1, // <- world vertices
+		const vec3& w_v2, // <- ^^^
+		const vec3& w_v3, // <- ^^^
+		const vec3& w_n1, // <- world normals
+		const vec3& w_n2, // <- ^^^
+		const vec3& w_n3, // <- ^^^
+		const vec2& t_uv1, // <- texture coords
+		const vec2& t_uv2, // <- ^^^
+		const vec2& t_uv3, // <- ^^^
+		const material& material,
+		const vec3& camera_position
+	) {
+		int target_width = target.get_width();
+		int target_height = target.get_height();
+
+		// Screen space edges from the first vertex, for the attribute gradients.
+		float e1x = r_v2.x - r_v1.x, e1y = r_v2.y - r_v1.y;
+		float e2x = r_v3.x - r_v1.x, e2y = r_v3.y - r_v1.y;
+		float det = e1x * e2y - e2x * e1y;
+		if(det == 0.0F) return;
+		float inv_det = 1.0F / det;
+
+		// Rows in [y_min, y_max), pixel centers on the top edge are in, on the bottom edge out.
+		float top = fminf(r_v1.y, fminf(r_v2.y, r_v3.y));
+		float bottom = fmaxf(r_v1.y, fmaxf(r_v2.y, r_v3.y));
+		float left = fminf(r_v1.x, fminf(r_v2.x, r_v3.x));
+		float right = fmaxf(r_v1.x, fmaxf(r_v2.x, r_v3.x));
+		int y_min = math::max((int)ceilf(top - 0.5F), 0);
+		int y_max = math::min((int)ceilf(bottom - 0.5F), target_height);
+		int x_min = math::max((int)ceilf(left - 0.5F), 0);
+		int x_max = math::min((int)ceilf(right - 0.5F), target_width);
+		if(y_min >= y_max || x_min >= x_max) return;
+
+		// Lit once per vertex for AFFINE, once at the center for FLAT.
+		color c1, c2, c3;
+		const texture* tex = nullptr;
+		if(material.raster == raster_mode::FLAT) {
+			c1 = calculate_blinn_phong((w_v1 + w_v2 + w_v3) / 3, w_n1 + w_n2 + w_n3, material.diffuse, material.specular, ambient_color, material.shininess, camera_position, culled_lights, all_lights);
+			c1.a = material.diffuse.a;
+			c2 = c1;
+			c3 = c1;
+		} else {
+			c1 = calculate_blinn_phong(w_v1, w_n1, material.diffuse, material.specular, ambient_color, material.shininess, camera_position, culled_lights, all_lights);
+			c2 = calculate_blinn_phong(w_v2, w_n2, material.diffuse, material.specular, ambient_color, material.shininess, camera_position, culled_lights, all_lights);
+			c3 = calculate_blinn_phong(w_v3, w_n3, material.diffuse, material.specular, ambient_color, material.shininess, camera_position, culled_lights, all_lights);
+			c1.a = c2.a = c3.a = material.diffuse.a;
+			tex = material.texture.get();
+		}
+
+		// Returns the screen space x & y gradients of an attribute.
+		auto gradient = [&](float a1, float a2, float a3, float& ddx, float& ddy) {
+			ddx = ((a2 - a1) * e2y - (a3 - a1) * e1y) * inv_det;
+			ddy = ((a3 - a1) * e1x - (a2 - a1) * e2x) * inv_det;
+		};
+
+		float dzdx, dzdy, dudx, dudy, dvdx, dvdy;
+		gradient(r_v1.z, r_v2.z, r_v3.z, dzdx, dzdy);
+		gradient(t_uv1.x, t_uv2.x, t_uv3.x, dudx, dudy);
+		gradient(t_uv1.y, t_uv2.y, t_uv3.y, dvdx, dvdy);
+
+		color dcdx, dcdy;
+		gradient(c1.r, c2.r, c3.r, dcdx.r, dcdy.r);
+		gradient(c1.g, c2.g, c3.g, dcdx.g, dcdy.g);
+		gradient(c1.b, c2.b, c3.b, dcdx.b, dcdy.b);
+		gradient(c1.a, c2.a, c3.a, dcdx.a, dcdy.a);
+		simd::f32x4 color_step = simd::load(dcdx);
+
+		target.resolve_clear(x_min, y_min, x_max, y_max);
+
+		color* frame_buffer = target.get_frame_buffer()->get_data();
+		color* depth_buffer = target.get_depth_buffer()->get_data();
+
+		// Pixels still waiting in the G-buffer would be lit over the span.
+		uint16_t* material_ids = gbuffer_materials.size() > 1 && gbuffer_target.get() == &target ? gbuffer.material_id.data() : nullptr;
+
+		// Vertices top to bottom. The long edge spans all rows, the two short
+		// edges each cover one half.
+		const vec4* v[3] = { &r_v1, &r_v2, &r_v3 };
+		if(v[1]->y < v[0]->y) std::swap(v[0], v[1]);
+		if(v[2]->y < v[1]->y) std::swap(v[1], v[2]);
+		if(v[1]->y < v[0]->y) std::swap(v[0], v[1]);
+
+		float long_slope = (v[2]->x - v[0]->x) / (v[2]->y - v[0]->y);
+		float written_min = 1.0F;
+
+		for(int half = 0; half < 2; half++) {
+			const vec4& a = *v[half];
+			const vec4& b = *v[half + 1];
+			int row_begin = math::max((int)ceilf(a.y - 0.5F), y_min);
+			int row_end = math::min((int)ceilf(b.y - 0.5F), y_max);
+			if(row_begin >= row_end) continue;
+
+			float short_slope = (b.x - a.x) / (b.y - a.y);
+			float x_short = a.x + (row_begin + 0.5F - a.y) * short_slope;
+			float x_long = v[0]->x + (row_begin + 0.5F - v[0]->y) * long_slope;
+
+			for(int y = row_begin; y < row_end; y++, x_short += short_slope, x_long += long_slope) {
+				int x_begin = math::max((int)ceilf(fminf(x_short, x_long) - 0.5F), 0);
+				int x_end = math::min((int)ceilf(fmaxf(x_short, x_long) - 0.5F), target_width);
+				if(x_begin >= x_end) continue;
+
+				// Attributes at the first pixel center of the span.
+				float dx = x_begin + 0.5F - r_v1.x;
+				float dy = y + 0.5F - r_v1.y;
+				float z = r_v1.z + dzdx * dx + dzdy * dy;
+				written_min = fminf(written_min, fminf(z, z + dzdx * (x_end - 1 - x_begin)));
+
+				color* frame_row = frame_buffer + y * target_width;
+				color* depth_row = depth_buffer + y * target_width;
+				uint16_t* id_row = material_ids != nullptr ? material_ids + y * gbuffer.stride : nullptr;
+
+				if(material.raster == raster_mode::FLAT) {
+					for(int x = x_begin; x < x_end; x++, z += dzdx) {
+						if(z >= depth_row[x].r) continue;
+						frame_row[x] = c1;
+						depth_row[x].r = z;
+						if(id_row != nullptr) id_row[x] = 0;
+					}
+					continue;
+				}
+
+				simd::f32x4 c = simd::load(color(
+					c1.r + dcdx.r * dx + dcdy.r * dy,
+					c1.g + dcdx.g * dx + dcdy.g * dy,
+					c1.b + dcdx.b * dx + dcdy.b * dy,
+					c1.a + dcdx.a * dx + dcdy.a * dy
+				));
+
+				if(tex == nullptr) {
+					for(int x = x_begin; x < x_end; x++, z += dzdx, c = simd::add(c, color_step)) {
+						if(z >= depth_row[x].r) continue;
+						simd::store(frame_row[x], c);
+						depth_row[x].r = z;
+						if(id_row != nullptr) id_row[x] = 0;
+					}
+					continue;
+				}
+
+				float tu = t_uv1.x + dudx * dx + dudy * dy;
+				float tv = t_uv1.y + dvdx * dx + dvdy * dy;
+				for(int x = x_begin; x < x_end; x++, z += dzdx, tu += dudx, tv += dvdx, c = simd::add(c, color_step)) {
+					if(z >= depth_row[x].r) continue;
+					simd::store(frame_row[x], simd::mul(c, simd::load(tex->sample(tu, tv))));
+					depth_row[x].r = z;
+					if(id_row != nullptr) id_row[x] = 0;
+				}
+			}
+		}
+
+		// Only lowers the tile mins, a looser bound than the spans wrote is
+		// still a valid one.
+		render_target::depth_tile* depth_tiles = target.get_depth_tiles();
+		int depth_tiles_x = target.get_depth_tiles_x();
+		const int tile_size = render_target::DEPTH_TILE_SIZE;
+		for(int ty = y_min / tile_size; ty <= (y_max - 1) / tile_size; ty++)
+			for(int tx = x_min / tile_size; tx <= (x_max - 1) / tile_size; tx++)
+				depth_tiles[tx + ty * depth_tiles_x].min = fminf(depth_tiles[tx + ty * depth_tiles_x].min, written_min);
+	}
+
+	// Sub pixel precision of the rasterizer, 28.4 fixed point.
+	static const int SUBPIXEL_BITS = 4;
+	static const int SUBPIXELS = 1 << SUBPIXEL_BITS;
+
+	// Returns true for a top or left edge of a counter clockwise triangle,
+	// from the edge direction.
+	static bool is_top_left_edge(int64_t dx, int64_t dy) {
+		return dy < 0 || (dy == 0 && dx < 0);
+	}
+
+	// Returns the perspective correct UV at a pixel center of the triangle.
+	static vec2 interpolate_uv(
+		const vec4& r_v1, const vec4& r_v2, const vec4& r_v3,
+		const vec2& t_uv1, const vec2& t_uv2, const vec2& t_uv3,
+		float px, float py
+	) {
+		float denom = (r_v2.y - r_v3.y) * (r_v1.x - r_v3.x) + (r_v3.x - r_v2.x) * (r_v1.y - r_v3.y);
+		float w1 = ((r_v2.y - r_v3.y) * (px - r_v3.x) + (r_v3.x - r_v2.x) * (py - r_v3.y)) / denom;
+		float w2 = ((r_v3.y - r_v1.y) * (px - r_v3.x) + (r_v1.x - r_v3.x) * (py - r_v3.y)) / denom;
+		float w3 = 1.0F - w1 - w2;
+
+		if(r_v1.w != 0.0F && r_v2.w != 0.0F && r_v3.w != 0.0F) {
+			w1 /= r_v1.w;
+			w2 /= r_v2.w;
+			w3 /= r_v3.w;
+			float scale = 1.0F / (w1 + w2 + w3);
+			w1 *= scale;
+			w2 *= scale;
+			w3 *= scale;
+		}
+
+		return t_uv1 * w1 + t_uv2 * w2 + t_uv3 * w3;
+	}
+
+	// Returns the mip level of detail for the 2x2 quad at (qx, qy), from the
+	// UV derivatives across the quad scaled to texels.
+	static float calculate_quad_lod(
+		const vec4& r_v1, const vec4& r_v2, const vec4& r_v3,
+		const vec2& t_uv1, const vec2& t_uv2, const vec2& t_uv3,
+		int qx, int qy,
+		const texture& texture
+	) {
+		vec2 uv00 = interpolate_uv(r_v1, r_v2, r_v3, t_uv1, t_uv2, t_uv3, qx + 0.5F, qy + 0.5F);
+		vec2 uv10 = interpolate_uv(r_v1, r_v2, r_v3, t_uv1, t_uv2, t_uv3, qx + 1.5F, qy + 0.5F);
+		vec2 uv01 = interpolate_uv(r_v1, r_v2, r_v3, t_uv1, t_uv2, t_uv3, qx + 0.5F, qy + 1.5F);
+
+		float dudx = (uv10.x - uv00.x) * texture.get_width();
+		float dvdx = (uv10.y - uv00.y) * texture.get_height();
+		float dudy = (uv01.x - uv00.x) * texture.get_width();
+		float dvdy = (uv01.y - uv00.y) * texture.get_height();
+
+		float rho = fmaxf(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+		if(rho <= 1.0F) return 0.0F;
+		return 0.5F * log2f(rho);
+	}
+
+	static float edge_func(const vec2& a, const vec2& b, const vec2& c) {
+		return (c.x - a.x) * (b.y - a.y) - (c.y - a.y) * (b.x - a.x);
+	}
+
+	static vec4 project_world_vertex(const vec3& v, const mat4& world_to_projection) {
+		vec4 hpv = world_to_projection * vec4(v.x, v.y, v.z, 1);
+		return vec4(hpv.x / hpv.w, hpv.y / hpv.w, hpv.z / hpv.w, hpv.w);
+	}
+
+	static color calculate_blinn_phong(
+		const vec3& position,
+		const vec3& normal,
+		const color& diffuse,
+		const color& specular,
+		const color& ambient,
+		float shininess,
+		const vec3& camera_position,
+		const std::vector<light::ptr>& lights,
+		const std::vector<uint16_t>& light_indices
+	) {
+		int i;
+		color diffuse_sum = color(0, 0, 0);
+		color specular_sum = color(0, 0, 0);
+		float light_w;
+		vec3 light_pos;
+		color light_color;
+		float attenuation;
+		vec3 normal_direction = vec3::normalize(normal);
+		vec3 view_direction = vec3::normalize(camera_position - position);
+		vec3 vert_to_light;
+		float vert_to_light_mag;
+		vec3 light_direction;
+		color diffuse_reflection;
+		color specular_reflection;
+		color ambient_lighting = ambient * diffuse;
+		light* light;
+
+		// Loop through each light source that can reach this pixel.
+		for(i = 0; i < light_indices.size(); ++i) {
+			light = lights[light_indices[i]].get();
+
+			// Calculate the light position and colour based on the light properties
+			// light_w is set to 0 if the light is directional, and 1 otherwise.
+			if(light->type == light_mode::DIRECTIONAL) {
+				light_pos = light->transform->get_global_backward();
+				light_w = 0.0F;
+				light_color = light->tint * light->intensity;
+				attenuation = 1.0F;
+			} else {
+				light_pos = light->transform->get_global_position();
+				light_w = 1.0F;
+
+				// For non direcitonal lights, we'll figure out the light
+				// color per pixel, based on the distance from the light
+				// to the pixel.
+				light_color = color(0, 0, 0);
+
+				// Calculate the distance from the light to the pixel, and 1/distance.
+				vert_to_light = light_pos - position;
+				vert_to_light_mag = vert_to_light.magnitude();
+
+				attenuation = 1.0F / vert_to_light_mag;
+
+				// Calculate the colour based on the distance and light range.
+				if(vert_to_light_mag < light->range)
+					light_color = light->tint * light->intensity;
+			}
+
+			// Calculate light direction.
+			light_direction = light_pos - (position * light_w);
+
+			// Calculate diffuse lighting.
+			diffuse_reflection = light_color * diffuse * fmaxf(0, vec3::dot(normal_direction, view_direction)) * attenuation;
+
+			// Calculate Specular reflection if the normal is pointing in the
+			// lights direction.
+			if(vec3::dot(normal_direction, light_direction) < 0.0) {
+				specular_reflection = color(0, 0, 0);
+			} else {
+				// Calculate the specular colour using Blinn-Phong lighting
+				specular_reflection = light_color * specular * powf(fmaxf(0.0F, vec3::dot(normal_direction, vec3::normalize(light_direction + view_direction))), shininess * 128) * attenuation;
+			}
+
+			diffuse_sum += diffuse_reflection;
+			specular_sum += specular_reflection;
+		}
+
+		// The final color for this pixel is the sum of the ambient, diffuse and specular.
+		return ambient_lighting + diffuse_sum + specular_sum;
+	}
+
+
+};
+#endif /* SYS_SOFTWARE_GL */
+//********************************************//
+//* Software Renderer                        *//
+//********************************************//
+#pragma endregion
 
-		// TODO: Events to implement...
-		// 		window moved event
-		// 		window focus/unfocus event
-		// 		mouse scroll event
 
-		return rge::OK;
-	}
+#pragma region /* rge::gl_state_cache */
+//********************************************//
+//* OpenGL State Cache                       *//
+//********************************************//
+#if defined(SYS_OPENGL_1_0) || defined(SYS_OPENGL_3_3)
+// Shadows the GL state set by a renderer, dropping calls that would not
+// change anything. All state changes must go through it, or be followed
+// by invalidate().
+class gl_state_cache final {
+public:
+	// State change counts, over one frame.
+	struct stats {
+		uint32_t issued;
+		uint32_t skipped;
+	};
 
-	bool use_custom_loop() const override {
-		return true;
+	gl_state_cache() {
+		invalidate();
+		frame_stats.issued = 0;
+		frame_stats.skipped = 0;
+		last_frame_stats = frame_stats;
 	}
 
-	static void update() {
-		get_instance()->loop_func();
+	// Forgets all tracked state, so the next change of each is issued.
+	void invalidate() {
+		for(int i = 0; i < CAP_COUNT; i++) cap_states[i] = UNKNOWN;
+		texture = UNKNOWN_HANDLE;
+		blend_src = blend_dst = GL_NONE;
+		alpha_function = GL_NONE;
+		alpha_ref = 0.0F;
+		depth_write = UNKNOWN;
+		matrix_mode = GL_NONE;
+		modelview_valid = false;
+		projection_valid = false;
 	}
 
-	static void idle() {
-		static bool cocoa_enabled = false;
-		if(!cocoa_enabled) {
-			Class ns_app_class = objc_getClass("NSApplication");
-			SEL shared_app_sel = sel_registerName("sharedApplication");
-			id ns_app = ((id(*)(Class, SEL))objc_msgSend)(ns_app_class, shared_app_sel);
-			SEL main_window_sel = sel_registerName("mainWindow");
-			id window = ((id(*)(id, SEL))objc_msgSend)(ns_app, main_window_sel);
-			SEL set_style_mask_sel = sel_registerName("setStyleMask:");
-			int style_mask = (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3);
-			// [window setStyleMask: NSWindowStyleMaskClosable | ~NSWindowStyleMaskResizable]
-			((void (*)(id, SEL, NSUInteger))objc_msgSend)(window, set_style_mask_sel, style_mask);
-			cocoa_enabled = true;
-		}
+	void set_enabled(GLenum cap, bool enabled) {
+		int i = find_cap(cap);
+		int8_t state = enabled ? 1 : 0;
 
-		if(!engine::get_instance()->get_is_running()) {
-			exit(0);
-			return;
-		}
+		if(!count(i < 0 || cap_states[i] != state)) return;
+		if(i >= 0) cap_states[i] = state;
 
-		glutPostRedisplay();
+		if(enabled) glEnable(cap);
+		else glDisable(cap);
 	}
 
-	static void on_window_reshape(int w, int h) {
-		get_instance()->window_width = w;
-		get_instance()->window_height = h;
+	void bind_texture(GLuint handle) {
+		if(!count(texture != handle)) return;
+		texture = handle;
+		glBindTexture(GL_TEXTURE_2D, handle);
+	}
 
-		window_resized_event e;
-		e.width = w;
-		e.height = h;
-		engine::get_instance()->post_event(e);
+	// Deleting the bound texture makes GL fall back to texture 0.
+	void forget_texture(GLuint handle) {
+		if(texture == handle) texture = 0;
 	}
 
-	static void on_window_try_close() {
-		window_close_requested_event e;
-		engine::get_instance()->post_event(e);
+	void blend_func(GLenum src, GLenum dst) {
+		if(!count(blend_src != src || blend_dst != dst)) return;
+		blend_src = src;
+		blend_dst = dst;
+		glBlendFunc(src, dst);
 	}
 
-	void enter_loop(std::function<void()> loop) override {
-		this->loop_func = loop;
-		
-		glutMainLoop();
+	void alpha_func(GLenum func, GLfloat ref) {
+		if(!count(alpha_function != func || alpha_ref != ref)) return;
+		alpha_function = func;
+		alpha_ref = ref;
+		glAlphaFunc(func, ref);
 	}
 
-	void set_window_title(const std::string& title) override {
-		glutSetWindowTitle(title.c_str());
+	void depth_mask(bool enabled) {
+		int8_t state = enabled ? 1 : 0;
+		if(!count(depth_write != state)) return;
+		depth_write = state;
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
 	}
 
-	void poll_gamepads() override {
-		// TODO
+	// Loads a column-major matrix onto the GL_MODELVIEW or GL_PROJECTION stack.
+	void load_matrix(GLenum mode, const GLfloat* m) {
+		GLfloat* cached = mode == GL_PROJECTION ? projection : modelview;
+		bool& valid = mode == GL_PROJECTION ? projection_valid : modelview_valid;
+
+		if(!count(!valid || memcmp(cached, m, sizeof(GLfloat) * 16) != 0)) return;
+		memcpy(cached, m, sizeof(GLfloat) * 16);
+		valid = true;
+
+		set_matrix_mode(mode);
+		glLoadMatrixf(m);
 	}
 
-	void poll_events() override {
-		// TODO
+	// Multiplies onto the current matrix, which is not tracked past this.
+	void mult_matrix(GLenum mode, const GLfloat* m) {
+		count(true);
+		if(mode == GL_PROJECTION) projection_valid = false;
+		else modelview_valid = false;
+
+		set_matrix_mode(mode);
+		glMultMatrixf(m);
 	}
 
-	void refresh_window() override {
-		// TODO
+	// Starts counting a new frame.
+	void end_frame() {
+		last_frame_stats = frame_stats;
+		frame_stats.issued = 0;
+		frame_stats.skipped = 0;
 	}
 
-	bool is_focused() const override {
-		// TODO
-		return true;
+	// Returns the counts of the last finished frame.
+	const stats& get_frame_stats() const {
+		return last_frame_stats;
 	}
 
-	void clean_up() override {
+private:
+	static const int CAP_COUNT = 4;
+	static const int8_t UNKNOWN = -1;
+	static const GLuint UNKNOWN_HANDLE = 0xFFFFFFFF;
+
+	static int find_cap(GLenum cap) {
+		switch(cap) {
+			case GL_TEXTURE_2D: return 0;
+			case GL_BLEND: return 1;
+			case GL_DEPTH_TEST: return 2;
+			case GL_ALPHA_TEST: return 3;
+			default: return -1;
+		}
+	}
+
+	// Returns changed, after counting it.
+	bool count(bool changed) {
+		if(changed) frame_stats.issued++;
+		else frame_stats.skipped++;
+		return changed;
+	}
 
+	void set_matrix_mode(GLenum mode) {
+		if(!count(matrix_mode != mode)) return;
+		matrix_mode = mode;
+		glMatrixMode(mode);
 	}
+
+	int8_t cap_states[CAP_COUNT];
+	GLuint texture;
+	GLenum blend_src;
+	GLenum blend_dst;
+	GLenum alpha_function;
+	GLfloat alpha_ref;
+	int8_t depth_write;
+	GLenum matrix_mode;
+	GLfloat modelview[16];
+	GLfloat projection[16];
+	bool modelview_valid;
+	bool projection_valid;
+
+	stats frame_stats;
+	stats last_frame_stats;
 };
-#endif /* SYS_MACOSX */
+#endif /* SYS_OPENGL_1_0 || SYS_OPENGL_3_3 */
 //********************************************//
-//* MacOS X platform class.                  *//
+//* OpenGL State Cache                       *//
 //********************************************//
 #pragma endregion
 
 
-#pragma region /* rge::software_gl */
+#pragma region /* rge::opengl_1_0 */
 //********************************************//
-//* Software Renderer                        *//
+//* OpenGL 1.0 Renderer                      *//
 //********************************************//
-#ifdef SYS_SOFTWARE_GL
-class software_gl : public renderer {
+#ifdef SYS_OPENGL_1_0
+class opengl_1_0 : public rge::renderer {
 private:
-	std::vector<light*> lights; // TODO: Move to rge::renderer.
-	render_target::ptr output_window;
-	platform* platform_instance;
+	#ifdef SYS_WINDOWS
+	gl_device_context_t device = 0;
+	gl_render_context_t render = 0;
+	#endif
 
-	render_target::ptr get_real_target() {
-		return output_render != nullptr ? output_render : output_window;
+	int window_width;
+	int window_height;
+
+	gl_state_cache state;
+
+	// Interleaved layout of the sprite vertex array.
+	struct sprite_vertex {
+		GLfloat x, y, z;
+		GLfloat u, v;
+		GLfloat r, g, b, a;
+	};
+
+	// A queued sprite, already in world space.
+	struct sprite_batch_item {
+		rge::texture::ptr texture;
+		int layer;
+		sprite_vertex vertices[4]; // In bl, br, tr, tl order.
+	};
+
+	std::vector<sprite_batch_item> sprite_batch;
+	std::vector<sprite_vertex> sprite_vertices;
+	camera::ptr sprite_batch_camera;
+
+	static bool sprite_layer_before(const sprite_batch_item& a, const sprite_batch_item& b) {
+		return a.layer < b.layer;
 	}
 
-public:
-	software_gl() : renderer() {}
+	static bool sprite_texture_before(const sprite_batch_item& a, const sprite_batch_item& b) {
+		if(a.layer != b.layer) return a.layer < b.layer;
+		return a.texture < b.texture;
+	}
+
+	// Draws the queued sprites from one vertex array, with a single
+	// glDrawArrays per run of sprites sharing a texture.
+	void flush_sprites() {
+		if(sprite_batch.empty()) return;
+
+		GLfloat gl_m[16];
+
+		// Stable, so sprites keep submission order within a layer (and texture).
+		std::stable_sort(sprite_batch.begin(), sprite_batch.end(), sprite_sort_by_texture ? sprite_texture_before : sprite_layer_before);
+
+		sprite_vertices.resize(sprite_batch.size() * 4);
+		for(size_t i = 0; i < sprite_batch.size(); i++)
+			memcpy(&sprite_vertices[i * 4], sprite_batch[i].vertices, sizeof(sprite_batch[i].vertices));
+
+		convert_matrix(gl_m, sprite_batch_camera->get_view_matrix());
+		state.load_matrix(GL_MODELVIEW, gl_m);
+
+		convert_matrix(gl_m, sprite_batch_camera->get_projection_matrix());
+		state.load_matrix(GL_PROJECTION, gl_m);
+
+		state.set_enabled(GL_DEPTH_TEST, true);
+		state.depth_mask(true);
+		state.set_enabled(GL_ALPHA_TEST, false);
+		state.set_enabled(GL_BLEND, true);
+		state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+		glVertexPointer(3, GL_FLOAT, sizeof(sprite_vertex), &sprite_vertices[0].x);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(sprite_vertex), &sprite_vertices[0].u);
+		glColorPointer(4, GL_FLOAT, sizeof(sprite_vertex), &sprite_vertices[0].r);
+
+		size_t first = 0;
+		while(first < sprite_batch.size()) {
+			const texture::ptr& texture = sprite_batch[first].texture;
+
+			size_t last = first + 1;
+			while(last < sprite_batch.size() && sprite_batch[last].texture == texture) last++;
+
+			if(texture->is_on_gpu()) {
+				state.set_enabled(GL_TEXTURE_2D, true);
+				state.bind_texture(texture->handle);
+			} else {
+				state.set_enabled(GL_TEXTURE_2D, false);
+			}
+
+			glDrawArrays(GL_QUADS, (GLint)(first * 4), (GLsizei)((last - first) * 4));
+			first = last;
+		}
+
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		glDisableClientState(GL_COLOR_ARRAY);
+
+		sprite_batch.clear();
+		sprite_batch_camera = nullptr;
+	}
 
 public:
+	opengl_1_0() {
+
+	}
+
 	rge::result init(platform* platform) override {
-		platform_instance = platform;
-		output_window = render_target::create(this, 1, 1);
+		#ifdef SYS_WINDOWS
+		windows* winapi = (windows*)platform;
+		device = GetDC(winapi->handle);
+		PIXELFORMATDESCRIPTOR pfd = {
+			sizeof(PIXELFORMATDESCRIPTOR), 1,
+			PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
+			PFD_TYPE_RGBA, 32, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+			PFD_MAIN_PLANE, 0, 0, 0, 0
+		};
+
+		int pf = 0;
+		if(!(pf = ChoosePixelFormat(device, &pfd)))
+			return rge::FAIL;
+		SetPixelFormat(device, pf, &pfd);
+
+		if(!(render = wglCreateContext(device)))
+			return rge::FAIL;
+		wglMakeCurrent(device, render);
+
+		// Remove Frame cap
+		/*
+		wglSwapInterval = (wglSwapInterval_t*)wglGetProcAddress("wglSwapIntervalEXT");
+		if(wglSwapInterval && !bVSYNC) wglSwapInterval(0);
+		bSync = false;
+		*/
+		#endif
+
+		#ifdef SYS_LINUX
+		
+		#endif
+		
+		#ifdef SYS_MACOSX
+		
+		#endif
+
+		// Fresh context, nothing known about its state yet.
+		state.invalidate();
+
+		//glEnable(GL_LIGHTING);
+		glEnable(GL_LIGHT0);
+		glEnable(GL_COLOR_MATERIAL);
+		state.set_enabled(GL_DEPTH_TEST, true);
+		glEnable(GL_NORMALIZE);
+
+		glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+
 		return rge::OK;
 	}
 
 	texture::ptr create_texture(int width, int height) override {
-		texture::ptr texture = std::make_shared<texture>(width, height);
+		texture::ptr texture = texture::create(width, height);
 
-		texture->allocate_gpu();
+		glGenTextures(1, &texture->handle);
 
 		return texture;
 	}
 
+	void alloc_texture(texture& texture) override {
+		if(!texture.is_on_gpu())
+			glGenTextures(1, &texture.handle);
+	}
+
 	void upload_texture(texture& texture) override {
-		// NOTE: N/A to software renderer.
+		alloc_texture(texture);
+
+		// GL takes row-major texels.
+		texture.set_layout(texture_layout::LINEAR);
+
+		if(!texture.is_on_cpu()) return;
+		state.bind_texture(texture.handle);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		// GL_CLAMP blends in the border color, so edge clamping is used
+		// where the headers have it (not the 1.1 gl.h shipped with windows).
+#ifdef GL_CLAMP_TO_EDGE
+		GLint wrap = texture.wrap == texture_wrap::CLAMP ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+#else
+		GLint wrap = texture.wrap == texture_wrap::CLAMP ? GL_CLAMP : GL_REPEAT;
+#endif
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+
+		if(texture.filter == texture_filter::NEAREST) {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		} else if(texture.filter == texture_filter::BILINEAR) {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		} else if(texture.filter == texture_filter::TRILINEAR) {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.get_mip_count() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+
+		// Upload every level of the mip chain (just level 0 without mips).
+		for(int level = 0; level < texture.get_mip_count(); level++)
+			glTexImage2D(GL_TEXTURE_2D, level, 4, texture.get_mip_width(level), texture.get_mip_height(level), 0, GL_RGBA, GL_FLOAT, texture.get_mip_data(level));
 	}
 
 	void free_texture(texture& texture) override {
-		// TODO: Deallocate cpu
-		delete texture;
+		if(texture.is_on_gpu()) {
+			state.forget_texture(texture.handle);
+			glDeleteTextures(1, &texture.handle);
+		}
 	}
 
-	bool on_window_resized(const window_resized_event& e) override {
-		output_window->resize(e.width, e.height);
-		return false; // Do not consume event. Let it propagate through higher layers.
+	void upload_mesh(mesh& mesh) override {
+		if(!mesh.is_on_gpu()) mesh.handle = glGenLists(1);
+		if(!mesh.is_on_gpu()) return;
+
+		glNewList(mesh.handle, GL_COMPILE);
+		emit_triangles(mesh.vertices, mesh.triangles, mesh.normals, mesh.uvs);
+		glEndList();
 	}
 
-	void clear(color background) override {
-		color* frame_buffer = get_real_target()->get_frame_buffer()->get_data();
-		color* depth_buffer = get_real_target()->get_depth_buffer()->get_data();
-		for(int i = 0; i < get_real_target()->get_width() * get_real_target()->get_height(); i++) {
-			frame_buffer[i] = background;
-			depth_buffer[i] = color(1, 0, 0, 0);
+	void free_mesh(mesh& mesh) override {
+		if(mesh.is_on_gpu()) {
+			glDeleteLists(mesh.handle, 1);
+			mesh.handle = 0;
 		}
 	}
 
-	void display() override {
-		#ifdef SYS_WINDOWS
-		windows* winapi = (windows*)platform_instance;
-		uint8_t* buffer = winapi->get_frame_buffer();
-		output_window->get_frame_buffer()->dump_to_raw_buffer(buffer);
-		#endif
+	int get_width() const override {
+		return window_width;
 	}
 
-	rge::result draw(
-		const mat4& local_to_world,
-		const std::vector<vec3>& vertices,
-		const std::vector<int>& triangles,
-		const std::vector<vec3>& normals,
-		const std::vector<vec2>& uvs,
-		const material& material
-	) override {
-		if(input_camera == nullptr || output_render == nullptr) return rge::FAIL;
+	int get_height() const override {
+		return window_height;
+	}
 
-		int i;
-		vec3 world_v1;
-		vec3 world_v2;
-		vec3 world_v3;
-		vec3 world_n1;
-		vec3 world_n2;
-		vec3 world_n3;
-		vec4 proj_v1;
-		vec4 proj_v2;
-		vec4 proj_v3;
-		vec3 proj_tri_normal;
-		vec3 proj_tri_center;
-		vec2 normalized_v1;
-		vec2 normalized_v2;
-		vec2 normalized_v3;
-		vec4 texturespace_v1;
-		vec4 texturespace_v2;
-		vec4 texturespace_v3;
-		vec3 camera_position = input_camera->transform != nullptr ? input_camera->transform->get_global_position() : vec3();
-		mat4 world_to_projection = input_camera->get_projection_matrix() * input_camera->get_view_matrix();
+	// Returns the GL state changes issued & skipped over the last frame.
+	const gl_state_cache::stats& get_state_stats() const {
+		return state.get_frame_stats();
+	}
 
-		float w = (float)get_real_target()->get_width();
-		float h = (float)get_real_target()->get_height();
+	void clear(color background) override {
+		flush_sprites();
 
-		// Loop through each of the triplets of triangle indices.
-		for(i = 0; i < triangles.size(); i += 3) {
-			// Transform model vertices to world vertices.
-			world_v1 = local_to_world.multiply_point_3x4(vertices[triangles[i]]);
-			world_v2 = local_to_world.multiply_point_3x4(vertices[triangles[i + 1]]);
-			world_v3 = local_to_world.multiply_point_3x4(vertices[triangles[i + 2]]);
+		// glClear honors the depth mask.
+		state.depth_mask(true);
+
+		glClearColor(
+			float(background.r),
+			float(background.g),
+			float(background.b),
+			float(background.a)
+		);
+
+		glClear(GL_COLOR_BUFFER_BIT);
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+
+	static void convert_matrix(GLfloat* gl, const mat4& m) {
+		for(int i = 0; i < 16; ++i) gl[i] = m.m[i % 4][i / 4];
+	}
 
-			// Transform model normals to world normals.
-			world_n1 = local_to_world.multiply_vector(normals[triangles[i]]);
-			world_n2 = local_to_world.multiply_vector(normals[triangles[i + 1]]);
-			world_n2 = local_to_world.multiply_vector(normals[triangles[i + 2]]);
+	// Loads the camera & model matrices and the material state for a mesh draw.
+	void bind_mesh_state(const mat4& local_to_world, const material& material) {
+		GLfloat gl_m[16];
 
-			// Get the projected vertices that make up the triangle based
-			// on these indices.
-			proj_v1 = project_world_vertex(world_v1, world_to_projection);
-			proj_v2 = project_world_vertex(world_v2, world_to_projection);
-			proj_v3 = project_world_vertex(world_v3, world_to_projection);
+		flush_sprites();
 
-			// Cheap hack: convert camera space z from [-1, 1] to [0, 1]
-			proj_v1.z /= 2.0F;
-			proj_v1.z += 0.5F;
-			proj_v2.z /= 2.0F;
-			proj_v2.z += 0.5F;
-			proj_v3.z /= 2.0F;
-			proj_v3.z += 0.5F;
+		convert_matrix(gl_m, input_camera->get_projection_matrix());
+		state.load_matrix(GL_PROJECTION, gl_m);
 
-			// NOTE: Debugging
-			// printf("p1x: %f, p1y: %f, p1z: %f\n", proj_v1.x, proj_v1.y, proj_v1.z);
-			// printf("p2x: %f, p2y: %f, p2z: %f\n", proj_v2.x, proj_v2.y, proj_v2.z);
-			// printf("p3x: %f, p3y: %f, p3z: %f\n", proj_v3.x, proj_v3.y, proj_v3.z);
+		convert_matrix(gl_m, input_camera->get_view_matrix());
+		state.load_matrix(GL_MODELVIEW, gl_m);
 
-			if(/* Check if all three projected vertices are within homogeneous clip bounds. */
-			   proj_v1.x >= -1 && proj_v1.x <= 1 && proj_v1.y >= -1 && proj_v1.y <= 1 &&
-			   proj_v2.x >= -1 && proj_v2.x <= 1 && proj_v2.y >= -1 && proj_v2.y <= 1 &&
-			   proj_v3.x >= -1 && proj_v3.x <= 1 && proj_v3.y >= -1 && proj_v3.y <= 1
-			   ) {
-				// NOTE: Debugging
-				// printf("inside bounds\n");
+		convert_matrix(gl_m, local_to_world);
+		state.mult_matrix(GL_MODELVIEW, gl_m);
 
-				// Calculate the normal of the projected triangle from the cross
-				// product of two of its edges.
-				proj_tri_normal = vec3::cross(proj_v2 - proj_v1, proj_v3 - proj_v1);
+		//float lpos[4] = { 0, 1, 0, 1.0 };  //light's position
+		//glLightfv(GL_LIGHT0, GL_POSITION, lpos);   //Set light position
 
-				// Calculate the centre of the projected triangle.
-				proj_tri_center = (proj_v1 + proj_v2 + proj_v3) / 3;
+		if(material.texture != nullptr && material.texture->is_on_gpu()) {
+			state.set_enabled(GL_TEXTURE_2D, true);
+			state.bind_texture(material.texture->handle);
+		} else {
+			state.set_enabled(GL_TEXTURE_2D, false);
+		}
 
-				// NOTE: Debugging
-				// printf("cx: %f\n", camera_position.x);
-				// printf("cy: %f\n", camera_position.y);
-				// printf("cz: %f\n", camera_position.z);
-				// printf("nx: %f\n", proj_tri_normal.x);
-				// printf("ny: %f\n", proj_tri_normal.y);
-				// printf("nz: %f\n", proj_tri_normal.z);
-				// printf("ax: %f\n", proj_tri_center.x);
-				// printf("ay: %f\n", proj_tri_center.y);
-				// printf("az: %f\n", proj_tri_center.z);
+		state.set_enabled(GL_DEPTH_TEST, true);
+		state.depth_mask(true);
+		state.set_enabled(GL_ALPHA_TEST, false);
 
-				// Check the dot project of the projected triangle normal and
-				// the camera to triangle centre vector - if the dot product is
-				// <=0, the normal and vector point at each other, and the triangle
-				// must be facing the camera, so we should render it. If the dot
-				// product is >0, the are facing the same direction, therefore
-				// the triangle is facing away from the camera - don't render it.
-				float d = vec3::dot(proj_tri_normal, proj_tri_center - camera_position);
+		if(material.diffuse.a < 1.0F) {
+			state.set_enabled(GL_BLEND, true);
+			state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		} else {
+			state.set_enabled(GL_BLEND, false);
+		}
 
-				// NOTE: Debugging
-				// printf("d: %f\n", d);
+		glColor4f(material.diffuse.r, material.diffuse.g, material.diffuse.b, material.diffuse.a);
+	}
 
-				if(d >= 0) {
-					// Normalize our projected vertices so that they are in the range
-					// Between 0 and 1 (instead of -1 and 1).
-					normalized_v1 = vec2((proj_v1.x + 1) / 2.0F, (proj_v1.y + 1) / 2.0F);
-					normalized_v2 = vec2((proj_v2.x + 1) / 2.0F, (proj_v2.y + 1) / 2.0F);
-					normalized_v3 = vec2((proj_v3.x + 1) / 2.0F, (proj_v3.y + 1) / 2.0F);
+	// Sends model space triangles. Attributes latch onto the next glVertex,
+	// so they go first.
+	static void emit_triangles(
+		const std::vector<vec3>& vertices,
+		const std::vector<int>& triangles,
+		const std::vector<vec3>& normals,
+		const std::vector<vec2>& uvs
+	) {
+		glBegin(GL_TRIANGLES); {
+			for(size_t i = 0; i < triangles.size(); i++) {
+				size_t v = (size_t)triangles[i];
 
-					// Multiply our normalized vertex positions by the render target size
-					// to get their position in texture space (or if we were rendering
-					// to the screen - screen space).
-					texturespace_v1 = vec4(normalized_v1.x * w, normalized_v1.y * h, proj_v1.z, proj_v1.w);
-					texturespace_v2 = vec4(normalized_v2.x * w, normalized_v2.y * h, proj_v2.z, proj_v2.w);
-					texturespace_v3 = vec4(normalized_v3.x * w, normalized_v3.y * h, proj_v3.z, proj_v3.w);
+				if(v < uvs.size()) {
+					glTexCoord2f(uvs[v].x, 1.0F - uvs[v].y);
+				}
 
-					// Draw the triangle interpolated between the three vertices,
-					// using the colours calculated for these vertices based
-					// on the triangle indices.
-					rasterize_triangle(
-						texturespace_v1,
-						texturespace_v2,
-						texturespace_v3,
-						world_v1,
-						world_v2,
-						world_v3,
-						world_n1,
-						world_n2,
-						world_n3,
-						uvs[triangles[i]],
-						uvs[triangles[i + 1]],
-						uvs[triangles[i + 2]],
-						material
-					);
+				if(v < normals.size()) {
+					glNormal3f(normals[v].x, normals[v].y, normals[v].z);
 				}
-			}
-		}
 
-		return rge::OK;
+				if(v < vertices.size()) {
+					glVertex3f(vertices[v].x, vertices[v].y, vertices[v].z);
+				}
+			}
+		} glEnd();
 	}
 
-	void draw(const texture& texture, const rect& dest, const rect& src) override {
-		draw(
-			texture,
-			int(dest.x * get_real_target()->get_width()),
-			int(dest.y * get_real_target()->get_height()),
-			int(dest.w * get_real_target()->get_width()),
-			int(dest.h * get_real_target()->get_height()),
-			int(src.x * get_real_target()->get_width()),
-			int(src.y * get_real_target()->get_height()),
-			int(src.w * get_real_target()->get_width()),
-			int(src.h * get_real_target()->get_height())
-		);
+	void display() override {
+		flush_sprites();
+		state.end_frame();
+
+		#ifdef SYS_WINDOWS
+		glFlush();
+		SwapBuffers(device);
+		// if(bSync) DwmFlush();
+		#endif
+
+		#ifdef SYS_LINUX
+		// TODO
+		// X11::glXSwapBuffers(olc_Display, *olc_Window);
+		#endif
+
+		#ifdef SYS_MACOSX
+		glFlush();
+		glutSwapBuffers();
+		#endif
 	}
 
-	void draw(
-		const texture& texture,
-		int dest_x,
-		int dest_y,
-		int dest_width,
-		int dest_height,
-		int src_x,
-		int src_y,
-		int src_width,
-		int src_height
+	// Draw 3D geometry, using model space data.
+	rge::result draw(
+		const mat4& local_to_world,
+		const std::vector<vec3>& vertices,
+		const std::vector<int>& triangles,
+		const std::vector<vec3>& normals,
+		const std::vector<vec2>& uvs,
+		const material& material
 	) override {
-		if(!texture.get_on_cpu()) return;
+		if(input_camera == nullptr) return rge::FAIL;
 
-		int x, y, ptr;
-		float u, v;
-		float ut, vt;
+		bind_mesh_state(local_to_world, material);
+		emit_triangles(vertices, triangles, normals, uvs);
 
-		int wt = get_real_target()->get_width();
-		int ht = get_real_target()->get_height();
+		return rge::OK;
+	}
 
-		int x_min = dest_x;
-		int y_min = dest_y;
-		int x_max = dest_x + dest_width;
-		int y_max = dest_y + dest_height;
+	// Draw 3D geometry from its display list, if uploaded.
+	rge::result draw(const mat4& local_to_world, const mesh& mesh, const material& material) override {
+		if(input_camera == nullptr) return rge::FAIL;
+		if(!mesh.is_on_gpu()) return draw(local_to_world, mesh.vertices, mesh.triangles, mesh.normals, mesh.uvs, material);
 
-		color* input_buffer = texture.get_data();
-		color* frame_buffer = get_real_target()->get_frame_buffer()->get_data();
+		bind_mesh_state(local_to_world, material);
+		glCallList(mesh.handle);
 
-		if(x_min < 0) x_min = 0;
-		if(y_min < 0) y_min = 0;
-		if(x_max > wt) x_max = wt;
-		if(y_max > ht) y_max = ht;
-
-		for(y = y_min; y <= y_max; y++) {
-			for(x = x_min; x <= x_max; x++) {
-				if(x >= x_min && x < x_max && y >= y_min && y < y_max) {
-					ptr = x + (y * wt);
-					u = math::inverse_lerp(x_min, x_max, x);
-					v = math::inverse_lerp(y_min, y_max, y);
-					ut = math::lerp(src_x, src_x + src_width, u) / wt;
-					vt = math::lerp(src_y, src_y + src_height, u) / ht;
-					
-					frame_buffer[ptr] = texture.sample(ut, vt);
-				}
-			}
-		}
+		return rge::OK;
 	}
 
+	// Queues a 2D sprite, drawn with the rest of the batch on the next flush.
 	void draw(const sprite& sprite) override {
-		// TODO
-	}
+		if(input_camera == nullptr) return;
+		if(sprite.texture == nullptr) return;
 
-private:
-	void rasterize_triangle(
-		const vec4& r_v1, // <- render_target coords
-		const vec4& r_v2, // <- ^^^
-		const vec4& r_v3, // <- ^^^
-		const vec3& w_v1, // <- world vertices
-		const vec3& w_v2, // <- ^^^
-		const vec3& w_v3, // <- ^^^
-		const vec3& w_n1, // <- world normals
-		const vec3& w_n2, // <- ^^^
-		const vec3& w_n3, // <- ^^^
-		const vec2& t_uv1, // <- texture coords
-		const vec2& t_uv2, // <- ^^^
-		const vec2& t_uv3, // <- ^^^
-		const material& material
-	) {
-		int x, y;
-		int ptr;
-		float denom;
-		float weight_v1, weight_v2, weight_v3;
-		float depth;
-		vec3 v;
-		vec3 n;
-		vec2 uv;
-		color diffuse;
-		color source;
-		color destination;
-		vec3 camera_position = input_camera->transform != nullptr ? input_camera->transform->get_global_position() : vec3();
-		color* frame_buffer = get_real_target()->get_frame_buffer()->get_data();
-		color* depth_buffer = get_real_target()->get_depth_buffer()->get_data();
+		// Sprites queued through another camera go out first.
+		if(sprite_batch_camera != input_camera) {
+			flush_sprites();
+			sprite_batch_camera = input_camera;
+		}
 
-		// Calculate the bounding rectangle of the triangle based on the
-		// three vertices.
-		int x_min = (int)fminf(r_v1.x, fminf(r_v2.x, r_v3.x));
-		int x_max = (int)fmaxf(r_v1.x, fmaxf(r_v2.x, r_v3.x));
-		int y_min = (int)fminf(r_v1.y, fminf(r_v2.y, r_v3.y));
-		int y_max = (int)fmaxf(r_v1.y, fmaxf(r_v2.y, r_v3.y));
+		mat4 sprite_matrix = sprite.transform->get_global_matrix();
+		mat4 camera_matrix = input_camera->transform->get_global_matrix();
 
-		// Cull the bounding rect to the size of the texture we're rendering to.
-		if(x_min < 0) x_min = 0;
-		if(x_max > get_real_target()->get_width()) x_max = get_real_target()->get_width();
-		if(y_min < 0) y_min = 0;
-		if(y_max > get_real_target()->get_height()) y_max = get_real_target()->get_height();
-
-		// NOTE: Debugging
-		// printf("xmin:%d\n", x_min);
-		// printf("xmax:%d\n", x_max);
-		// printf("ymin:%d\n", y_min);
-		// printf("ymax:%d\n", y_max);
-
-		// TODO: Delete
-		// vec2 v0(r_v1.x, r_v1.y);
-		// vec2 v1(r_v2.x, r_v2.y);
-		// vec2 v2(r_v3.x, r_v3.y);
-		// vec2 e0 = v1 - v0;
-		// vec2 e1 = v2 - v1;
-		// vec2 e2 = v0 - v2;
-
-		// Loop through every pixel in the bounding rect.
-		for(y = y_min; y <= y_max; y++) {
-			for(x = x_min; x <= x_max; x++) {
-				vec2 p(x + 0.5F, y + 0.5F);
-
-				// TODO: Delete
-				// vec2 v0_to_p = p - v0;
-				// vec2 v1_to_p = p - v1;
-				// vec2 v2_to_p = p - v2;
-				// float v0v1p = vec2::cross(e0, v0_to_p);
-				// float v1v2p = vec2::cross(e1, v1_to_p);
-				// float v2v0p = vec2::cross(e2, v2_to_p);
-
-				// Calculate the weights w1, w2 and w3 for the barycentric
-				// coordinates based on the positions of the three vertices.
-				denom = (r_v2.y - r_v3.y) * (r_v1.x - r_v3.x) + (r_v3.x - r_v2.x) * (r_v1.y - r_v3.y);
-				weight_v1 = ((r_v2.y - r_v3.y) * (p.x - r_v3.x) + (r_v3.x - r_v2.x) * (p.y - r_v3.y)) / denom;
-				weight_v2 = ((r_v3.y - r_v1.y) * (p.x - r_v3.x) + (r_v1.x - r_v3.x) * (p.y - r_v3.y)) / denom;
-				weight_v3 = 1.0F - weight_v1 - weight_v2;
-
-				// TODO: Delete
-				// float e1 = (ps.x-r_v1.x)*(r_v2.y-r_v1.y)-(ps.y-r_v1.y)*(r_v2.x-r_v1.x);
-				// float e2 = (ps.x-r_v2.x)*(r_v3.y-r_v2.y)-(ps.y-r_v2.y)*(r_v3.x-r_v2.x);
-				// float e3 = (ps.x-r_v3.x)*(r_v1.y-r_v3.y)-(ps.y-r_v3.y)*(r_v1.x-r_v3.x);
-
-				// TODO: Delete
-				// float w0 = edge_func(v1, v2, p);
-				// float w1 = edge_func(v2, v0, p);
-				// float w2 = edge_func(v0, v1, p);
-
-				// If w1, w2 and w3 are >= 0, we are inside the triangle (or
-				// on an edge, but either way, render the pixel).
-				if(weight_v1 >= 0.0F && weight_v2 >= 0.0F && weight_v3 >= 0.0F) {
-					// Calculate the position in our buffer based on our x and y values.
-					ptr = x + (y * get_real_target()->get_width());
-
-					// NOTE: Debugging
-					// printf("ptr: %d, x: %d, y: %d\n", ptr, x, y);
-
-					// Calculate the depth value of this pixel.
-					depth = r_v1.z * weight_v1 + r_v2.z * weight_v2 + r_v3.z * weight_v3;
-
-					// If the depth value is less than what is currently in the
-					// depth buffer for this pixel.
-					if(depth < depth_buffer[ptr].r) {
-						// Calculate the world position for this pixel.
-						v = w_v1 * weight_v1 + w_v2 * weight_v2 + w_v3 * weight_v3;
-
-						// Calculate the world normal for this pixel.
-						n = w_n1 * weight_v1 + w_n2 * weight_v2 + w_n3 * weight_v3;
-
-						// Calculate the UV coordinate for this pixel.
-						uv = t_uv1 * weight_v1 + t_uv2 * weight_v2 + t_uv3 * weight_v3;
-
-						// Base diffuse color from material.
-						diffuse = material.diffuse;
-
-						// Sample material texture.
-						if(material.texture != nullptr)
-							diffuse *= material.texture->sample(uv.x, uv.y);
-
-						// Calculate the pixel colour based on the weighted vertex colours.
-						source = calculate_blinn_phong(
-							v,
-							n,
-							diffuse,
-							material.specular,
-							ambient_color,
-							material.shininess,
-							camera_position,
-							lights
-						);
+		float w = float(sprite.texture->get_width()) / sprite.pixels_per_unit;
+		float h = float(sprite.texture->get_height()) / sprite.pixels_per_unit;
 
-						// Match alpha to diffuse.
-						source.a = diffuse.a;
+		vec3 p = vec2(0, 0);
+		vec3 r = vec2(w, 0);
+		vec3 u = vec2(0, h);
 
-						// Write color to render target.
-						frame_buffer[ptr] = diffuse;
+		if(sprite.centered) {
+			p.x -= w / 2.0F;
+			p.y -= h / 2.0F;
+		}
 
-						// Update the depth buffer with this depth value.
-						depth_buffer[ptr].r = depth;
-					}
-				}
-			}
+		// Corners in bl, br, tr, tl order.
+		vec3 corners[4];
+		if(sprite.billboard) {
+			corners[0] = sprite_matrix.multiply_point_3x4(p);
+			corners[1] = corners[0] + camera_matrix.multiply_vector(r);
+			corners[2] = corners[0] + camera_matrix.multiply_vector(u + r);
+			corners[3] = corners[0] + camera_matrix.multiply_vector(u);
+		} else {
+			corners[0] = sprite_matrix.multiply_point_3x4(p);
+			corners[1] = sprite_matrix.multiply_point_3x4(p + r);
+			corners[2] = sprite_matrix.multiply_point_3x4(p + r + u);
+			corners[3] = sprite_matrix.multiply_point_3x4(p + u);
 		}
-	}
 
-	static float edge_func(const vec2& a, const vec2& b, const vec2& c) {
-		return (c.x - a.x) * (b.y - a.y) - (c.y - a.y) * (b.x - a.x);
-	}
+		static const GLfloat uvs[4][2] = { { 0.0F, 1.0F }, { 1.0F, 1.0F }, { 1.0F, 0.0F }, { 0.0F, 0.0F } };
 
-	static vec4 project_world_vertex(const vec3& v, const mat4& world_to_projection) {
-		vec4 hpv = world_to_projection * vec4(v.x, v.y, v.z, 1);
-		return vec4(hpv.x / hpv.w, hpv.y / hpv.w, hpv.z / hpv.w, hpv.w);
+		color diffuse = color();
+		if(sprite.material) diffuse = sprite.material->diffuse;
+
+		sprite_batch_item item;
+		item.texture = sprite.texture;
+		item.layer = sprite.layer;
+
+		for(int i = 0; i < 4; i++) {
+			sprite_vertex& vertex = item.vertices[i];
+			vertex.x = corners[i].x;
+			vertex.y = corners[i].y;
+			vertex.z = corners[i].z;
+			vertex.u = uvs[i][0];
+			vertex.v = uvs[i][1];
+			vertex.r = diffuse.r;
+			vertex.g = diffuse.g;
+			vertex.b = diffuse.b;
+			vertex.a = diffuse.a;
+		}
+
+		sprite_batch.push_back(item);
 	}
 
-	static color calculate_blinn_phong(
-		const vec3& position,
-		const vec3& normal,
-		const color& diffuse,
-		const color& specular,
-		const color& ambient,
-		float shininess,
-		const vec3& camera_position,
-		const std::vector<light*>& lights
-	) {
-		int i;
-		color diffuse_sum = color(0, 0, 0);
-		color specular_sum = color(0, 0, 0);
-		float light_w;
-		vec3 light_pos;
-		color light_color;
-		float attenuation;
-		vec3 normal_direction = vec3::normalize(normal);
-		vec3 view_direction = vec3::normalize(camera_position - position);
-		vec3 vert_to_light;
-		float vert_to_light_mag;
-		vec3 light_direction;
-		color diffuse_reflection;
-		color specular_reflection;
-		color ambient_lighting = ambient * diffuse;
-		light* light;
+	// Draw a 2D texture onto (dest)[0, 1] view space, from (src)[0, 1] uv space.
+	void draw(const texture& texture, vec2 dest_min, vec2 dest_max, vec2 src_min, vec2 src_max) override {
+		static const GLfloat identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+		flush_sprites();
+
+		state.load_matrix(GL_MODELVIEW, identity);
+		state.load_matrix(GL_PROJECTION, identity);
 
-		// Loop through each light source.
-		for(i = 0; i < lights.size(); ++i) {
-			light = lights[i];
+		dest_min.x = (dest_min.x * 2.0F) - 1.0F;
+		dest_min.y = (dest_min.y * 2.0F) - 1.0F;
+		dest_max.x = (dest_max.x * 2.0F) - 1.0F;
+		dest_max.y = (dest_max.y * 2.0F) - 1.0F;
+
+		// Check if completely out of bounds.
+		if(dest_min.x > 1.0F) {
+			return;
+		} else if(dest_max.x < -1.0F) {
+			return;
+		} else if(dest_min.y > 1.0F) {
+			return;
+		} else if(dest_max.y < -1.0F) {
+			return;
+		}
 
-			if(light->transform == nullptr)
-				continue;
+		if(texture.is_on_gpu()) {
+			state.set_enabled(GL_TEXTURE_2D, true);
+			state.bind_texture(texture.handle);
+		} else {
+			state.set_enabled(GL_TEXTURE_2D, false);
+		}
 
-			// Calculate the light position and colour based on the light properties
-			// light_w is set to 0 if the light is directional, and 1 otherwise.
-			if(light->type == light_mode::DIRECTIONAL) {
-				light_pos = light->transform->get_global_backward();
-				light_w = 0.0F;
-				light_color = light->tint * light->intensity;
-				attenuation = 1.0F;
-			} else {
-				light_pos = light->transform->get_global_position();
-				light_w = 1.0F;
+		state.set_enabled(GL_DEPTH_TEST, false);
+		state.depth_mask(false);
 
-				// For non direcitonal lights, we'll figure out the light
-				// color per pixel, based on the distance from the light
-				// to the pixel.
-				light_color = color(0, 0, 0);
+		state.set_enabled(GL_BLEND, current_blit_mode == blit_mode::ALPHA_BLEND);
+		if(current_blit_mode == blit_mode::ALPHA_BLEND)
+			state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-				// Calculate the distance from the light to the pixel, and 1/distance.
-				vert_to_light = light_pos - position;
-				vert_to_light_mag = vert_to_light.magnitude();
+		// No per texel compare in fixed function, keyed texels need zero alpha.
+		state.set_enabled(GL_ALPHA_TEST, current_blit_mode == blit_mode::COLOR_KEY);
+		if(current_blit_mode == blit_mode::COLOR_KEY)
+			state.alpha_func(GL_GREATER, 0.0F);
 
-				attenuation = 1.0F / vert_to_light_mag;
+		glColor4f(1, 1, 1, 1);
 
-				// Calculate the colour based on the distance and light range.
-				if(vert_to_light_mag < light->range)
-					light_color *= light->intensity;
-			}
+		glBegin(GL_QUADS);
 
-			// Calculate light direction.
-			light_direction = light_pos - (position * light_w);
+		glTexCoord2f(src_min.x, 1.0F - src_min.y);
+		glVertex3f(dest_min.x, dest_min.y, 0.0F);
 
-			// Calculate diffuse lighting.
-			diffuse_reflection = light_color * diffuse * fmaxf(0, vec3::dot(normal_direction, view_direction)) * attenuation;
+		glTexCoord2f(src_max.x, 1.0F - src_min.y);
+		glVertex3f(dest_max.x, dest_min.y, 0.0F);
 
-			// Calculate Specular reflection if the normal is pointing in the
-			// lights direction.
-			if(vec3::dot(normal_direction, light_direction) < 0.0) {
-				specular_reflection = color(0, 0, 0);
-			} else {
-				// Calculate the specular colour using Blinn-Phong lighting
-				specular_reflection = light_color * specular * powf(fmaxf(0.0F, vec3::dot(normal_direction, vec3::normalize(light_direction + view_direction))), shininess * 128) * attenuation;
-			}
+		glTexCoord2f(src_max.x, 1.0F - src_max.y);
+		glVertex3f(dest_max.x, dest_max.y, 0.0F);
 
-			diffuse_sum += diffuse_reflection;
-			specular_sum += specular_reflection;
-		}
+		glTexCoord2f(src_min.x, 1.0F - src_max.y);
+		glVertex3f(dest_min.x, dest_max.y, 0.0F);
 
-		// The final color for this pixel is the sum of the ambient, diffuse and specular.
-		return ambient_lighting + diffuse_sum + specular_sum;
+		glEnd();
 	}
 
+	// Draw a 2D texture onto (dest)[0, w/h] frame space, from (src)[0, w/h] texel space.
+	void draw(
+		const texture& texture,
+		int dest_min_x,
+		int dest_min_y,
+		int dest_max_x,
+		int dest_max_y,
+		int src_min_x,
+		int src_min_y,
+		int src_max_x,
+		int src_max_y
+	) override {
+		vec2 dest_min;
+		vec2 dest_max;
+		vec2 src_min;
+		vec2 src_max;
+
+		dest_min.x = float(dest_min_x) / window_width;
+		dest_min.y = float(dest_min_y) / window_height;
+		dest_max.x = float(dest_max_x) / window_width;
+		dest_max.y = float(dest_max_y) / window_height;
+
+		src_min.x = float(src_min_x) / texture.get_width();
+		src_min.y = float(src_min_y) / texture.get_height();
+		src_max.x = float(src_max_x) / texture.get_width();
+		src_max.y = float(src_max_y) / texture.get_height();
+
+		draw(texture, dest_min, dest_max, src_min, src_max);
+	}
 
+	bool on_window_resized(const window_resized_event& e) override {
+		window_width = e.width;
+		window_height = e.height;
+		glViewport(0, 0, window_width, window_height);
+		return false; // Do not consume event. Let it propagate through higher layers.
+	}
 };
-#endif /* SYS_SOFTWARE_GL */
+#endif /* SYS_OPENGL_1_0 */
 //********************************************//
-//* Software Renderer                        *//
+//* OpenGL 1.0 Renderer                      *//
 //********************************************//
 #pragma endregion
 
 
-#pragma region /* rge::opengl_1_0 */
+#pragma region /* rge::opengl_3_3 */
 //********************************************//
-//* OpenGL 1.0 Renderer                      *//
+//* OpenGL 3.3 Renderer                      *//
 //********************************************//
-#ifdef SYS_OPENGL_1_0
-class opengl_1_0 : public rge::renderer {
+#ifdef SYS_OPENGL_3_3
+typedef char GLchar;
+typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
+typedef GLuint CALLSTYLE locCreateShader_t(GLenum type);
+typedef GLuint CALLSTYLE locCreateProgram_t(void);
+typedef void CALLSTYLE locDeleteShader_t(GLuint shader);
+typedef void CALLSTYLE locShaderSource_t(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+typedef void CALLSTYLE locCompileShader_t(GLuint shader);
+typedef void CALLSTYLE locGetShaderiv_t(GLuint shader, GLenum pname, GLint* params);
+typedef void CALLSTYLE locLinkProgram_t(GLuint program);
+typedef void CALLSTYLE locGetProgramiv_t(GLuint program, GLenum pname, GLint* params);
+typedef void CALLSTYLE locGetProgramInfoLog_t(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+typedef void CALLSTYLE locDeleteProgram_t(GLuint program);
+typedef void CALLSTYLE locAttachShader_t(GLuint program, GLuint shader);
+typedef void CALLSTYLE locBindBuffer_t(GLenum target, GLuint buffer);
+typedef void CALLSTYLE locBufferData_t(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+typedef void CALLSTYLE locGenBuffers_t(GLsizei n, GLuint* buffers);
+typedef void CALLSTYLE locDeleteBuffers_t(GLsizei n, const GLuint* buffers);
+typedef void* CALLSTYLE locMapBufferRange_t(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean CALLSTYLE locUnmapBuffer_t(GLenum target);
+typedef void CALLSTYLE locVertexAttribPointer_t(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+typedef void CALLSTYLE locEnableVertexAttribArray_t(GLuint index);
+typedef void CALLSTYLE locVertexAttribDivisor_t(GLuint index, GLuint divisor);
+typedef void CALLSTYLE locDrawArraysInstanced_t(GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+typedef void CALLSTYLE locUseProgram_t(GLuint program);
+typedef void CALLSTYLE locBindVertexArray_t(GLuint array);
+typedef void CALLSTYLE locGenVertexArrays_t(GLsizei n, GLuint* arrays);
+typedef void CALLSTYLE locDeleteVertexArrays_t(GLsizei n, const GLuint* arrays);
+typedef void CALLSTYLE locGetShaderInfoLog_t(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+typedef GLint CALLSTYLE locGetUniformLocation_t(GLuint program, const GLchar* name);
+typedef void CALLSTYLE locUniform1f_t(GLint location, GLfloat v0);
+typedef void CALLSTYLE locUniform1i_t(GLint location, GLint v0);
+typedef void CALLSTYLE locUniform2fv_t(GLint location, GLsizei count, const GLfloat* value);
+typedef void CALLSTYLE locUniform4fv_t(GLint location, GLsizei count, const GLfloat* value);
+typedef void CALLSTYLE locUniformMatrix4fv_t(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+typedef void CALLSTYLE locActiveTexture_t(GLenum texture);
+typedef void CALLSTYLE locGenFrameBuffers_t(GLsizei n, GLuint* ids);
+typedef void CALLSTYLE locBindFrameBuffer_t(GLenum target, GLuint fb);
+typedef GLenum CALLSTYLE locCheckFrameBufferStatus_t(GLenum target);
+typedef void CALLSTYLE locDeleteFrameBuffers_t(GLsizei n, const GLuint* fbs);
+typedef void CALLSTYLE locFrameBufferTexture2D_t(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+typedef void CALLSTYLE locDrawBuffers_t(GLsizei n, const GLenum* bufs);
+typedef void CALLSTYLE locBlendFuncSeparate_t(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+#ifdef SYS_WINDOWS
+typedef void CALLSTYLE locSwapInterval_t(GLsizei n);
+#endif /* SYS_WINDOWS */
+
+class opengl_3_3 : public rge::renderer {
 private:
 	#ifdef SYS_WINDOWS
 	gl_device_context_t device = 0;
 	gl_render_context_t render = 0;
 	#endif
 
+	locCreateShader_t* glCreateShader = nullptr;
+	locShaderSource_t* glShaderSource = nullptr;
+	locCompileShader_t* glCompileShader = nullptr;
+	locGetShaderiv_t* glGetShaderiv = nullptr;
+	locGetShaderInfoLog_t* glGetShaderInfoLog = nullptr;
+	locDeleteShader_t* glDeleteShader = nullptr;
+	locCreateProgram_t* glCreateProgram = nullptr;
+	locDeleteProgram_t* glDeleteProgram = nullptr;
+	locLinkProgram_t* glLinkProgram = nullptr;
+	locGetProgramiv_t* glGetProgramiv = nullptr;
+	locGetProgramInfoLog_t* glGetProgramInfoLog = nullptr;
+	locAttachShader_t* glAttachShader = nullptr;
+	locUseProgram_t* glUseProgram = nullptr;
+	locGetUniformLocation_t* glGetUniformLocation = nullptr;
+	locUniform1i_t* glUniform1i = nullptr;
+	locUniform1f_t* glUniform1f = nullptr;
+	locUniform4fv_t* glUniform4fv = nullptr;
+	locUniformMatrix4fv_t* glUniformMatrix4fv = nullptr;
+	locBindBuffer_t* glBindBuffer = nullptr;
+	locBufferData_t* glBufferData = nullptr;
+	locGenBuffers_t* glGenBuffers = nullptr;
+	locDeleteBuffers_t* glDeleteBuffers = nullptr;
+	locMapBufferRange_t* glMapBufferRange = nullptr;
+	locUnmapBuffer_t* glUnmapBuffer = nullptr;
+	locVertexAttribPointer_t* glVertexAttribPointer = nullptr;
+	locEnableVertexAttribArray_t* glEnableVertexAttribArray = nullptr;
+	locVertexAttribDivisor_t* glVertexAttribDivisor = nullptr;
+	locDrawArraysInstanced_t* glDrawArraysInstanced = nullptr;
+	locBindVertexArray_t* glBindVertexArray = nullptr;
+	locGenVertexArrays_t* glGenVertexArrays = nullptr;
+	locDeleteVertexArrays_t* glDeleteVertexArrays = nullptr;
+	locActiveTexture_t* glActiveTexture = nullptr;
+	#ifdef SYS_WINDOWS
+	locSwapInterval_t* glSwapInterval = nullptr;
+	#endif
+
+	// Starting size of the streaming buffer, it grows to fit larger uploads.
+	static const size_t STREAM_BUFFER_SIZE = 4 * 1024 * 1024;
+
+	// Attribute slots, shared by the shaders & vertex arrays.
+	enum attribute {
+		ATTRIB_POSITION = 0,
+		ATTRIB_NORMAL = 1,
+		ATTRIB_UV = 2,
+		ATTRIB_ORIGIN = 0,
+		ATTRIB_RIGHT = 1,
+		ATTRIB_UP = 2,
+		ATTRIB_COLOR = 3,
+		ATTRIB_UV_RECT = 4
+	};
+
+	struct program {
+		GLuint id;
+		GLint view_projection;
+		GLint model;
+		GLint diffuse;
+		GLint textured;
+		GLint alpha_cutoff;
+	};
+
+	// Interleaved layout of mesh vertex buffers.
+	struct mesh_vertex {
+		GLfloat x, y, z;
+		GLfloat nx, ny, nz;
+		GLfloat u, v;
+	};
+
+	// Per instance data of a textured quad, the corners being
+	// origin, origin + right, origin + up & origin + right + up.
+	struct quad_instance {
+		GLfloat origin[3];
+		GLfloat right[3];
+		GLfloat up[3];
+		GLfloat color[4];
+		GLfloat uv_rect[4]; // uv at origin, then at the opposite corner.
+	};
+
+	// Buffers of an uploaded mesh, keyed on its vertex array.
+	struct mesh_buffers {
+		GLuint vertices;
+		GLuint indices;
+		GLsizei index_count;
+	};
+
+	// A queued sprite, already in world space. Keeps the GL name of its
+	// texture, 0 when it was never uploaded.
+	struct sprite_batch_item {
+		GLuint texture_handle;
+		int layer;
+		quad_instance instance;
+	};
+
 	int window_width;
 	int window_height;
 
-public:
-	opengl_1_0() {
+	gl_state_cache state;
 
+	program mesh_program;
+	program quad_program;
+	GLuint current_program;
+
+	GLuint stream_buffer;
+	size_t stream_capacity;
+	size_t stream_offset;
+
+	GLuint stream_mesh_array; // Reads mesh vertices from the streaming buffer.
+	GLuint quad_array;        // Reads quad instances from the streaming buffer.
+
+	std::unordered_map<GLuint, mesh_buffers> meshes;
+	std::vector<mesh_vertex> mesh_vertices;
+
+	std::vector<sprite_batch_item> sprite_batch;
+	std::vector<quad_instance> quad_instances;
+	camera::ptr sprite_batch_camera;
+
+	static const char* const MESH_VERTEX_SHADER;
+	static const char* const QUAD_VERTEX_SHADER;
+	static const char* const FRAGMENT_SHADER;
+
+public:
+	opengl_3_3() {
+		window_width = 0;
+		window_height = 0;
+		mesh_program.id = 0;
+		quad_program.id = 0;
+		current_program = 0;
+		stream_buffer = 0;
+		stream_capacity = 0;
+		stream_offset = 0;
+		stream_mesh_array = 0;
+		quad_array = 0;
 	}
 
 	rge::result init(platform* platform) override {
@@ -5058,20 +10990,47 @@ public:
 		#endif
 
 		#ifdef SYS_LINUX
-		
+		// The context is made current by the caller, windowed or headless.
+		(void)platform;
 		#endif
-		
+
 		#ifdef SYS_MACOSX
-		
+
 		#endif
 
-		//glEnable(GL_LIGHTING);
-		glEnable(GL_LIGHT0);
-		glEnable(GL_COLOR_MATERIAL);
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_NORMALIZE);
+		if(load_functions() != rge::OK) {
+			rge::log::error("OpenGL 3.3 entry points not found.");
+			return rge::FAIL;
+		}
 
-		glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+		if(create_program(mesh_program, MESH_VERTEX_SHADER) != rge::OK) return rge::FAIL;
+		if(create_program(quad_program, QUAD_VERTEX_SHADER) != rge::OK) return rge::FAIL;
+
+		glGenBuffers(1, &stream_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, stream_buffer);
+		stream_capacity = STREAM_BUFFER_SIZE;
+		stream_offset = 0;
+		glBufferData(GL_ARRAY_BUFFER, stream_capacity, nullptr, GL_STREAM_DRAW);
+
+		glGenVertexArrays(1, &stream_mesh_array);
+		glGenVertexArrays(1, &quad_array);
+
+		// Instances advance once per quad, the 4 corners come from gl_VertexID.
+		glBindVertexArray(quad_array);
+		for(GLuint i = ATTRIB_ORIGIN; i <= ATTRIB_UV_RECT; i++) {
+			glEnableVertexAttribArray(i);
+			glVertexAttribDivisor(i, 1);
+		}
+
+		glBindVertexArray(stream_mesh_array);
+		enable_mesh_attributes();
+
+		glActiveTexture(GL_TEXTURE0);
+
+		// Fresh context, nothing known about its state yet.
+		state.invalidate();
+		state.set_enabled(GL_DEPTH_TEST, true);
+		current_program = 0;
 
 		return rge::OK;
 	}
@@ -5092,11 +11051,16 @@ public:
 	void upload_texture(texture& texture) override {
 		alloc_texture(texture);
 
+		// GL takes row-major texels.
+		texture.set_layout(texture_layout::LINEAR);
+
 		if(!texture.is_on_cpu()) return;
-		glBindTexture(GL_TEXTURE_2D, texture.handle);
+		state.bind_texture(texture.handle);
 		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		GLint wrap = texture.wrap == texture_wrap::CLAMP ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
 
 		if(texture.filter == texture_filter::NEAREST) {
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -5104,14 +11068,80 @@ public:
 		} else if(texture.filter == texture_filter::BILINEAR) {
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		} else if(texture.filter == texture_filter::TRILINEAR) {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.get_mip_count() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		}
 
-		glTexImage2D(GL_TEXTURE_2D, 0, 4, texture.get_width(), texture.get_height(), 0, GL_RGBA, GL_FLOAT, texture.get_data());
+		// Only the uploaded levels, or the texture is incomplete.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.get_mip_count() - 1);
+
+		for(int level = 0; level < texture.get_mip_count(); level++)
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, texture.get_mip_width(level), texture.get_mip_height(level), 0, GL_RGBA, GL_FLOAT, texture.get_mip_data(level));
 	}
 
 	void free_texture(texture& texture) override {
-		if(texture.is_on_gpu())
+		if(texture.is_on_gpu()) {
+			state.forget_texture(texture.handle);
 			glDeleteTextures(1, &texture.handle);
+		}
+	}
+
+	void upload_mesh(mesh& mesh) override {
+		if(!mesh.is_on_gpu()) {
+			mesh_buffers buffers;
+			glGenVertexArrays(1, &mesh.handle);
+			glGenBuffers(1, &buffers.vertices);
+			glGenBuffers(1, &buffers.indices);
+			meshes[mesh.handle] = buffers;
+		}
+
+		mesh_buffers& buffers = meshes[mesh.handle];
+
+		// Attributes are per vertex, so the mesh indices carry over as is.
+		mesh_vertices.resize(mesh.vertices.size());
+		for(size_t v = 0; v < mesh.vertices.size(); v++)
+			mesh_vertices[v] = make_mesh_vertex(mesh.vertices, mesh.normals, mesh.uvs, v);
+
+		// Triangles pointing past the vertices are left out.
+		std::vector<GLuint> indices;
+		indices.reserve(mesh.triangles.size());
+		for(size_t i = 0; i + 2 < mesh.triangles.size(); i += 3) {
+			size_t a = (size_t)mesh.triangles[i];
+			size_t b = (size_t)mesh.triangles[i + 1];
+			size_t c = (size_t)mesh.triangles[i + 2];
+			if(a >= mesh.vertices.size() || b >= mesh.vertices.size() || c >= mesh.vertices.size()) continue;
+
+			indices.push_back((GLuint)a);
+			indices.push_back((GLuint)b);
+			indices.push_back((GLuint)c);
+		}
+
+		buffers.index_count = (GLsizei)indices.size();
+
+		glBindVertexArray(mesh.handle);
+
+		glBindBuffer(GL_ARRAY_BUFFER, buffers.vertices);
+		glBufferData(GL_ARRAY_BUFFER, mesh_vertices.size() * sizeof(mesh_vertex), mesh_vertices.data(), GL_STATIC_DRAW);
+		enable_mesh_attributes();
+		set_mesh_attributes(0);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indices);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	}
+
+	void free_mesh(mesh& mesh) override {
+		if(!mesh.is_on_gpu()) return;
+
+		std::unordered_map<GLuint, mesh_buffers>::iterator it = meshes.find(mesh.handle);
+		if(it != meshes.end()) {
+			glDeleteBuffers(1, &it->second.vertices);
+			glDeleteBuffers(1, &it->second.indices);
+			meshes.erase(it);
+		}
+
+		glDeleteVertexArrays(1, &mesh.handle);
+		mesh.handle = 0;
 	}
 
 	int get_width() const override {
@@ -5122,7 +11152,17 @@ public:
 		return window_height;
 	}
 
+	// Returns the GL state changes issued & skipped over the last frame.
+	const gl_state_cache::stats& get_state_stats() const {
+		return state.get_frame_stats();
+	}
+
 	void clear(color background) override {
+		flush_sprites();
+
+		// glClear honors the depth mask.
+		state.depth_mask(true);
+
 		glClearColor(
 			float(background.r),
 			float(background.g),
@@ -5139,24 +11179,25 @@ public:
 	}
 
 	void display() override {
+		flush_sprites();
+		state.end_frame();
+
 		#ifdef SYS_WINDOWS
 		glFlush();
 		SwapBuffers(device);
 		// if(bSync) DwmFlush();
 		#endif
 
-		#ifdef SYS_LINUX
-		// TODO
-		// X11::glXSwapBuffers(olc_Display, *olc_Window);
-		#endif
+		// NOTE: On linux the caller owns the context, and swaps or reads
+		// back the frame after display(). See tools/glcheck.
 
 		#ifdef SYS_MACOSX
-		glFlush();
-		glutSwapBuffers();
+
 		#endif
 	}
 
-	// Draw 3D geometry, using model space data.
+	// Draw 3D geometry, using model space data. The vertices go through the
+	// streaming buffer, upload the mesh to keep them on gpu instead.
 	rge::result draw(
 		const mat4& local_to_world,
 		const std::vector<vec3>& vertices,
@@ -5165,77 +11206,63 @@ public:
 		const std::vector<vec2>& uvs,
 		const material& material
 	) override {
-		int i;
-		int v;
-		vec3 vertex;
-		vec3 normal;
-		GLfloat gl_m[16];
-
 		if(input_camera == nullptr) return rge::FAIL;
-		
-		convert_matrix(gl_m, input_camera->get_view_matrix());
-		glMatrixMode(GL_MODELVIEW);
-		glLoadMatrixf(gl_m);
-
-		convert_matrix(gl_m, input_camera->get_projection_matrix());
-		glMatrixMode(GL_PROJECTION);
-		glLoadMatrixf(gl_m);
 
-		float lpos[4] = { 0, 1, 0, 1.0 };  //light's position
-		//glLightfv(GL_LIGHT0, GL_POSITION, lpos);   //Set light position
+		mesh_vertices.clear();
+		for(size_t i = 0; i + 2 < triangles.size(); i += 3) {
+			size_t a = (size_t)triangles[i];
+			size_t b = (size_t)triangles[i + 1];
+			size_t c = (size_t)triangles[i + 2];
+			if(a >= vertices.size() || b >= vertices.size() || c >= vertices.size()) continue;
 
-		if(material.texture != nullptr && material.texture->is_on_gpu()) {
-			glEnable(GL_TEXTURE_2D);
-			glBindTexture(GL_TEXTURE_2D, material.texture->handle);
-		} else {
-			glDisable(GL_TEXTURE_2D);
+			mesh_vertices.push_back(make_mesh_vertex(vertices, normals, uvs, a));
+			mesh_vertices.push_back(make_mesh_vertex(vertices, normals, uvs, b));
+			mesh_vertices.push_back(make_mesh_vertex(vertices, normals, uvs, c));
 		}
 
-		if(material.diffuse.a < 1.0F) {
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		} else {
-			glDisable(GL_BLEND);
-		}
+		if(mesh_vertices.empty()) return rge::OK;
 
-		glColor4f(material.diffuse.r, material.diffuse.g, material.diffuse.b, material.diffuse.a);
+		bind_mesh_state(local_to_world, material);
 
-		glBegin(GL_TRIANGLES); {
-			for(i = 0; i < triangles.size(); i++) {
-				v = triangles[i];
+		GLintptr offset = stream(mesh_vertices.data(), mesh_vertices.size() * sizeof(mesh_vertex));
+		if(offset < 0) return rge::FAIL;
 
-				if(v < uvs.size()) {
-					glTexCoord2f(uvs[v].x, 1.0F - uvs[v].y);
-				}
+		glBindVertexArray(stream_mesh_array);
+		set_mesh_attributes(offset);
+		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)mesh_vertices.size());
+
+		return rge::OK;
+	}
 
-				if(v < vertices.size()) {
-					vertex = local_to_world.multiply_point_3x4(vertices[v]);
-					glVertex3f(vertex.x, vertex.y, vertex.z);
-				}
+	// Draw 3D geometry from its static buffers, if uploaded.
+	rge::result draw(const mat4& local_to_world, const mesh& mesh, const material& material) override {
+		if(input_camera == nullptr) return rge::FAIL;
+		if(!mesh.is_on_gpu()) return draw(local_to_world, mesh.vertices, mesh.triangles, mesh.normals, mesh.uvs, material);
 
-				if(v < normals.size()) {
-					normal = local_to_world.multiply_vector(normals[v]);
-					glNormal3f(normal.x, normal.y, normal.z);
-				}
-			}
-		} glEnd();
+		std::unordered_map<GLuint, mesh_buffers>::const_iterator it = meshes.find(mesh.handle);
+		if(it == meshes.end()) return rge::FAIL;
 
-		glColor4f(1, 1, 1, 1);
-		glDisable(GL_BLEND);
-		glDisable(GL_TEXTURE_2D);
+		bind_mesh_state(local_to_world, material);
+
+		glBindVertexArray(mesh.handle);
+		glDrawElements(GL_TRIANGLES, it->second.index_count, GL_UNSIGNED_INT, nullptr);
 
 		return rge::OK;
 	}
 
-	// Draw a 2D sprite onto camera space.
+	// Queues a 2D sprite, drawn instanced with the rest of the batch on the next flush.
 	void draw(const sprite& sprite) override {
 		if(input_camera == nullptr) return;
 		if(sprite.texture == nullptr) return;
 
-		GLfloat gl_m[16];
+		// Sprites queued through another camera go out first.
+		if(sprite_batch_camera != input_camera) {
+			flush_sprites();
+			sprite_batch_camera = input_camera;
+		}
+
 		mat4 sprite_matrix = sprite.transform->get_global_matrix();
 		mat4 camera_matrix = input_camera->transform->get_global_matrix();
-		mat4 view_matrix = input_camera->get_view_matrix();
 
 		float w = float(sprite.texture->get_width()) / sprite.pixels_per_unit;
 		float h = float(sprite.texture->get_height()) / sprite.pixels_per_unit;
@@ -5248,80 +11275,37 @@ public:
 			p.x -= w / 2.0F;
 			p.y -= h / 2.0F;
 		}
-		
-		vec3 n;
-		vec3 p_bl;
-		vec3 p_br;
-		vec3 p_tl;
-		vec3 p_tr;
+
+		vec3 origin = sprite_matrix.multiply_point_3x4(p);
+		vec3 right;
+		vec3 up;
 
 		if(sprite.billboard) {
-			n = camera_matrix.multiply_vector(vec3(0, 0, -1));
-			p_bl = sprite_matrix.multiply_point_3x4(p);
-			p_br = p_bl + camera_matrix.multiply_vector(r);
-			p_tl = p_bl + camera_matrix.multiply_vector(u);
-			p_tr = p_bl + camera_matrix.multiply_vector(u + r);
+			right = camera_matrix.multiply_vector(r);
+			up = camera_matrix.multiply_vector(u);
 		} else {
-			n = sprite_matrix.multiply_vector(vec3(0, 0, -1));
-			p_bl = sprite_matrix.multiply_point_3x4(p);
-			p_br = sprite_matrix.multiply_point_3x4(p + r);
-			p_tl = sprite_matrix.multiply_point_3x4(p + u);
-			p_tr = sprite_matrix.multiply_point_3x4(p + r + u);
+			right = sprite_matrix.multiply_point_3x4(p + r) - origin;
+			up = sprite_matrix.multiply_point_3x4(p + u) - origin;
 		}
 
 		color diffuse = color();
 		if(sprite.material) diffuse = sprite.material->diffuse;
 
-		convert_matrix(gl_m, input_camera->get_view_matrix());
-		glMatrixMode(GL_MODELVIEW);
-		glLoadMatrixf(gl_m);
-
-		convert_matrix(gl_m, input_camera->get_projection_matrix());
-		glMatrixMode(GL_PROJECTION);
-		glLoadMatrixf(gl_m);
-
-		if(sprite.texture->is_on_gpu()) {
-			glEnable(GL_TEXTURE_2D);
-			glBindTexture(GL_TEXTURE_2D, sprite.texture->handle);
-		} else {
-			glDisable(GL_TEXTURE_2D);
-		}
-
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		sprite_batch_item item;
+		item.texture_handle = sprite.texture->is_on_gpu() ? sprite.texture->handle : 0;
+		item.layer = sprite.layer;
 
-		glColor4f(diffuse.r, diffuse.g, diffuse.b, diffuse.a);
+		// Texel row 0 is the top of the image.
+		set_quad_instance(item.instance, origin, right, up, diffuse, vec2(0, 1), vec2(1, 0));
 
-		glBegin(GL_QUADS); {
-			glTexCoord2f(0.0F, 1.0F);
-			glVertex3f(p_bl.x, p_bl.y, p_bl.z);
-			glNormal3f(n.x, n.y, n.z);
-
-			glTexCoord2f(1.0F, 1.0F);
-			glVertex3f(p_br.x, p_br.y, p_br.z);
-			glNormal3f(n.x, n.y, n.z);
-
-			glTexCoord2f(1.0F, 0.0F);
-			glVertex3f(p_tr.x, p_tr.y, p_tr.z);
-			glNormal3f(n.x, n.y, n.z);
-
-			glTexCoord2f(0.0F, 0.0F);
-			glVertex3f(p_tl.x, p_tl.y, p_tl.z);
-			glNormal3f(n.x, n.y, n.z);
-		} glEnd();
-
-		glColor4f(1, 1, 1, 1);
-		glDisable(GL_BLEND);
-		glDisable(GL_TEXTURE_2D);
+		sprite_batch.push_back(item);
 	}
 
 	// Draw a 2D texture onto (dest)[0, 1] view space, from (src)[0, 1] uv space.
 	void draw(const texture& texture, vec2 dest_min, vec2 dest_max, vec2 src_min, vec2 src_max) override {
-		glMatrixMode(GL_MODELVIEW);
-		glLoadIdentity();
-		
-		glMatrixMode(GL_PROJECTION);
-		glLoadIdentity();
+		static const GLfloat identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+		flush_sprites();
 
 		dest_min.x = (dest_min.x * 2.0F) - 1.0F;
 		dest_min.y = (dest_min.y * 2.0F) - 1.0F;
@@ -5339,35 +11323,34 @@ public:
 			return;
 		}
 
-		if(texture.is_on_gpu()) {
-			glEnable(GL_TEXTURE_2D);
-			glBindTexture(GL_TEXTURE_2D, texture.handle);
-		} else {
-			glDisable(GL_TEXTURE_2D);
-		}
-
-		glDisable(GL_DEPTH_TEST);
-		glDepthMask(GL_FALSE);
-
-		glBegin(GL_QUADS);
+		quad_instance instance;
+		set_quad_instance(
+			instance,
+			vec3(dest_min.x, dest_min.y, 0.0F),
+			vec3(dest_max.x - dest_min.x, 0.0F, 0.0F),
+			vec3(0.0F, dest_max.y - dest_min.y, 0.0F),
+			color(),
+			vec2(src_min.x, 1.0F - src_min.y),
+			vec2(src_max.x, 1.0F - src_max.y)
+		);
 
-		glTexCoord2f(src_min.x, 1.0F - src_min.y);
-		glVertex3f(dest_min.x, dest_min.y, 0.0F);
+		state.set_enabled(GL_DEPTH_TEST, false);
+		state.depth_mask(false);
 
-		glTexCoord2f(src_max.x, 1.0F - src_min.y);
-		glVertex3f(dest_max.x, dest_min.y, 0.0F);
+		state.set_enabled(GL_BLEND, current_blit_mode == blit_mode::ALPHA_BLEND);
+		if(current_blit_mode == blit_mode::ALPHA_BLEND)
+			state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-		glTexCoord2f(src_max.x, 1.0F - src_max.y);
-		glVertex3f(dest_max.x, dest_max.y, 0.0F);
+		use_program(quad_program);
+		glUniformMatrix4fv(quad_program.view_projection, 1, GL_FALSE, identity);
 
-		glTexCoord2f(src_min.x, 1.0F - src_max.y);
-		glVertex3f(dest_min.x, dest_max.y, 0.0F);
+		// Keyed texels need zero alpha, as with alpha testing.
+		glUniform1f(quad_program.alpha_cutoff, current_blit_mode == blit_mode::COLOR_KEY ? 0.0F : -1.0F);
 
-		glEnd();
+		GLintptr offset = stream(&instance, sizeof(quad_instance));
+		if(offset < 0) return;
 
-		glDepthMask(GL_TRUE);
-		glEnable(GL_DEPTH_TEST);
-		glDisable(GL_TEXTURE_2D);
+		draw_quads(offset, 1, texture.is_on_gpu() ? texture.handle : 0);
 	}
 
 	// Draw a 2D texture onto (dest)[0, w/h] frame space, from (src)[0, w/h] texel space.
@@ -5406,224 +11389,348 @@ public:
 		glViewport(0, 0, window_width, window_height);
 		return false; // Do not consume event. Let it propagate through higher layers.
 	}
-};
-#endif /* SYS_OPENGL_1_0 */
-//********************************************//
-//* OpenGL 1.0 Renderer                      *//
-//********************************************//
-#pragma endregion
-
-
-#pragma region /* rge::opengl_3_3 */
-//********************************************//
-//* OpenGL 3.3 Renderer                      *//
-//********************************************//
-#ifdef SYS_OPENGL_3_3
-typedef char GLchar;
-typedef ptrdiff_t GLsizeiptr;
-typedef GLuint CALLSTYLE locCreateShader_t(GLenum type);
-typedef GLuint CALLSTYLE locCreateProgram_t(void);
-typedef void CALLSTYLE locDeleteShader_t(GLuint shader);
-typedef void CALLSTYLE locCompileShader_t(GLuint shader);
-typedef void CALLSTYLE locLinkProgram_t(GLuint program);
-typedef void CALLSTYLE locDeleteProgram_t(GLuint program);
-typedef void CALLSTYLE locAttachShader_t(GLuint program, GLuint shader);
-typedef void CALLSTYLE locBindBuffer_t(GLenum target, GLuint buffer);
-typedef void CALLSTYLE locBufferData_t(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
-typedef void CALLSTYLE locGenBuffers_t(GLsizei n, GLuint* buffers);
-typedef void CALLSTYLE locVertexAttribPointer_t(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
-typedef void CALLSTYLE locEnableVertexAttribArray_t(GLuint index);
-typedef void CALLSTYLE locUseProgram_t(GLuint program);
-typedef void CALLSTYLE locBindVertexArray_t(GLuint array);
-typedef void CALLSTYLE locGenVertexArrays_t(GLsizei n, GLuint* arrays);
-typedef void CALLSTYLE locGetShaderInfoLog_t(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
-typedef GLint CALLSTYLE locGetUniformLocation_t(GLuint program, const GLchar* name);
-typedef void CALLSTYLE locUniform1f_t(GLint location, GLfloat v0);
-typedef void CALLSTYLE locUniform1i_t(GLint location, GLint v0);
-typedef void CALLSTYLE locUniform2fv_t(GLint location, GLsizei count, const GLfloat* value);
-typedef void CALLSTYLE locActiveTexture_t(GLenum texture);
-typedef void CALLSTYLE locGenFrameBuffers_t(GLsizei n, GLuint* ids);
-typedef void CALLSTYLE locBindFrameBuffer_t(GLenum target, GLuint fb);
-typedef GLenum CALLSTYLE locCheckFrameBufferStatus_t(GLenum target);
-typedef void CALLSTYLE locDeleteFrameBuffers_t(GLsizei n, const GLuint* fbs);
-typedef void CALLSTYLE locFrameBufferTexture2D_t(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
-typedef void CALLSTYLE locDrawBuffers_t(GLsizei n, const GLenum* bufs);
-typedef void CALLSTYLE locBlendFuncSeparate_t(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
-#ifdef SYS_WINDOWS
-typedef void CALLSTYLE locSwapInterval_t(GLsizei n);
-#endif /* SYS_WINDOWS */
 
-class opengl_3_3 : public rge::renderer {
 private:
-	#ifdef SYS_WINDOWS
-	gl_device_context_t device = 0;
-	gl_render_context_t render = 0;
-	#endif
+	rge::result load_functions() {
+		glCreateShader = OPENGL_LOAD(locCreateShader_t, glCreateShader);
+		glShaderSource = OPENGL_LOAD(locShaderSource_t, glShaderSource);
+		glCompileShader = OPENGL_LOAD(locCompileShader_t, glCompileShader);
+		glGetShaderiv = OPENGL_LOAD(locGetShaderiv_t, glGetShaderiv);
+		glGetShaderInfoLog = OPENGL_LOAD(locGetShaderInfoLog_t, glGetShaderInfoLog);
+		glDeleteShader = OPENGL_LOAD(locDeleteShader_t, glDeleteShader);
+		glCreateProgram = OPENGL_LOAD(locCreateProgram_t, glCreateProgram);
+		glDeleteProgram = OPENGL_LOAD(locDeleteProgram_t, glDeleteProgram);
+		glLinkProgram = OPENGL_LOAD(locLinkProgram_t, glLinkProgram);
+		glGetProgramiv = OPENGL_LOAD(locGetProgramiv_t, glGetProgramiv);
+		glGetProgramInfoLog = OPENGL_LOAD(locGetProgramInfoLog_t, glGetProgramInfoLog);
+		glAttachShader = OPENGL_LOAD(locAttachShader_t, glAttachShader);
+		glUseProgram = OPENGL_LOAD(locUseProgram_t, glUseProgram);
+		glGetUniformLocation = OPENGL_LOAD(locGetUniformLocation_t, glGetUniformLocation);
+		glUniform1i = OPENGL_LOAD(locUniform1i_t, glUniform1i);
+		glUniform1f = OPENGL_LOAD(locUniform1f_t, glUniform1f);
+		glUniform4fv = OPENGL_LOAD(locUniform4fv_t, glUniform4fv);
+		glUniformMatrix4fv = OPENGL_LOAD(locUniformMatrix4fv_t, glUniformMatrix4fv);
+		glBindBuffer = OPENGL_LOAD(locBindBuffer_t, glBindBuffer);
+		glBufferData = OPENGL_LOAD(locBufferData_t, glBufferData);
+		glGenBuffers = OPENGL_LOAD(locGenBuffers_t, glGenBuffers);
+		glDeleteBuffers = OPENGL_LOAD(locDeleteBuffers_t, glDeleteBuffers);
+		glMapBufferRange = OPENGL_LOAD(locMapBufferRange_t, glMapBufferRange);
+		glUnmapBuffer = OPENGL_LOAD(locUnmapBuffer_t, glUnmapBuffer);
+		glVertexAttribPointer = OPENGL_LOAD(locVertexAttribPointer_t, glVertexAttribPointer);
+		glEnableVertexAttribArray = OPENGL_LOAD(locEnableVertexAttribArray_t, glEnableVertexAttribArray);
+		glVertexAttribDivisor = OPENGL_LOAD(locVertexAttribDivisor_t, glVertexAttribDivisor);
+		glDrawArraysInstanced = OPENGL_LOAD(locDrawArraysInstanced_t, glDrawArraysInstanced);
+		glBindVertexArray = OPENGL_LOAD(locBindVertexArray_t, glBindVertexArray);
+		glGenVertexArrays = OPENGL_LOAD(locGenVertexArrays_t, glGenVertexArrays);
+		glDeleteVertexArrays = OPENGL_LOAD(locDeleteVertexArrays_t, glDeleteVertexArrays);
+		glActiveTexture = OPENGL_LOAD(locActiveTexture_t, glActiveTexture);
+
+		void* functions[] = {
+			(void*)glCreateShader, (void*)glShaderSource, (void*)glCompileShader, (void*)glGetShaderiv,
+			(void*)glGetShaderInfoLog, (void*)glDeleteShader, (void*)glCreateProgram, (void*)glDeleteProgram,
+			(void*)glLinkProgram, (void*)glGetProgramiv, (void*)glGetProgramInfoLog, (void*)glAttachShader,
+			(void*)glUseProgram, (void*)glGetUniformLocation, (void*)glUniform1i, (void*)glUniform1f,
+			(void*)glUniform4fv, (void*)glUniformMatrix4fv, (void*)glBindBuffer, (void*)glBufferData,
+			(void*)glGenBuffers, (void*)glDeleteBuffers, (void*)glMapBufferRange, (void*)glUnmapBuffer,
+			(void*)glVertexAttribPointer, (void*)glEnableVertexAttribArray, (void*)glVertexAttribDivisor, (void*)glDrawArraysInstanced,
+			(void*)glBindVertexArray, (void*)glGenVertexArrays, (void*)glDeleteVertexArrays, (void*)glActiveTexture
+		};
 
-	/*
-	locCreateShader_t* glCreateShader = nullptr;
-	locShaderSource_t* glShaderSource = nullptr;
-	locCompileShader_t* glCompileShader = nullptr;
-	locDeleteShader_t* glDeleteShader = nullptr;
-	locCreateProgram_t* glCreateProgram = nullptr;
-	locDeleteProgram_t* glDeleteProgram = nullptr;
-	locLinkProgram_t* glLinkProgram = nullptr;
-	locAttachShader_t* glAttachShader = nullptr;
-	*/
-	locBindBuffer_t* glBindBuffer = nullptr;
-	locBufferData_t* glBufferData = nullptr;
-	locGenBuffers_t* glGenBuffers = nullptr;
-	locVertexAttribPointer_t* glVertexAttribPointer = nullptr;
-	locEnableVertexAttribArray_t* glEnableVertexAttribArray = nullptr;
-	locUseProgram_t* glUseProgram = nullptr;
-	locBindVertexArray_t* glBindVertexArray = nullptr;
-	locGenVertexArrays_t* glGenVertexArrays = nullptr;
-	locSwapInterval_t* glSwapInterval = nullptr;
-	locGetShaderInfoLog_t* glGetShaderInfoLog = nullptr;
+		for(size_t i = 0; i < sizeof(functions) / sizeof(void*); i++)
+			if(functions[i] == nullptr) return rge::FAIL;
 
-public:
-	opengl_3_3() {
+		return rge::OK;
+	}
+
+	// Returns 0 on failure, after logging the compile errors.
+	GLuint compile_shader(GLenum type, const char* source) {
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+
+		GLint compiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		if(compiled != GL_TRUE) {
+			GLchar info[1024];
+			glGetShaderInfoLog(shader, sizeof(info), nullptr, info);
+			rge::log::error("Shader compile failed: %s", info);
+			glDeleteShader(shader);
+			return 0;
+		}
 
+		return shader;
 	}
 
-	rge::result init(platform* platform) override {
-		#ifdef SYS_WINDOWS
-		windows* winapi = (windows*)platform;
-		device = GetDC(winapi->handle);
-		PIXELFORMATDESCRIPTOR pfd = {
-			sizeof(PIXELFORMATDESCRIPTOR), 1,
-			PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
-			PFD_TYPE_RGBA, 32, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-			PFD_MAIN_PLANE, 0, 0, 0, 0
-		};
+	rge::result create_program(program& program, const char* vertex_source) {
+		GLuint vertex = compile_shader(GL_VERTEX_SHADER, vertex_source);
+		GLuint fragment = compile_shader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
 
-		int pf = 0;
-		if(!(pf = ChoosePixelFormat(device, &pfd)))
+		if(vertex == 0 || fragment == 0) {
+			if(vertex) glDeleteShader(vertex);
+			if(fragment) glDeleteShader(fragment);
 			return rge::FAIL;
-		SetPixelFormat(device, pf, &pfd);
+		}
 
-		if(!(render = wglCreateContext(device)))
+		program.id = glCreateProgram();
+		glAttachShader(program.id, vertex);
+		glAttachShader(program.id, fragment);
+		glLinkProgram(program.id);
+
+		// Flagged for deletion, they go with the program.
+		glDeleteShader(vertex);
+		glDeleteShader(fragment);
+
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program.id, GL_LINK_STATUS, &linked);
+		if(linked != GL_TRUE) {
+			GLchar info[1024];
+			glGetProgramInfoLog(program.id, sizeof(info), nullptr, info);
+			rge::log::error("Shader link failed: %s", info);
+			glDeleteProgram(program.id);
+			program.id = 0;
 			return rge::FAIL;
-		wglMakeCurrent(device, render);
+		}
 
-		// Remove Frame cap
-		/*
-		wglSwapInterval = (wglSwapInterval_t*)wglGetProcAddress("wglSwapIntervalEXT");
-		if(wglSwapInterval && !bVSYNC) wglSwapInterval(0);
-		bSync = false;
-		*/
-		#endif
-		
-		#ifdef SYS_LINUX
-		
-		#endif
-		
-		#ifdef SYS_MACOSX
-		
-		#endif
+		program.view_projection = glGetUniformLocation(program.id, "u_view_projection");
+		program.model = glGetUniformLocation(program.id, "u_model");
+		program.diffuse = glGetUniformLocation(program.id, "u_diffuse");
+		program.textured = glGetUniformLocation(program.id, "u_textured");
+		program.alpha_cutoff = glGetUniformLocation(program.id, "u_alpha_cutoff");
 
-		glBindBuffer = OPENGL_LOAD(locBindBuffer_t, glBindBuffer);
-		glBufferData = OPENGL_LOAD(locBufferData_t, glBufferData);
-		glGenBuffers = OPENGL_LOAD(locGenBuffers_t, glGenBuffers);
-		glVertexAttribPointer = OPENGL_LOAD(locVertexAttribPointer_t, glVertexAttribPointer);
-		glEnableVertexAttribArray = OPENGL_LOAD(locEnableVertexAttribArray_t, glEnableVertexAttribArray);
-		glUseProgram = OPENGL_LOAD(locUseProgram_t, glUseProgram);
-		glGetShaderInfoLog = OPENGL_LOAD(locGetShaderInfoLog_t, glGetShaderInfoLog);
+		use_program(program);
+		glUniform1i(glGetUniformLocation(program.id, "u_texture"), 0);
+		glUniform1f(program.alpha_cutoff, -1.0F);
 
 		return rge::OK;
 	}
 
-	texture* create_texture(int width, int height) override {
-		texture* t = new texture(width, height);
+	void use_program(const program& program) {
+		if(current_program == program.id) return;
+		current_program = program.id;
+		glUseProgram(program.id);
+	}
 
-		// TODO
+	// Copies data into the streaming buffer & returns its offset, or -1.
+	// Writes only go past the data already handed to GL, so no sync is
+	// needed; once full the buffer is orphaned & filled from the start.
+	GLintptr stream(const void* data, size_t size) {
+		glBindBuffer(GL_ARRAY_BUFFER, stream_buffer);
 
-		return t;
-	}
+		if(stream_offset + size > stream_capacity) {
+			while(stream_capacity < size) stream_capacity *= 2;
+			glBufferData(GL_ARRAY_BUFFER, stream_capacity, nullptr, GL_STREAM_DRAW);
+			stream_offset = 0;
+		}
 
-	void upload_texture(texture* texture) override {
-		// TODO
+		void* dest = glMapBufferRange(GL_ARRAY_BUFFER, stream_offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if(dest == nullptr) {
+			rge::log::error("Failed to map the streaming buffer.");
+			return -1;
+		}
+
+		memcpy(dest, data, size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+		GLintptr offset = (GLintptr)stream_offset;
+		stream_offset = (stream_offset + size + 15) & ~(size_t)15;
+		return offset;
 	}
 
-	void free_texture(texture* texture) override {
-		// TODO: Free GPU texture.
-		delete texture;
+	static mesh_vertex make_mesh_vertex(const std::vector<vec3>& vertices, const std::vector<vec3>& normals, const std::vector<vec2>& uvs, size_t v) {
+		mesh_vertex vertex;
+		vertex.x = vertices[v].x;
+		vertex.y = vertices[v].y;
+		vertex.z = vertices[v].z;
+		vertex.nx = v < normals.size() ? normals[v].x : 0.0F;
+		vertex.ny = v < normals.size() ? normals[v].y : 0.0F;
+		vertex.nz = v < normals.size() ? normals[v].z : 0.0F;
+		vertex.u = v < uvs.size() ? uvs[v].x : 0.0F;
+		vertex.v = v < uvs.size() ? 1.0F - uvs[v].y : 0.0F;
+		return vertex;
 	}
 
-	void clear(color background) override {
-		glClearColor(
-			float(background.r),
-			float(background.g),
-			float(background.b),
-			float(background.a)
-		);
+	void enable_mesh_attributes() {
+		glEnableVertexAttribArray(ATTRIB_POSITION);
+		glEnableVertexAttribArray(ATTRIB_NORMAL);
+		glEnableVertexAttribArray(ATTRIB_UV);
+	}
 
-		glClear(GL_COLOR_BUFFER_BIT);
-		glClear(GL_DEPTH_BUFFER_BIT);
+	// Points the mesh attributes of the bound vertex array at the bound buffer.
+	void set_mesh_attributes(GLintptr offset) {
+		glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(mesh_vertex), (const void*)(offset + offsetof(mesh_vertex, x)));
+		glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(mesh_vertex), (const void*)(offset + offsetof(mesh_vertex, nx)));
+		glVertexAttribPointer(ATTRIB_UV, 2, GL_FLOAT, GL_FALSE, sizeof(mesh_vertex), (const void*)(offset + offsetof(mesh_vertex, u)));
 	}
 
-	static void convert_matrix(GLfloat* gl, const mat4& m) {
-		for(int i = 0; i < 16; ++i) gl[i] = m.m[i % 4][i / 4];
+	// Sets the camera, model & material state for a mesh draw.
+	void bind_mesh_state(const mat4& local_to_world, const material& material) {
+		GLfloat gl_m[16];
+
+		flush_sprites();
+
+		use_program(mesh_program);
+
+		convert_matrix(gl_m, input_camera->get_projection_matrix() * input_camera->get_view_matrix());
+		glUniformMatrix4fv(mesh_program.view_projection, 1, GL_FALSE, gl_m);
+
+		convert_matrix(gl_m, local_to_world);
+		glUniformMatrix4fv(mesh_program.model, 1, GL_FALSE, gl_m);
+
+		GLfloat diffuse[4] = { material.diffuse.r, material.diffuse.g, material.diffuse.b, material.diffuse.a };
+		glUniform4fv(mesh_program.diffuse, 1, diffuse);
+
+		bool textured = material.texture != nullptr && material.texture->is_on_gpu();
+		glUniform1i(mesh_program.textured, textured ? 1 : 0);
+		if(textured) state.bind_texture(material.texture->handle);
+
+		state.set_enabled(GL_DEPTH_TEST, true);
+		state.depth_mask(true);
+
+		if(material.diffuse.a < 1.0F) {
+			state.set_enabled(GL_BLEND, true);
+			state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		} else {
+			state.set_enabled(GL_BLEND, false);
+		}
 	}
 
-	void display() override {
-		#ifdef SYS_WINDOWS
-		glFlush();
-		SwapBuffers(device);
-		// if(bSync) DwmFlush();
-		#endif
-		
-		#ifdef SYS_LINUX
-		
-		#endif
-		
-		#ifdef SYS_MACOSX
-		
-		#endif
+	static void set_quad_instance(quad_instance& instance, const vec3& origin, const vec3& right, const vec3& up, const color& tint, const vec2& uv_origin, const vec2& uv_opposite) {
+		instance.origin[0] = origin.x;
+		instance.origin[1] = origin.y;
+		instance.origin[2] = origin.z;
+		instance.right[0] = right.x;
+		instance.right[1] = right.y;
+		instance.right[2] = right.z;
+		instance.up[0] = up.x;
+		instance.up[1] = up.y;
+		instance.up[2] = up.z;
+		instance.color[0] = tint.r;
+		instance.color[1] = tint.g;
+		instance.color[2] = tint.b;
+		instance.color[3] = tint.a;
+		instance.uv_rect[0] = uv_origin.x;
+		instance.uv_rect[1] = uv_origin.y;
+		instance.uv_rect[2] = uv_opposite.x;
+		instance.uv_rect[3] = uv_opposite.y;
 	}
 
-	rge::result draw(
-		const mat4& local_to_world,
-		const std::vector<vec3>& vertices,
-		const std::vector<int>& triangles,
-		const std::vector<vec3>& normals,
-		const std::vector<vec2>& uvs,
-		const material& material
-	) override {
-		// TODO
+	// Draws count quad instances from the streaming buffer, with the quad
+	// program in use. No base instance in 3.3, the attributes move instead.
+	void draw_quads(GLintptr offset, GLsizei count, GLuint texture) {
+		glUniform1i(quad_program.textured, texture != 0 ? 1 : 0);
+		if(texture != 0) state.bind_texture(texture);
 
-		return rge::OK;
-	}
+		glBindVertexArray(quad_array);
+		glBindBuffer(GL_ARRAY_BUFFER, stream_buffer);
+		glVertexAttribPointer(ATTRIB_ORIGIN, 3, GL_FLOAT, GL_FALSE, sizeof(quad_instance), (const void*)(offset + offsetof(quad_instance, origin)));
+		glVertexAttribPointer(ATTRIB_RIGHT, 3, GL_FLOAT, GL_FALSE, sizeof(quad_instance), (const void*)(offset + offsetof(quad_instance, right)));
+		glVertexAttribPointer(ATTRIB_UP, 3, GL_FLOAT, GL_FALSE, sizeof(quad_instance), (const void*)(offset + offsetof(quad_instance, up)));
+		glVertexAttribPointer(ATTRIB_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(quad_instance), (const void*)(offset + offsetof(quad_instance, color)));
+		glVertexAttribPointer(ATTRIB_UV_RECT, 4, GL_FLOAT, GL_FALSE, sizeof(quad_instance), (const void*)(offset + offsetof(quad_instance, uv_rect)));
 
-	void draw(const sprite& sprite) override {
-		// TODO
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
 	}
 
-	void draw(const texture& texture, const rect& dest, const rect& src) override {
-		// TODO
+	static bool sprite_layer_before(const sprite_batch_item& a, const sprite_batch_item& b) {
+		return a.layer < b.layer;
 	}
 
-	void draw(
-		const texture& texture,
-		int dest_x,
-		int dest_y,
-		int dest_width,
-		int dest_height,
-		int src_x,
-		int src_y,
-		int src_width,
-		int src_height
-	) override {
-		// TODO
+	static bool sprite_texture_before(const sprite_batch_item& a, const sprite_batch_item& b) {
+		if(a.layer != b.layer) return a.layer < b.layer;
+		return a.texture_handle < b.texture_handle;
 	}
 
-	bool on_window_resized(const window_resized_event& e) override {
-		window_width = e.width;
-		window_height = e.height;
-		glViewport(0, 0, window_width, window_height);
-		return false; // Do not consume event. Let it propagate through higher layers.
+	// Streams the queued sprites in one go, then draws one instanced call
+	// per run of sprites sharing a texture.
+	void flush_sprites() {
+		if(sprite_batch.empty()) return;
+
+		GLfloat gl_m[16];
+
+		// Stable, so sprites keep submission order within a layer (and texture).
+		std::stable_sort(sprite_batch.begin(), sprite_batch.end(), sprite_sort_by_texture ? sprite_texture_before : sprite_layer_before);
+
+		quad_instances.resize(sprite_batch.size());
+		for(size_t i = 0; i < sprite_batch.size(); i++)
+			quad_instances[i] = sprite_batch[i].instance;
+
+		GLintptr offset = stream(quad_instances.data(), quad_instances.size() * sizeof(quad_instance));
+
+		if(offset >= 0) {
+			use_program(quad_program);
+			convert_matrix(gl_m, sprite_batch_camera->get_projection_matrix() * sprite_batch_camera->get_view_matrix());
+			glUniformMatrix4fv(quad_program.view_projection, 1, GL_FALSE, gl_m);
+			glUniform1f(quad_program.alpha_cutoff, -1.0F);
+
+			state.set_enabled(GL_DEPTH_TEST, true);
+			state.depth_mask(true);
+			state.set_enabled(GL_BLEND, true);
+			state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+			size_t first = 0;
+			while(first < sprite_batch.size()) {
+				GLuint texture = sprite_batch[first].texture_handle;
+
+				size_t last = first + 1;
+				while(last < sprite_batch.size() && sprite_batch[last].texture_handle == texture) last++;
+
+				draw_quads(offset + (GLintptr)(first * sizeof(quad_instance)), (GLsizei)(last - first), texture);
+				first = last;
+			}
+		}
+
+		sprite_batch.clear();
+		sprite_batch_camera = nullptr;
 	}
 };
+
+const char* const opengl_3_3::MESH_VERTEX_SHADER =
+	"#version 330 core\n"
+	"layout(location = 0) in vec3 a_position;\n"
+	"layout(location = 1) in vec3 a_normal;\n"
+	"layout(location = 2) in vec2 a_uv;\n"
+	"uniform mat4 u_view_projection;\n"
+	"uniform mat4 u_model;\n"
+	"uniform vec4 u_diffuse;\n"
+	"out vec2 v_uv;\n"
+	"out vec4 v_color;\n"
+	"void main() {\n"
+	"	v_uv = a_uv;\n"
+	"	v_color = u_diffuse;\n"
+	"	gl_Position = u_view_projection * u_model * vec4(a_position, 1.0);\n"
+	"}\n";
+
+const char* const opengl_3_3::QUAD_VERTEX_SHADER =
+	"#version 330 core\n"
+	"layout(location = 0) in vec3 i_origin;\n"
+	"layout(location = 1) in vec3 i_right;\n"
+	"layout(location = 2) in vec3 i_up;\n"
+	"layout(location = 3) in vec4 i_color;\n"
+	"layout(location = 4) in vec4 i_uv_rect;\n"
+	"uniform mat4 u_view_projection;\n"
+	"out vec2 v_uv;\n"
+	"out vec4 v_color;\n"
+	"void main() {\n"
+	"	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+	"	v_uv = mix(i_uv_rect.xy, i_uv_rect.zw, corner);\n"
+	"	v_color = i_color;\n"
+	"	gl_Position = u_view_projection * vec4(i_origin + i_right * corner.x + i_up * corner.y, 1.0);\n"
+	"}\n";
+
+const char* const opengl_3_3::FRAGMENT_SHADER =
+	"#version 330 core\n"
+	"in vec2 v_uv;\n"
+	"in vec4 v_color;\n"
+	"uniform sampler2D u_texture;\n"
+	"uniform bool u_textured;\n"
+	"uniform float u_alpha_cutoff;\n"
+	"out vec4 o_color;\n"
+	"void main() {\n"
+	"	vec4 color = v_color;\n"
+	"	if(u_textured) color *= texture(u_texture, v_uv);\n"
+	"	if(color.a <= u_alpha_cutoff) discard;\n"
+	"	o_color = color;\n"
+	"}\n";
 #endif /* SYS_OPENGL_3_3 */
 //********************************************//
 //* OpenGL 3.3 Renderer                      *//
@@ -5641,7 +11748,7 @@ void engine::configure() {
 	#endif
 
 	#ifdef SYS_LINUX
-	plaftrom_impl = new linux();
+	platform_impl = new linux();
 	#endif
 
 	#ifdef SYS_MACOSX
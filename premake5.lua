@@ -195,4 +195,263 @@ project "starship"
     
     filter "configurations:release"
 		kind "WindowedApp"
-        optimize "On"
\ No newline at end of file
+        optimize "On"
+
+------------------------------------------------------------------
+
+
+project "pak"
+    language "C++"
+    cppdialect "C++11"
+    location "tools/pak"
+    kind "ConsoleApp"
+
+    defines "SYS_OPENGL_1_0"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("tmp/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "include/rge.hpp",
+		"%{prj.location}/**.cpp",
+		"%{prj.location}/**.hpp",
+		"%{prj.location}/**.h"
+    }
+
+    includedirs {
+		"include/",
+		"vendor/",
+        "%{prj.location}/"
+    }
+	
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+	
+	filter "system:macosx"
+        buildoptions {
+            "-F /Library/Frameworks"
+        }
+        linkoptions {
+            "-F /Library/Frameworks",
+            "-framework Carbon",
+            "-framework GLUT",
+            "-framework OpenGL"
+        }
+	
+	filter "system:linux"
+		links {
+            "m"
+        }
+	
+    filter "configurations:debug"
+        symbols "On"
+    
+    filter "configurations:release"
+        optimize "On"
+
+
+------------------------------------------------------------------
+
+
+project "texconv"
+    language "C++"
+    cppdialect "C++11"
+    location "tools/texconv"
+    kind "ConsoleApp"
+
+    defines "SYS_OPENGL_1_0"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("tmp/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "include/rge.hpp",
+		"%{prj.location}/**.cpp",
+		"%{prj.location}/**.hpp",
+		"%{prj.location}/**.h"
+    }
+
+    includedirs {
+		"include/",
+		"vendor/",
+        "%{prj.location}/"
+    }
+	
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+	
+	filter "system:macosx"
+        buildoptions {
+            "-F /Library/Frameworks"
+        }
+        linkoptions {
+            "-F /Library/Frameworks",
+            "-framework Carbon",
+            "-framework GLUT",
+            "-framework OpenGL"
+        }
+	
+	filter "system:linux"
+		links {
+            "m"
+        }
+	
+    filter "configurations:debug"
+        symbols "On"
+    
+    filter "configurations:release"
+        optimize "On"
+
+
+------------------------------------------------------------------
+
+
+project "texbench"
+    language "C++"
+    cppdialect "C++11"
+    location "tools/texbench"
+    kind "ConsoleApp"
+
+    defines "SYS_SOFTWARE_GL"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("tmp/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "include/rge.hpp",
+		"%{prj.location}/**.cpp",
+		"%{prj.location}/**.hpp",
+		"%{prj.location}/**.h"
+    }
+
+    includedirs {
+		"include/",
+		"vendor/",
+        "%{prj.location}/"
+    }
+	
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+	
+	filter "system:macosx"
+        buildoptions {
+            "-F /Library/Frameworks"
+        }
+        linkoptions {
+            "-F /Library/Frameworks",
+            "-framework Carbon",
+            "-framework GLUT",
+            "-framework OpenGL"
+        }
+	
+	filter "system:linux"
+		links {
+            "m"
+        }
+	
+    filter "configurations:debug"
+        symbols "On"
+    
+    filter "configurations:release"
+        optimize "On"
+
+
+------------------------------------------------------------------
+
+
+project "goldens"
+    language "C++"
+    cppdialect "C++11"
+    location "tools/goldens"
+    kind "ConsoleApp"
+
+    defines "SYS_SOFTWARE_GL"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("tmp/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "include/rge.hpp",
+		"%{prj.location}/**.cpp",
+		"%{prj.location}/**.hpp",
+		"%{prj.location}/**.h"
+    }
+
+    includedirs {
+		"include/",
+		"vendor/",
+        "%{prj.location}/"
+    }
+	
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+	
+	filter "system:macosx"
+        buildoptions {
+            "-F /Library/Frameworks"
+        }
+        linkoptions {
+            "-F /Library/Frameworks",
+            "-framework Carbon",
+            "-framework GLUT",
+            "-framework OpenGL"
+        }
+	
+	filter "system:linux"
+		links {
+            "m"
+        }
+	
+    filter "configurations:debug"
+        symbols "On"
+    
+    filter "configurations:release"
+        optimize "On"
+
+
+------------------------------------------------------------------
+
+
+-- Headless check of the GL renderers through EGL, linux only.
+if os.istarget("linux") then
+project "glcheck"
+    language "C++"
+    cppdialect "C++11"
+    location "tools/glcheck"
+    kind "ConsoleApp"
+
+    defines "SYS_OPENGL_3_3"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("tmp/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "include/rge.hpp",
+		"%{prj.location}/**.cpp",
+		"%{prj.location}/**.hpp",
+		"%{prj.location}/**.h"
+    }
+
+    includedirs {
+		"include/",
+		"vendor/",
+        "%{prj.location}/"
+    }
+
+	links {
+        "m",
+        "EGL",
+        "GL",
+        "pthread"
+    }
+	
+    filter "configurations:debug"
+        symbols "On"
+    
+    filter "configurations:release"
+        optimize "On"
+end
@@ -0,0 +1,312 @@
+#include <EGL/egl.h>
+
+#define RGE_IMPL
+#define RGE_USE_STB_IMAGE
+#define RGE_USE_STB_IMAGE_WRITE
+#include "rge.hpp"
+
+#include <iostream>
+#include <chrono>
+
+// Checks a GL renderer without a window, on an EGL pbuffer. Runs on any
+// linux box with Mesa, llvmpipe included.
+#ifndef SYS_LINUX
+#error "glcheck needs EGL, linux only."
+#endif
+
+#if defined(SYS_OPENGL_3_3)
+typedef rge::opengl_3_3 gl_renderer;
+#elif defined(SYS_OPENGL_1_0)
+typedef rge::opengl_1_0 gl_renderer;
+#else
+#error "glcheck checks SYS_OPENGL_1_0 or SYS_OPENGL_3_3."
+#endif
+
+// Size of the pbuffer drawn to.
+static const int SCREEN_WIDTH = 320;
+static const int SCREEN_HEIGHT = 240;
+
+static void print_usage() {
+	std::cout << "Usage: glcheck [-n <frames>] [-s <sprites>] [-a <examples dir>] [-o <image.png>]" << std::endl;
+	std::cout << std::endl;
+	std::cout << "  -n  Frames rendered per test (default: 10)." << std::endl;
+	std::cout << "  -s  Sprites drawn per frame by the batching test, 0 skips it (default: 10000)." << std::endl;
+	std::cout << "  -a  Directory of the examples, for their assets (default: ../../examples)." << std::endl;
+	std::cout << "  -o  Where the frame of the scene test is written (default: glcheck.png)." << std::endl;
+}
+
+// Makes a pbuffer & a context current on it. A core 3.3 context for the
+// 3.3 renderer, the default compatibility one for 1.0.
+static bool create_context() {
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+		// No display server, Mesa can still render surfaceless.
+		typedef EGLDisplay (*get_platform_display_t)(EGLenum platform, void* native_display, const EGLint* attributes);
+		get_platform_display_t get_platform_display = (get_platform_display_t)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		const EGLenum PLATFORM_SURFACELESS_MESA = 0x31DD;
+
+		display = get_platform_display != nullptr ? get_platform_display(PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr) : EGL_NO_DISPLAY;
+		if(display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+			rge::log::error("No EGL display.");
+			return false;
+		}
+	}
+
+	const EGLint config_attributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint config_count = 0;
+	if(!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count < 1) {
+		rge::log::error("No EGL config with an 8 bit color & 24 bit depth pbuffer.");
+		return false;
+	}
+
+	const EGLint surface_attributes[] = { EGL_WIDTH, SCREEN_WIDTH, EGL_HEIGHT, SCREEN_HEIGHT, EGL_NONE };
+	EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attributes);
+	if(surface == EGL_NO_SURFACE || !eglBindAPI(EGL_OPENGL_API)) {
+		rge::log::error("No EGL pbuffer surface.");
+		return false;
+	}
+
+	#ifdef SYS_OPENGL_3_3
+	const EGLint context_attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	#else
+	const EGLint context_attributes[] = { EGL_NONE };
+	#endif
+
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+	if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+		rge::log::error("No EGL OpenGL context.");
+		return false;
+	}
+
+	return true;
+}
+
+// Returns true if GL reported no error since the last call.
+static bool check_gl_errors(const char* test) {
+	bool ok = true;
+	for(GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError()) {
+		rge::log::error("%s: GL error 0x%x.", test, error);
+		ok = false;
+	}
+	return ok;
+}
+
+// Writes the pbuffer, bottom row last like the texture files.
+static bool write_frame(const std::string& path) {
+	std::vector<uint8_t> buffer(SCREEN_WIDTH * SCREEN_HEIGHT * 4);
+	glReadPixels(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+
+	stbi_flip_vertically_on_write(1);
+	if(!stbi_write_png(path.c_str(), SCREEN_WIDTH, SCREEN_HEIGHT, 4, buffer.data(), SCREEN_WIDTH * 4)) {
+		rge::log::error("Could not write: %s", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+static rge::mesh::ptr load_triangle() {
+	rge::mesh::ptr mdl = rge::mesh::create();
+
+	mdl->vertices.push_back(rge::vec3(-1, -1, 0));
+	mdl->vertices.push_back(rge::vec3(0, 1, 0));
+	mdl->vertices.push_back(rge::vec3(1, -1, 0));
+
+	mdl->normals.push_back(rge::vec3(0, 0, 1));
+	mdl->normals.push_back(rge::vec3(0, 0, 1));
+	mdl->normals.push_back(rge::vec3(0, 0, 1));
+
+	mdl->triangles.push_back(0);
+	mdl->triangles.push_back(2);
+	mdl->triangles.push_back(1);
+
+	mdl->uvs.push_back(rge::vec2(0, 0));
+	mdl->uvs.push_back(rge::vec2(0.5F, 1.0F));
+	mdl->uvs.push_back(rge::vec2(1, 0));
+
+	return mdl;
+}
+
+static rge::mesh::ptr load_floor() {
+	rge::mesh::ptr mdl = rge::mesh::create();
+
+	mdl->vertices.push_back(rge::vec3(-10, 0, -10));
+	mdl->vertices.push_back(rge::vec3(10, 0, -10));
+	mdl->vertices.push_back(rge::vec3(10, 0, 10));
+	mdl->vertices.push_back(rge::vec3(-10, 0, 10));
+
+	mdl->normals.push_back(rge::vec3(0, 1, 0));
+	mdl->normals.push_back(rge::vec3(0, 1, 0));
+	mdl->normals.push_back(rge::vec3(0, 1, 0));
+	mdl->normals.push_back(rge::vec3(0, 1, 0));
+
+	mdl->triangles.push_back(0);
+	mdl->triangles.push_back(1);
+	mdl->triangles.push_back(3);
+	mdl->triangles.push_back(2);
+	mdl->triangles.push_back(3);
+	mdl->triangles.push_back(1);
+
+	mdl->uvs.push_back(rge::vec2(0, 0));
+	mdl->uvs.push_back(rge::vec2(1, 0));
+	mdl->uvs.push_back(rge::vec2(1, 1));
+	mdl->uvs.push_back(rge::vec2(0, 1));
+
+	return mdl;
+}
+
+int main(int argc, char** argv) {
+	int frames = 10;
+	int sprite_count = 10000;
+	std::string root = "../../examples";
+	std::string output = "glcheck.png";
+
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if(arg == "-n" && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		} else if(arg == "-s" && i + 1 < argc) {
+			sprite_count = atoi(argv[++i]);
+		} else if(arg == "-a" && i + 1 < argc) {
+			root = argv[++i];
+		} else if(arg == "-o" && i + 1 < argc) {
+			output = argv[++i];
+		} else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	if(frames < 1 || sprite_count < 0) {
+		print_usage();
+		return 1;
+	}
+
+	if(!create_context()) return 1;
+	rge::log::info("%s, %s", (const char*)glGetString(GL_VERSION), (const char*)glGetString(GL_RENDERER));
+
+	gl_renderer renderer;
+	if(renderer.init(nullptr) != rge::OK) return 1;
+
+	// Draws through the base class, the renderer's own draw overloads hide the mesh one.
+	rge::renderer& base = renderer;
+
+	rge::window_resized_event resized;
+	resized.width = SCREEN_WIDTH;
+	resized.height = SCREEN_HEIGHT;
+	renderer.on_window_resized(resized);
+
+	rge::texture::ptr floor = rge::texture::load(root + "/3d/floor.png", false);
+	rge::texture::ptr ship = rge::texture::load(root + "/starship/res/spaceship_0.png", false);
+	rge::texture::ptr title = rge::texture::load(root + "/starship/res/title.png", false);
+	if(floor == nullptr || ship == nullptr || title == nullptr) return 1;
+
+	floor->filter = rge::texture_filter::BILINEAR;
+	renderer.upload_texture(*floor);
+	renderer.upload_texture(*ship);
+	renderer.upload_texture(*title);
+
+	rge::camera::ptr perspective_camera = rge::camera::create();
+	perspective_camera->set_perspective(60, 1.33F, 0.1F, 1000.0F);
+	perspective_camera->transform->position = rge::vec3(0, 1, 0);
+
+	rge::camera::ptr ortho_camera = rge::camera::create();
+	ortho_camera->set_orthographic(-8, 8, 6, -6, 0.0F, 100.0F);
+	ortho_camera->transform->position = rge::vec3(0, 0, -1);
+
+	rge::material::ptr material = rge::material::create();
+	material->texture = floor;
+
+	// The floor is compiled on gpu, the triangles stream every draw.
+	rge::mesh::ptr triangle = load_triangle();
+	rge::mesh::ptr floor_mesh = load_floor();
+	renderer.upload_mesh(*floor_mesh);
+
+	std::vector<rge::sprite::ptr> ships;
+	for(int i = 0; i < 5; i++) {
+		rge::sprite::ptr sprite = rge::sprite::create(ship);
+		sprite->pixels_per_unit = 16;
+		sprite->centered = true;
+		sprite->transform->position = rge::vec3(-6.0F + i * 3.0F, -3, 0);
+		sprite->transform->rotation = rge::quaternion::yaw_pitch_roll(0, 0, i * 0.25F);
+		ships.push_back(sprite);
+	}
+
+	bool ok = check_gl_errors("init");
+
+	// Every draw path: uploaded & streamed meshes, sprites, then blits in each mode.
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for(int frame = 0; frame < frames; frame++) {
+		base.set_camera(perspective_camera);
+		base.clear(rge::color(0.8F, 0.4F, 0.4F));
+		base.draw(rge::mat4::identity(), *floor_mesh, *material);
+		for(int i = 0; i < 10; i++) {
+			base.draw(rge::mat4::trs(rge::vec3(i - 5.0F, 1, 5), rge::quaternion::yaw_pitch_roll(0.7F, 0, 0), rge::vec3(1, 1, 1)), *triangle, *material);
+		}
+
+		base.set_camera(ortho_camera);
+		for(size_t i = 0; i < ships.size(); i++) base.draw(*ships[i]);
+
+		base.set_blit_mode(rge::blit_mode::ALPHA_BLEND);
+		base.draw(*ship, 10, 10, 42, 42);
+		base.set_blit_mode(rge::blit_mode::COLOR_KEY);
+		base.draw(*ship, 50, 10, 82, 42);
+		base.set_blit_mode(rge::blit_mode::COPY);
+		base.draw(*title, 100, 200, 200, 230, 0, 0, title->get_width() / 2, title->get_height());
+
+		base.display();
+		glFinish();
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	const rge::gl_state_cache::stats& stats = renderer.get_state_stats();
+	rge::log::info("scene: %.2f ms per frame, %u state changes issued, %u skipped", elapsed.count() / frames, stats.issued, stats.skipped);
+	ok = check_gl_errors("scene") && ok;
+	ok = write_frame(output) && ok;
+
+	// Sprites over two textures, batched per layer, then sorted by texture too.
+	if(sprite_count > 0) {
+		std::vector<rge::sprite::ptr> sprites;
+		for(int i = 0; i < sprite_count; i++) {
+			rge::sprite::ptr sprite = rge::sprite::create(i % 2 == 0 ? ship : title);
+			sprite->pixels_per_unit = 64;
+			sprite->centered = true;
+			sprite->transform->position = rge::vec3((i * 37 % 160) / 10.0F - 8.0F, (i * 53 % 120) / 10.0F - 6.0F, -(i % 7) * 0.1F);
+			sprites.push_back(sprite);
+		}
+
+		base.set_camera(ortho_camera);
+		for(int sort = 0; sort < 2; sort++) {
+			base.set_sprite_sort_by_texture(sort == 1);
+
+			start = std::chrono::high_resolution_clock::now();
+			for(int frame = 0; frame < frames; frame++) {
+				base.clear(rge::color(0, 0, 0));
+				for(size_t i = 0; i < sprites.size(); i++) base.draw(*sprites[i]);
+				base.display();
+				glFinish();
+			}
+			elapsed = std::chrono::high_resolution_clock::now() - start;
+
+			rge::log::info("%d sprites%s: %.2f ms per frame", sprite_count, sort == 1 ? " sorted by texture" : "", elapsed.count() / frames);
+		}
+		ok = check_gl_errors("sprites") && ok;
+	}
+
+	return ok ? 0 : 1;
+}
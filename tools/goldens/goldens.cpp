@@ -0,0 +1,571 @@
+#define RGE_IMPL
+#define RGE_USE_STB_IMAGE
+#define RGE_USE_STB_IMAGE_WRITE
+#include "rge.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+
+// Size of the offscreen target every scene is rendered to, same as the examples' window.
+static const int SCREEN_WIDTH = 800;
+static const int SCREEN_HEIGHT = 600;
+
+static void print_usage() {
+	std::cout << "Usage: goldens [-u] [-n <frames>] [-t <tolerance>] [-p <percent>] [-a <examples dir>] [-d <goldens dir>] [scene...]" << std::endl;
+	std::cout << std::endl;
+	std::cout << "  -u  Records the rendered scenes as the new goldens." << std::endl;
+	std::cout << "  -n  Frames rendered per scene, for the frame time (default: 10)." << std::endl;
+	std::cout << "  -t  Largest perceived difference of a pixel, from 0 to 255 (default: 8)." << std::endl;
+	std::cout << "  -p  Percent of pixels allowed past the tolerance (default: 0.1)." << std::endl;
+	std::cout << "  -a  Directory of the examples, for their assets (default: ../../examples)." << std::endl;
+	std::cout << "  -d  Directory of the goldens & failure diffs (default: images)." << std::endl;
+	std::cout << std::endl;
+	std::cout << "Scenes without a golden fail, until recorded with -u. Failing scenes write <scene>_diff.png & <scene>_out.png." << std::endl;
+}
+
+static rge::mesh::ptr load_triangle() {
+	rge::mesh::ptr mdl = rge::mesh::create();
+
+	mdl->vertices.push_back(rge::vec3(-1, -1, 0));
+	mdl->vertices.push_back(rge::vec3(0, 1, 0));
+	mdl->vertices.push_back(rge::vec3(1, -1, 0));
+
+	mdl->normals.push_back(rge::vec3(0, 0, 1));
+	mdl->normals.push_back(rge::vec3(0, 0, 1));
+	mdl->normals.push_back(rge::vec3(0, 0, 1));
+
+	mdl->triangles.push_back(0);
+	mdl->triangles.push_back(2);
+	mdl->triangles.push_back(1);
+
+	mdl->uvs.push_back(rge::vec2(0, 0));
+	mdl->uvs.push_back(rge::vec2(0.5F, 1.0F));
+	mdl->uvs.push_back(rge::vec2(1, 0));
+
+	return mdl;
+}
+
+static rge::mesh::ptr load_floor() {
+	rge::mesh::ptr mdl = rge::mesh::create();
+
+	mdl->vertices.push_back(rge::vec3(-10, 0, -10));
+	mdl->vertices.push_back(rge::vec3(10, 0, -10));
+	mdl->vertices.push_back(rge::vec3(10, 0, 10));
+	mdl->vertices.push_back(rge::vec3(-10, 0, 10));
+
+	mdl->normals.push_back(rge::vec3(0, 1, 0));
+	mdl->normals.push_back(rge::vec3(0, 1, 0));
+	mdl->normals.push_back(rge::vec3(0, 1, 0));
+	mdl->normals.push_back(rge::vec3(0, 1, 0));
+
+	mdl->triangles.push_back(0);
+	mdl->triangles.push_back(1);
+	mdl->triangles.push_back(3);
+	mdl->triangles.push_back(2);
+	mdl->triangles.push_back(3);
+	mdl->triangles.push_back(1);
+
+	mdl->uvs.push_back(rge::vec2(0, 0));
+	mdl->uvs.push_back(rge::vec2(1, 0));
+	mdl->uvs.push_back(rge::vec2(1, 1));
+	mdl->uvs.push_back(rge::vec2(0, 1));
+
+	return mdl;
+}
+
+static rge::sprite::ptr create_sprite(rge::texture::ptr texture, bool centered, const rge::vec3& position) {
+	rge::sprite::ptr sprite = rge::sprite::create();
+	sprite->texture = texture;
+	sprite->pixels_per_unit = 16;
+	sprite->centered = centered;
+	sprite->transform->position = position;
+	return sprite;
+}
+
+// Everything the scenes draw, loaded once from the examples.
+struct assets {
+	rge::camera::ptr ortho_camera;
+	rge::camera::ptr perspective_camera;
+	// A near plane past 0, so deferred shading can recover positions from depth.
+	rge::camera::ptr material_camera;
+	rge::mesh::ptr triangle;
+	rge::mesh::ptr floor;
+
+	rge::sprite::ptr background_2d;
+	rge::sprite::ptr smile;
+	rge::material::ptr smile_material;
+
+	rge::material::ptr floor_material;
+
+	// One per raster mode & shading model, side by side.
+	rge::material::ptr materials[6];
+	rge::light::ptr lamp;
+
+	rge::sprite::ptr title;
+	rge::sprite::ptr press_key;
+	rge::sprite::ptr background_0;
+	rge::sprite::ptr background_1;
+	rge::sprite::ptr asteroids[3];
+	rge::sprite::ptr lasers[2];
+	rge::sprite::ptr ship;
+	rge::sprite::ptr flame;
+	rge::sprite::ptr health_on;
+	rge::sprite::ptr health_off;
+};
+
+static bool load_assets(const std::string& root, assets& a) {
+	a.ortho_camera = rge::camera::create();
+	a.ortho_camera->set_orthographic(-8, 8, 6, -6, 0.0F, 100.0F);
+	a.ortho_camera->transform->position = rge::vec3(0, 0, -1);
+
+	a.perspective_camera = rge::camera::create();
+	a.perspective_camera->set_perspective(60, 1.6F, 0.0F, 1000.0F);
+	a.perspective_camera->transform->position = rge::vec3(0, 1, 0);
+
+	a.material_camera = rge::camera::create();
+	a.material_camera->set_perspective(60, 1.6F, 0.1F, 100.0F);
+	a.material_camera->transform->position = rge::vec3(0, 1.5F, 0);
+
+	a.triangle = load_triangle();
+	a.floor = load_floor();
+
+	// 2D example.
+	rge::texture::ptr smile = rge::texture::load(root + "/2d/smile.bmp", false);
+	rge::texture::ptr background_2d = rge::texture::load(root + "/2d/background.png", false);
+
+	// 3D example.
+	rge::texture::ptr floor = rge::texture::load(root + "/3d/floor.png", false);
+
+	// Starship example.
+	std::string res = root + "/starship/res/";
+	rge::texture::ptr title = rge::texture::load(res + "title.png", false);
+	rge::texture::ptr press_key = rge::texture::load(res + "press_any_key_to_start.png", false);
+	rge::texture::ptr background = rge::texture::load(res + "background.png", false);
+	rge::texture::ptr asteroids[3] = {
+		rge::texture::load(res + "asteroid_0.png", false),
+		rge::texture::load(res + "asteroid_1.png", false),
+		rge::texture::load(res + "asteroid_2.png", false)
+	};
+	rge::texture::ptr laser = rge::texture::load(res + "laser.png", false);
+	rge::texture::ptr ship = rge::texture::load(res + "spaceship_0.png", false);
+	rge::texture::ptr flame = rge::texture::load(res + "flame_2.png", false);
+	rge::texture::ptr health_on = rge::texture::load(res + "health_point_on.png", false);
+	rge::texture::ptr health_off = rge::texture::load(res + "health_point_off.png", false);
+
+	if(smile == nullptr || background_2d == nullptr || floor == nullptr || title == nullptr || press_key == nullptr ||
+	   background == nullptr || asteroids[0] == nullptr || asteroids[1] == nullptr || asteroids[2] == nullptr ||
+	   laser == nullptr || ship == nullptr || flame == nullptr || health_on == nullptr || health_off == nullptr) {
+		return false;
+	}
+
+	a.background_2d = create_sprite(background_2d, false, rge::vec3(0, 0, 1));
+	a.smile = create_sprite(smile, true, rge::vec3());
+	a.smile->material = rge::material::create();
+	a.smile->material->diffuse = rge::color(1, 0, 1, 0.5F);
+
+	a.smile_material = rge::material::create();
+	a.smile_material->diffuse = rge::color(1, 0, 1);
+	a.smile_material->texture = smile;
+
+	floor->filter = rge::texture_filter::TRILINEAR;
+	floor->generate_mipmaps();
+	floor->set_layout(rge::texture_layout::TILED);
+	a.floor_material = rge::material::create();
+	a.floor_material->texture = floor;
+
+	for(int i = 0; i < 6; i++) {
+		a.materials[i] = rge::material::create();
+		a.materials[i]->texture = floor;
+	}
+	a.materials[1]->raster = rge::raster_mode::AFFINE;
+	a.materials[2]->raster = rge::raster_mode::FLAT;
+	a.materials[3]->shading = rge::shading_model::VERTEX_LIT;
+	a.materials[4]->shading = rge::shading_model::UNLIT;
+	a.materials[5]->texture = asteroids[0];
+	a.materials[5]->alpha_cutoff = 0.5F;
+
+	a.lamp = rge::light::create();
+	a.lamp->transform = rge::transform::create();
+	a.lamp->transform->position = rge::vec3(0, 2, -5);
+	a.lamp->tint = rge::color(1.0F, 0.9F, 0.7F);
+	a.lamp->intensity = 2.0F;
+
+	// Layers, from the starship's game.hpp.
+	const float BACKGROUND_LAYER = -1.0F;
+	const float SPACESHIP_LAYER = 0.0F;
+	const float ASTEROID_LAYER = 0.5F;
+	const float LASER_LAYER = 0.75F;
+	const float UI_LAYER = 0.9F;
+
+	a.title = create_sprite(title, true, rge::vec3(0, 0, -UI_LAYER));
+	a.press_key = create_sprite(press_key, true, rge::vec3(0, -4, -UI_LAYER));
+	a.background_0 = create_sprite(background, false, rge::vec3(-8, rge::math::lerp(6, -18, 0.1F), -BACKGROUND_LAYER));
+	a.background_1 = create_sprite(background, false, rge::vec3(-8, rge::math::lerp(6, -18, 0.6F), -BACKGROUND_LAYER));
+
+	const rge::vec3 asteroid_positions[3] = { rge::vec3(-4.5F, 3.0F, -ASTEROID_LAYER), rge::vec3(2.0F, 1.5F, -ASTEROID_LAYER), rge::vec3(5.5F, -2.5F, -ASTEROID_LAYER) };
+	for(int i = 0; i < 3; i++) {
+		a.asteroids[i] = create_sprite(asteroids[i], true, asteroid_positions[i]);
+		a.asteroids[i]->transform->rotation = rge::quaternion::yaw_pitch_roll(0, 0, 0.7F * (i + 1));
+	}
+
+	a.lasers[0] = create_sprite(laser, false, rge::vec3(-0.5F, 0.5F, -LASER_LAYER));
+	a.lasers[1] = create_sprite(laser, false, rge::vec3(0.25F, 2.0F, -LASER_LAYER));
+
+	a.ship = create_sprite(ship, true, rge::vec3(0, -2, -SPACESHIP_LAYER));
+	a.flame = create_sprite(flame, false, rge::vec3(-0.125F, -3.0F, -SPACESHIP_LAYER));
+	a.health_on = create_sprite(health_on, false, rge::vec3());
+	a.health_off = create_sprite(health_off, false, rge::vec3());
+
+	return true;
+}
+
+// The 2d example, at a point of its smile's orbit.
+static void render_2d(rge::renderer& renderer, const assets& a, float time) {
+	renderer.set_camera(a.ortho_camera);
+	renderer.set_ambience(rge::color(0.2F, 0.2F, 0.2F));
+	renderer.clear(rge::color(0.8F, 0.4F, 0.4F));
+
+	a.smile->transform->position = rge::vec3(cosf(time) * 3.0F, sinf(time) * 3.0F, 0.0F);
+	a.smile->transform->rotation = rge::quaternion::yaw_pitch_roll(0, 0, -time);
+
+	renderer.draw(*a.background_2d);
+	renderer.draw(*a.smile);
+	renderer.draw(rge::mat4::trs(rge::vec3(0, 0, 0), rge::quaternion::yaw_pitch_roll(time, 0, 0), rge::vec3(1, 1, 1)), *a.triangle, *a.smile_material);
+	renderer.draw(*a.smile_material->texture, rge::vec2(0.0F, 0.0F), rge::vec2(0.5F, 0.25F), rge::vec2(0.0F, 0.0F), rge::vec2(1.0F, 1.0F));
+}
+
+// The 3d example, looking down the floor with the camera turned by time.
+static void render_3d(rge::renderer& renderer, const assets& a, float time) {
+	float r = time * 30.0F;
+	a.perspective_camera->transform->rotation = rge::quaternion::look(rge::vec3(sinf(r * DEG_2_RAD), 0, cosf(r * DEG_2_RAD)), rge::vec3(0, 1, 0));
+
+	renderer.set_camera(a.perspective_camera);
+	renderer.set_ambience(rge::color(0.2F, 0.2F, 0.2F));
+	renderer.clear(rge::color(0.8F, 0.4F, 0.4F));
+
+	renderer.draw(rge::mat4::identity(), *a.floor, *a.floor_material);
+	renderer.draw(rge::mat4::trs(rge::vec3(0, 1, 5), rge::quaternion::yaw_pitch_roll(time, 0, 0), rge::vec3(1, 1, 1)), *a.triangle, *a.floor_material);
+}
+
+// A lit row of triangles, one per material variant: Blinn-Phong,
+// affine & flat spans, vertex lit, unlit & alpha tested.
+static void render_3d_materials(rge::renderer& renderer, const assets& a, float time) {
+	renderer.set_camera(a.material_camera);
+	renderer.set_ambience(rge::color(0.2F, 0.2F, 0.2F));
+	renderer.add_light(a.lamp);
+	renderer.clear(rge::color(0.8F, 0.4F, 0.4F));
+
+	for(int i = 0; i < 6; i++) {
+		rge::vec3 position = rge::vec3(-2.25F + i * 0.9F, 1, -8);
+		renderer.draw(rge::mat4::trs(position, rge::quaternion::yaw_pitch_roll(0.6F + time, 0, 0), rge::vec3(0.4F, 0.4F, 0.4F)), *a.triangle, *a.materials[i]);
+	}
+}
+
+// The starship's main menu.
+static void render_starship_menu(rge::renderer& renderer, const assets& a, float) {
+	renderer.set_camera(a.ortho_camera);
+	renderer.clear(rge::color(0.2F, 0.2F, 0.2F));
+
+	renderer.draw(*a.title);
+	renderer.draw(*a.press_key);
+}
+
+// The starship mid game, the ship shooting through a few asteroids.
+static void render_starship_game(rge::renderer& renderer, const assets& a, float) {
+	renderer.set_camera(a.ortho_camera);
+	renderer.clear(rge::color(0.2F, 0.2F, 0.2F));
+
+	renderer.draw(*a.background_0);
+	renderer.draw(*a.background_1);
+
+	for(int i = 0; i < 3; i++) renderer.draw(*a.asteroids[i]);
+	for(int i = 0; i < 2; i++) renderer.draw(*a.lasers[i]);
+
+	renderer.draw(*a.flame);
+	renderer.draw(*a.ship);
+
+	for(int i = 0; i < 8; i++) {
+		rge::sprite& health = i < 5 ? *a.health_on : *a.health_off;
+		health.transform->position = rge::vec3(-7.5F + (i * 0.25F), -5.5F, -0.9F);
+		renderer.draw(health);
+	}
+}
+
+typedef void (*render_func)(rge::renderer&, const assets&, float);
+
+// Switches the renderer to the mode a scene is checked under. Every mode is
+// switched back off after the scene, see reset_modes().
+typedef void (*mode_func)(rge::software_gl&);
+
+static void depth_prepass(rge::software_gl& renderer) {
+	renderer.set_depth_prepass(true);
+}
+
+static void deferred_shading(rge::software_gl& renderer) {
+	renderer.set_deferred_shading(true);
+}
+
+static void lazy_clear(rge::software_gl& renderer) {
+	renderer.set_lazy_clear(true);
+}
+
+// A quarter of the window, upscaled to it at present.
+static void virtual_resolution(rge::software_gl& renderer) {
+	renderer.set_virtual_resolution(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 4);
+}
+
+static void post_processes(rge::software_gl& renderer) {
+	std::vector<rge::color> colors;
+	colors.push_back(rge::color(0.05F, 0.05F, 0.1F));
+	colors.push_back(rge::color(0.35F, 0.3F, 0.4F));
+	colors.push_back(rge::color(0.8F, 0.5F, 0.3F));
+	colors.push_back(rge::color(0.95F, 0.95F, 0.85F));
+
+	renderer.add_post_process(rge::palette_pass::create(rge::palette::create(colors), 0.5F));
+	renderer.add_post_process(rge::scanline_pass::create());
+	renderer.add_post_process(rge::crt_pass::create());
+}
+
+static void reset_modes(rge::software_gl& renderer) {
+	renderer.set_depth_prepass(false);
+	renderer.set_deferred_shading(false);
+	renderer.set_lazy_clear(false);
+	renderer.set_virtual_resolution(0, 0);
+	renderer.clear_post_processes();
+	renderer.clear_lights();
+}
+
+struct scene {
+	const char* name;
+	render_func render;
+	float time;
+	mode_func mode;
+	// Drawn to the window & displayed, for the modes applied at display.
+	// Only sprites are drawn to the window.
+	bool window;
+};
+
+// Goldens are stored as png, a fraction of the engine's 32 bit bitmaps.
+// Frames are bottom row first, images top row first, so rows are flipped.
+static bool write_png(const rge::texture& texture, const std::string& path) {
+	std::vector<uint8_t> buffer(texture.get_width() * texture.get_height() * 4);
+	texture.dump_to_raw_buffer(buffer.data());
+
+	stbi_flip_vertically_on_write(1);
+	if(!stbi_write_png(path.c_str(), texture.get_width(), texture.get_height(), 4, buffer.data(), texture.get_width() * 4)) {
+		rge::log::error("Could not write: %s", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Returns a golden as a frame, bottom row first. Null if it can't be read.
+static rge::texture::ptr load_png(const std::string& path) {
+	std::ifstream exists(path);
+	rge::texture::ptr image = exists.good() ? rge::texture::load(path, false) : nullptr;
+	if(image == nullptr) return nullptr;
+
+	int width = image->get_width();
+	int height = image->get_height();
+	rge::color* texels = image->get_data();
+	for(int y = 0; y < height / 2; y++)
+		std::swap_ranges(texels + y * width, texels + (y + 1) * width, texels + (height - 1 - y) * width);
+
+	return image;
+}
+
+// Returns channel limited to [0, 1]. math::clamp is for integers.
+static float saturate(float v) {
+	return fminf(fmaxf(v, 0.0F), 1.0F);
+}
+
+// Difference of two colors as perceived, weighting the channels by luma,
+// from 0 to 255.
+static float perceived_difference(const rge::color& a, const rge::color& b) {
+	float r = fabsf(saturate(a.r) - saturate(b.r));
+	float g = fabsf(saturate(a.g) - saturate(b.g));
+	float bl = fabsf(saturate(a.b) - saturate(b.b));
+	return (0.299F * r + 0.587F * g + 0.114F * bl) * 255.0F;
+}
+
+// Returns the number of pixels past the tolerance. Fills the diff with the
+// golden, dimmed & gray, with the failing pixels in red. All textures are
+// linear & of the same size.
+static int compare(const rge::texture& output, const rge::texture& golden, float tolerance, rge::texture& diff, float& max_difference) {
+	const rge::color* o = output.get_data();
+	const rge::color* g = golden.get_data();
+	rge::color* d = diff.get_data();
+	int failed = 0;
+	max_difference = 0.0F;
+
+	for(int i = 0; i < output.get_width() * output.get_height(); i++) {
+		float difference = perceived_difference(o[i], g[i]);
+		max_difference = fmaxf(max_difference, difference);
+
+		if(difference > tolerance) {
+			d[i] = rge::color(1, 0, 0);
+			failed++;
+		} else {
+			float gray = (0.299F * g[i].r + 0.587F * g[i].g + 0.114F * g[i].b) * 0.3F;
+			d[i] = rge::color(gray, gray, gray);
+		}
+	}
+
+	return failed;
+}
+
+int main(int argc, char** argv) {
+	bool update = false;
+	int frames = 10;
+	float tolerance = 8.0F;
+	float percent = 0.1F;
+	std::string root = "../../examples";
+	std::string directory = "images";
+	std::vector<std::string> filter;
+
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if(arg == "-u") {
+			update = true;
+		} else if(arg == "-n" && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		} else if(arg == "-t" && i + 1 < argc) {
+			tolerance = (float)atof(argv[++i]);
+		} else if(arg == "-p" && i + 1 < argc) {
+			percent = (float)atof(argv[++i]);
+		} else if(arg == "-a" && i + 1 < argc) {
+			root = argv[++i];
+		} else if(arg == "-d" && i + 1 < argc) {
+			directory = argv[++i];
+		} else if(arg[0] != '-') {
+			filter.push_back(arg);
+		} else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	if(frames < 1 || tolerance < 0.0F || percent < 0.0F) {
+		print_usage();
+		return 1;
+	}
+
+	assets a;
+	if(!load_assets(root, a)) return 1;
+
+	rge::software_gl renderer;
+	if(renderer.init(nullptr) != rge::OK) return 1;
+
+	scene scenes[] = {
+		{ "2d_start",              render_2d,            0.0F, nullptr,            false },
+		{ "2d_orbit",              render_2d,            2.0F, nullptr,            false },
+		{ "2d_orbit_lazy_clear",   render_2d,            2.0F, lazy_clear,         false },
+		{ "3d_start",              render_3d,            0.0F, nullptr,            false },
+		{ "3d_turned",             render_3d,            1.5F, nullptr,            false },
+		{ "3d_turned_prepass",     render_3d,            1.5F, depth_prepass,      false },
+		{ "3d_turned_deferred",    render_3d,            1.5F, deferred_shading,   false },
+		{ "3d_materials",          render_3d_materials,  0.0F, nullptr,            false },
+		{ "3d_materials_prepass",  render_3d_materials,  0.0F, depth_prepass,      false },
+		{ "3d_materials_deferred", render_3d_materials,  0.0F, deferred_shading,   false },
+		{ "starship_menu",         render_starship_menu, 0.0F, nullptr,            false },
+		{ "starship_game",         render_starship_game, 0.0F, nullptr,            false },
+		{ "starship_virtual",      render_starship_game, 0.0F, virtual_resolution, true },
+		{ "starship_post",         render_starship_game, 0.0F, post_processes,     true }
+	};
+
+	// A window of the target's size, for the window scenes.
+	rge::window_resized_event resized;
+	resized.width = SCREEN_WIDTH;
+	resized.height = SCREEN_HEIGHT;
+	renderer.on_window_resized(resized);
+
+	rge::render_target::ptr target = rge::render_target::create(&renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+	rge::texture::ptr window = rge::texture::create(SCREEN_WIDTH, SCREEN_HEIGHT);
+	window->allocate();
+	std::vector<uint8_t> window_bytes(SCREEN_WIDTH * SCREEN_HEIGHT * 4);
+	rge::texture::ptr diff = rge::texture::create(SCREEN_WIDTH, SCREEN_HEIGHT);
+	diff->allocate();
+
+	int failures = 0;
+
+	rge::log::info("%dx%d target, %d frames per scene, tolerance %.1f, %.2f%% pixels allowed", SCREEN_WIDTH, SCREEN_HEIGHT, frames, tolerance, percent);
+	rge::log::info("%-21s %10s %10s %10s  %s", "scene", "frame ms", "failed %", "max diff", "result");
+
+	for(size_t i = 0; i < sizeof(scenes) / sizeof(scene); i++) {
+		const scene& s = scenes[i];
+		if(!filter.empty() && std::find(filter.begin(), filter.end(), s.name) == filter.end()) continue;
+
+		if(s.mode != nullptr) s.mode(renderer);
+		renderer.set_target(s.window ? nullptr : target);
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for(int frame = 0; frame < frames; frame++) {
+			s.render(renderer, a, s.time);
+			if(s.window) renderer.display();
+			else renderer.flush();
+		}
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		double frame_ms = elapsed.count() / frames;
+
+		renderer.set_target(nullptr);
+
+		// The window frame is scaled up to the window as it would be presented.
+		if(s.window) {
+			renderer.wait_for_present();
+			renderer.get_window_frame().dump_to_raw_buffer(window_bytes.data(), SCREEN_WIDTH, SCREEN_HEIGHT, rge::texture_filter::NEAREST);
+
+			rge::color* texels = window->get_data();
+			for(int p = 0; p < SCREEN_WIDTH * SCREEN_HEIGHT; p++) {
+				const uint8_t* b = &window_bytes[p * 4];
+				texels[p] = rge::color(b[0] / 255.0F, b[1] / 255.0F, b[2] / 255.0F, b[3] / 255.0F);
+			}
+		}
+
+		reset_modes(renderer);
+
+		const rge::texture& output = s.window ? *window : *target->get_frame_buffer();
+		std::string path = directory + "/" + s.name + ".png";
+
+		if(update) {
+			if(!write_png(output, path)) {
+				failures++;
+				continue;
+			}
+
+			rge::log::info("%-21s %10.2f %10s %10s  recorded", s.name, frame_ms, "-", "-");
+			continue;
+		}
+
+		rge::texture::ptr golden = load_png(path);
+
+		if(golden == nullptr) {
+			rge::log::info("%-21s %10.2f %10s %10s  FAILED, no golden, record with -u", s.name, frame_ms, "-", "-");
+			write_png(output, directory + "/" + s.name + "_out.png");
+			failures++;
+			continue;
+		}
+
+		if(golden->get_width() != output.get_width() || golden->get_height() != output.get_height()) {
+			rge::log::info("%-21s %10.2f %10s %10s  FAILED, golden is %dx%d", s.name, frame_ms, "-", "-", golden->get_width(), golden->get_height());
+			failures++;
+			continue;
+		}
+
+		float max_difference;
+		int failed = compare(output, *golden, tolerance, *diff, max_difference);
+		float failed_percent = 100.0F * failed / (SCREEN_WIDTH * SCREEN_HEIGHT);
+		bool passed = failed_percent <= percent;
+
+		rge::log::info("%-21s %10.2f %10.3f %10.1f  %s", s.name, frame_ms, failed_percent, max_difference, passed ? "ok" : "FAILED");
+
+		if(!passed) {
+			write_png(*diff, directory + "/" + s.name + "_diff.png");
+			write_png(output, directory + "/" + s.name + "_out.png");
+			failures++;
+		}
+	}
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,53 @@
+#define RGE_IMPL
+#include "rge.hpp"
+
+#include <iostream>
+
+static void print_usage() {
+	std::cout << "Usage: pak [-c] [-p <prefix>] <directory> <output.pak>" << std::endl;
+	std::cout << "       pak -l <archive.pak>" << std::endl;
+	std::cout << std::endl;
+	std::cout << "  -c  Compress entries with LZ4 (when smaller)." << std::endl;
+	std::cout << "  -p  Prefix prepended to every entry path (e.g. 'res')." << std::endl;
+	std::cout << "  -l  List the number of entries within an archive." << std::endl;
+}
+
+int main(int argc, char** argv) {
+	bool compress = false;
+	bool list = false;
+	std::string prefix;
+	std::vector<std::string> args;
+
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if(arg == "-c") {
+			compress = true;
+		} else if(arg == "-l") {
+			list = true;
+		} else if(arg == "-p" && i + 1 < argc) {
+			prefix = argv[++i];
+		} else {
+			args.push_back(arg);
+		}
+	}
+
+	if(list) {
+		if(args.size() != 1) {
+			print_usage();
+			return 1;
+		}
+
+		rge::pak::ptr archive = rge::pak::open(args[0]);
+		if(archive == nullptr) return 1;
+
+		rge::log::info("%s: %d entries", args[0].c_str(), archive->get_entry_count());
+		return 0;
+	}
+
+	if(args.size() != 2) {
+		print_usage();
+		return 1;
+	}
+
+	return rge::pak::build(args[0], args[1], compress, prefix) == rge::OK ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+#define RGE_IMPL
+#define RGE_USE_STB_IMAGE
+#include "rge.hpp"
+
+#include <iostream>
+#include <chrono>
+
+// Size of the render target drawn to.
+static const int SCREEN_WIDTH = 640;
+static const int SCREEN_HEIGHT = 360;
+
+static void print_usage() {
+	std::cout << "Usage: texbench [-n <frames>] [-s <size>] [texture.png|bmp|rtex]" << std::endl;
+	std::cout << std::endl;
+	std::cout << "  -n  Frames rendered per test (default: 60)." << std::endl;
+	std::cout << "  -s  Size of the generated test texture, if none is given (default: 1024)." << std::endl;
+}
+
+// Fills a texture with a colored checker board, so there is real data to fetch.
+static rge::texture::ptr generate_texture(int size) {
+	rge::texture::ptr texture = rge::texture::create(size, size);
+	texture->allocate();
+
+	rge::color* data = texture->get_data();
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			bool check = ((x / 16) + (y / 16)) % 2 == 0;
+			data[x + y * size] = check ? rge::color(x / (float)size, y / (float)size, 0.5F) : rge::color(0.1F, 0.1F, 0.1F);
+		}
+	}
+
+	return texture;
+}
+
+// Floor below the camera, from just in front of it to far away. Triangles
+// past the screen edge are dropped, so its corners stay on screen.
+static rge::mesh::ptr load_floor() {
+	rge::mesh::ptr mdl = rge::mesh::create();
+
+	mdl->vertices.push_back(rge::vec3(-0.6F, -1, 2));
+	mdl->vertices.push_back(rge::vec3(0.6F, -1, 2));
+	mdl->vertices.push_back(rge::vec3(9, -1, 30));
+	mdl->vertices.push_back(rge::vec3(-9, -1, 30));
+
+	for(int i = 0; i < 4; i++) {
+		mdl->normals.push_back(rge::vec3(0, 1, 0));
+		mdl->uvs.push_back(rge::vec2());
+	}
+
+	mdl->triangles.push_back(0);
+	mdl->triangles.push_back(1);
+	mdl->triangles.push_back(3);
+	mdl->triangles.push_back(2);
+	mdl->triangles.push_back(3);
+	mdl->triangles.push_back(1);
+
+	return mdl;
+}
+
+// Everything a test draws.
+struct scene {
+	rge::camera::ptr ortho_camera;
+	rge::camera::ptr perspective_camera;
+	rge::sprite::ptr sprite;
+	rge::mesh::ptr floor;
+	rge::material::ptr floor_material;
+};
+
+// Sprite covering the screen, rotated a little more every frame.
+static void render_rotated_sprite(rge::renderer& renderer, const scene& s, int frame) {
+	s.sprite->transform->rotation = rge::quaternion::yaw_pitch_roll(0, 0, frame * 0.05F);
+
+	renderer.set_camera(s.ortho_camera);
+	renderer.clear(rge::color(0.0F, 0.0F, 0.0F));
+	renderer.draw(*s.sprite);
+}
+
+// Perspective floor, its texture turning every frame as if the camera did.
+static void render_floor(rge::renderer& renderer, const scene& s, int frame) {
+	float angle = frame * 0.02F;
+	float c = cosf(angle);
+	float si = sinf(angle);
+
+	// One texture repeat every 2 units.
+	for(size_t i = 0; i < s.floor->vertices.size(); i++) {
+		const rge::vec3& v = s.floor->vertices[i];
+		s.floor->uvs[i] = rge::vec2(v.x * c - v.z * si, v.x * si + v.z * c) * 0.5F;
+	}
+
+	renderer.set_camera(s.perspective_camera);
+	renderer.clear(rge::color(0.0F, 0.0F, 0.0F));
+	renderer.draw(rge::mat4::identity(), *s.floor, *s.floor_material);
+}
+
+typedef void (*render_func)(rge::renderer&, const scene&, int);
+
+// Returns average frame time in milliseconds.
+static double run(rge::software_gl& renderer, const scene& s, render_func render, int frames) {
+	// One frame untimed, so both layouts start from the same warm state.
+	render(renderer, s, 0);
+	renderer.flush();
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for(int frame = 0; frame < frames; frame++) {
+		render(renderer, s, frame);
+		renderer.flush();
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	return elapsed.count() / frames;
+}
+
+int main(int argc, char** argv) {
+	int frames = 60;
+	int size = 1024;
+	std::string path;
+
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if(arg == "-n" && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		} else if(arg == "-s" && i + 1 < argc) {
+			size = atoi(argv[++i]);
+		} else if(arg[0] != '-' && path.empty()) {
+			path = arg;
+		} else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	if(frames < 1 || size < 1) {
+		print_usage();
+		return 1;
+	}
+
+	rge::texture::ptr texture = path.empty() ? generate_texture(size) : rge::texture::load(path, false);
+	if(texture == nullptr) return 1;
+
+	texture->generate_mipmaps();
+
+	rge::software_gl renderer;
+	if(renderer.init(nullptr) != rge::OK) return 1;
+
+	rge::render_target::ptr target = rge::render_target::create(&renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+	renderer.set_target(target);
+
+	float aspect = (float)SCREEN_WIDTH / SCREEN_HEIGHT;
+
+	scene s;
+	s.ortho_camera = rge::camera::create();
+	s.ortho_camera->set_orthographic(-8 * aspect / 2, 8 * aspect / 2, 4, -4, 0.0F, 100.0F);
+	s.ortho_camera->transform->position = rge::vec3(0, 0, -1);
+
+	s.perspective_camera = rge::camera::create();
+	s.perspective_camera->set_perspective(60, aspect, 0.1F, 1000.0F);
+
+	// Roughly one texel per pixel, large enough to cover the screen at any angle.
+	s.sprite = rge::sprite::create(texture);
+	s.sprite->centered = true;
+	s.sprite->pixels_per_unit = SCREEN_HEIGHT / 8;
+
+	s.floor = load_floor();
+	s.floor_material = rge::material::create();
+	s.floor_material->texture = texture;
+	s.floor_material->shading = rge::shading_model::UNLIT;
+
+	struct test {
+		const char* name;
+		render_func render;
+		rge::texture_filter filter;
+	};
+
+	test tests[] = {
+		{ "sprite nearest",  render_rotated_sprite, rge::texture_filter::NEAREST },
+		{ "sprite bilinear", render_rotated_sprite, rge::texture_filter::BILINEAR },
+		{ "floor nearest",   render_floor,          rge::texture_filter::NEAREST },
+		{ "floor bilinear",  render_floor,          rge::texture_filter::BILINEAR },
+		{ "floor trilinear", render_floor,          rge::texture_filter::TRILINEAR }
+	};
+
+	rge::log::info("%dx%d texture, %dx%d target, %d frames per test", texture->get_width(), texture->get_height(), SCREEN_WIDTH, SCREEN_HEIGHT, frames);
+	rge::log::info("%-16s %10s %10s %8s", "test", "linear ms", "tiled ms", "speedup");
+
+	for(size_t i = 0; i < sizeof(tests) / sizeof(test); i++) {
+		texture->filter = tests[i].filter;
+
+		texture->set_layout(rge::texture_layout::LINEAR);
+		double linear = run(renderer, s, tests[i].render, frames);
+
+		texture->set_layout(rge::texture_layout::TILED);
+		double tiled = run(renderer, s, tests[i].render, frames);
+
+		rge::log::info("%-16s %10.2f %10.2f %7.2fx", tests[i].name, linear, tiled, linear / tiled);
+	}
+
+	renderer.set_target(nullptr);
+
+	return 0;
+}
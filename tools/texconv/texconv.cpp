@@ -0,0 +1,64 @@
+#define RGE_IMPL
+#define RGE_USE_STB_IMAGE
+#include "rge.hpp"
+
+#include <iostream>
+
+static void print_usage() {
+	std::cout << "Usage: texconv [-f nearest|bilinear] [-l linear|tiled] <input.png|bmp> <output.rtex>" << std::endl;
+	std::cout << std::endl;
+	std::cout << "  -f  Filter mode stored with the texture (default: nearest)." << std::endl;
+	std::cout << "  -l  Texel layout stored with the texture (default: linear)." << std::endl;
+}
+
+int main(int argc, char** argv) {
+	rge::texture_filter filter = rge::texture_filter::NEAREST;
+	rge::texture_layout layout = rge::texture_layout::LINEAR;
+	std::vector<std::string> args;
+
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if(arg == "-f" && i + 1 < argc) {
+			std::string mode = argv[++i];
+			if(mode == "nearest") {
+				filter = rge::texture_filter::NEAREST;
+			} else if(mode == "bilinear") {
+				filter = rge::texture_filter::BILINEAR;
+			} else {
+				print_usage();
+				return 1;
+			}
+		} else if(arg == "-l" && i + 1 < argc) {
+			std::string mode = argv[++i];
+			if(mode == "linear") {
+				layout = rge::texture_layout::LINEAR;
+			} else if(mode == "tiled") {
+				layout = rge::texture_layout::TILED;
+			} else {
+				print_usage();
+				return 1;
+			}
+		} else {
+			args.push_back(arg);
+		}
+	}
+
+	if(args.size() != 2) {
+		print_usage();
+		return 1;
+	}
+
+	rge::texture::ptr texture = rge::texture::load(args[0], false);
+	if(texture == nullptr) return 1;
+
+	texture->filter = filter;
+	texture->set_layout(layout);
+
+	if(texture->write_baked_to_disk(args[1]) != rge::OK) {
+		rge::log::error("Could not write baked texture: %s", args[1].c_str());
+		return 1;
+	}
+
+	rge::log::info("Baked %s (%dx%d) into %s", args[0].c_str(), texture->get_width(), texture->get_height(), args[1].c_str());
+	return 0;
+}